@@ -134,6 +134,210 @@ bool FSerializer::OpenWriter(bool pretty)
 	return true;
 }
 
+//==========================================================================
+//
+// Same as OpenWriter but produces the binary format, which is a lot
+// faster to write and read back but cannot be inspected as text.
+//
+//==========================================================================
+
+bool FSerializer::OpenBinaryWriter()
+{
+	if (w != nullptr || r != nullptr) return false;
+
+	mErrors = 0;
+	w = new FWriter(false, true);
+	BeginObject(nullptr);
+	return true;
+}
+
+//==========================================================================
+//
+// FBinaryWriter :: Finish
+//
+//==========================================================================
+
+void FBinaryWriter::Finish()
+{
+	if (mFinished) return;
+	Put32(8, mData.Size());
+	VarUint(mStrings.Size());
+	for (auto &str : mStrings)
+	{
+		VarUint(str.Len());
+		unsigned pos = mData.Reserve(unsigned(str.Len() + 1));
+		memcpy(&mData[pos], str.GetChars(), str.Len() + 1);
+	}
+	mData.Push(0);
+	mFinished = true;
+}
+
+//==========================================================================
+//
+// ReadBinarySave
+//
+// Builds the value tree directly from the binary data. The strings are not
+// copied. The values point into the string table, so the storage must live
+// as long as the document.
+//
+//==========================================================================
+
+struct FBinaryReader
+{
+	struct FStringEntry
+	{
+		const char *Chars;
+		rapidjson::SizeType Length;
+	};
+
+	const uint8_t *mPos;
+	const uint8_t *mEnd;
+	TArray<FStringEntry> mStrings;
+	rapidjson::Document::AllocatorType *mAlloc;
+	int mDepth = 0;
+
+	bool VarUint(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (mPos >= mEnd) return false;
+			uint8_t b = *mPos++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	rapidjson::GenericStringRef<char> GetString(uint64_t index)
+	{
+		return rapidjson::StringRef(mStrings[index].Chars, mStrings[index].Length);
+	}
+
+	bool ReadValue(rapidjson::Value &v)
+	{
+		uint64_t u;
+
+		if (mPos >= mEnd || ++mDepth > 1000) return false;
+		switch (*mPos++)
+		{
+		case BT_Null:
+			v.SetNull();
+			break;
+
+		case BT_False:
+		case BT_True:
+			v.SetBool(mPos[-1] == BT_True);
+			break;
+
+		case BT_Int:
+			if (!VarUint(u)) return false;
+			v.SetInt64(int64_t(u >> 1) ^ -int64_t(u & 1));
+			break;
+
+		case BT_Uint:
+			if (!VarUint(u)) return false;
+			v.SetUint64(u);
+			break;
+
+		case BT_Double:
+		{
+			if (mEnd - mPos < 8) return false;
+			uint64_t bits = 0;
+			double d;
+			for (int i = 0; i < 8; i++) bits |= uint64_t(mPos[i]) << (i * 8);
+			memcpy(&d, &bits, 8);
+			mPos += 8;
+			v.SetDouble(d);
+			break;
+		}
+
+		case BT_String:
+			if (!VarUint(u) || u >= mStrings.Size()) return false;
+			v.SetString(GetString(u));
+			break;
+
+		case BT_Object:
+			v.SetObject();
+			for (;;)
+			{
+				if (!VarUint(u)) return false;
+				if (u == 0) break;
+				if (u > mStrings.Size()) return false;
+				rapidjson::Value key(GetString(u - 1));
+				rapidjson::Value member;
+				if (!ReadValue(member)) return false;
+				v.AddMember(key, member, *mAlloc);
+			}
+			break;
+
+		case BT_Array:
+			v.SetArray();
+			for (;;)
+			{
+				if (mPos >= mEnd) return false;
+				if (*mPos == BT_End)
+				{
+					mPos++;
+					break;
+				}
+				rapidjson::Value element;
+				if (!ReadValue(element)) return false;
+				v.PushBack(element, *mAlloc);
+			}
+			break;
+
+		default:
+			return false;
+		}
+		mDepth--;
+		return true;
+	}
+};
+
+bool ReadBinarySave(rapidjson::Document &doc, TArray<char> &storage, const char *buffer, size_t length)
+{
+	storage.Resize((unsigned)length);
+	memcpy(storage.Data(), buffer, length);
+	doc.SetObject();
+
+	auto data = (const uint8_t *)storage.Data();
+	auto get32 = [=](unsigned pos) { return data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (uint32_t(data[pos + 3]) << 24); };
+	uint32_t version = get32(4);
+	uint32_t tablepos = get32(8);
+	if (version != BINARYSAVE_VERSION || tablepos < BINARYSAVE_HEADERSIZE || tablepos >= length)
+	{
+		return false;
+	}
+
+	FBinaryReader reader;
+	reader.mAlloc = &doc.GetAllocator();
+
+	// Read the string table first. Its strings are 0-terminated in the buffer, so they can be referenced as they are.
+	uint64_t count, len;
+	reader.mPos = data + tablepos;
+	reader.mEnd = data + length;
+	if (!reader.VarUint(count) || count > length) return false;
+	reader.mStrings.Resize((unsigned)count);
+	for (auto &str : reader.mStrings)
+	{
+		if (!reader.VarUint(len) || len >= uint64_t(reader.mEnd - reader.mPos) || reader.mPos[len] != 0) return false;
+		str.Chars = (const char *)reader.mPos;
+		str.Length = (rapidjson::SizeType)len;
+		reader.mPos += len + 1;
+	}
+
+	reader.mPos = data + BINARYSAVE_HEADERSIZE;
+	reader.mEnd = data + tablepos;
+	rapidjson::Value root;
+	if (!reader.ReadValue(root) || !root.IsObject())
+	{
+		return false;
+	}
+	static_cast<rapidjson::Value &>(doc) = root;
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -146,6 +350,12 @@ bool FSerializer::OpenReader(const char *buffer, size_t length)
 
 	mErrors = 0;
 	r = new FReader(buffer, length);
+	if (!r->mValid)
+	{
+		delete r;
+		r = nullptr;
+		return false;
+	}
 	return true;
 }
 
@@ -171,6 +381,12 @@ bool FSerializer::OpenReader(FCompressedBuffer *input)
 		input->Decompress(unpacked.Data());
 		r = new FReader(unpacked.Data(), input->mSize);
 	}
+	if (!r->mValid)
+	{
+		delete r;
+		r = nullptr;
+		return false;
+	}
 	return true;
 }
 
@@ -732,11 +948,13 @@ const char *FSerializer::GetOutput(unsigned *len)
 	if (isReading()) return nullptr;
 	WriteObjects();
 	EndObject();
+	size_t size;
+	auto output = w->GetOutput(size);
 	if (len != nullptr)
 	{
-		*len = (unsigned)w->mOutString.GetSize();
+		*len = (unsigned)size;
 	}
-	return w->mOutString.GetString();
+	return output;
 }
 
 //==========================================================================
@@ -751,16 +969,18 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	FCompressedBuffer buff;
 	WriteObjects();
 	EndObject();
+	size_t size;
+	auto output = w->GetOutput(size);
 	buff.filename = nullptr;
-	buff.mSize = (unsigned)w->mOutString.GetSize();
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
+	buff.mSize = (unsigned)size;
+	buff.mCRC32 = crc32(0, (const Bytef*)output, buff.mSize);
 
 	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
 
 	z_stream stream;
 	int err;
 
-	stream.next_in = (Bytef *)w->mOutString.GetString();
+	stream.next_in = (Bytef *)output;
 	stream.avail_in = (unsigned)buff.mSize;
 	stream.next_out = (Bytef*)compressbuf;
 	stream.avail_out = (unsigned)buff.mSize;
@@ -769,7 +989,8 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	stream.opaque = (voidpf)0;
 
 	// create output in zip-compatible form as required by FCompressedBuffer
-	err = deflateInit2(&stream, 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
+	// The binary format has little redundancy left, so it gets the fastest compression level.
+	err = deflateInit2(&stream, w->mBinary ? Z_BEST_SPEED : 8, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY);
 	if (err != Z_OK)
 	{
 		goto error;
@@ -794,7 +1015,7 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	}
 
 error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
+	memcpy(compressbuf, output, buff.mSize + 1);
 	buff.mCompressedSize = buff.mSize;
 	buff.mMethod = METHOD_STORED;
 	return buff;
@@ -85,6 +85,7 @@ public:
 	}
 	void SetUniqueSoundNames() { soundNamesAreUnique = true; }
 	bool OpenWriter(bool pretty = true);
+	bool OpenBinaryWriter();
 	bool OpenReader(const char *buffer, size_t length);
 	bool OpenReader(FileSys::FCompressedBuffer *input);
 	void Close();
@@ -25,6 +25,126 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Binary savegame format. It has the same structure as the JSON output, but
+// all keys and string values go through a string table, and numbers are stored
+// as tagged varints or raw doubles.
+//
+// header:	"GZSB", uint32 version, uint32 offset of the string table
+// value:	tag byte followed by the tag's payload
+// object:	(varint key string + 1, value)*, terminated by a 0 varint
+// array:	value*, terminated by a BT_End tag
+// strings:	varint count, then for each string its varint length and the
+//			characters including the terminating 0
+//
+//==========================================================================
+
+enum EBinaryTag : uint8_t
+{
+	BT_Null,
+	BT_False,
+	BT_True,
+	BT_Int,			// zigzag varint
+	BT_Uint,		// varint
+	BT_Double,		// 8 bytes, little endian
+	BT_String,		// varint string index
+	BT_Object,
+	BT_Array,
+	BT_End,
+};
+
+enum
+{
+	BINARYSAVE_VERSION = 1,
+	BINARYSAVE_HEADERSIZE = 12,
+};
+
+struct FBinaryWriter
+{
+	TArray<uint8_t> mData;
+	TArray<FString> mStrings;
+	TMap<FString, unsigned> mStringMap;
+	bool mFinished = false;
+
+	FBinaryWriter()
+	{
+		mData.Resize(BINARYSAVE_HEADERSIZE);
+		memcpy(mData.Data(), "GZSB", 4);
+		Put32(4, BINARYSAVE_VERSION);
+		Put32(8, 0);
+	}
+
+	void Put32(unsigned pos, uint32_t v)
+	{
+		for (int i = 0; i < 4; i++) mData[pos + i] = uint8_t(v >> (i * 8));
+	}
+
+	void Tag(EBinaryTag tag)
+	{
+		mData.Push(tag);
+	}
+
+	void VarUint(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mData.Push(uint8_t(v | 0x80));
+			v >>= 7;
+		}
+		mData.Push(uint8_t(v));
+	}
+
+	unsigned StringIndex(const char *k)
+	{
+		FString str = k;
+		unsigned *pindex = mStringMap.CheckKey(str);
+		if (pindex != nullptr) return *pindex;
+		unsigned index = mStrings.Push(str);
+		mStringMap.Insert(str, index);
+		return index;
+	}
+
+	void StartObject() { Tag(BT_Object); }
+	void EndObject() { VarUint(0); }
+	void StartArray() { Tag(BT_Array); }
+	void EndArray() { Tag(BT_End); }
+	void Key(const char *k) { VarUint(StringIndex(k) + 1ull); }
+	void Null() { Tag(BT_Null); }
+	void Bool(bool k) { Tag(k ? BT_True : BT_False); }
+
+	void String(const char *k)
+	{
+		Tag(BT_String);
+		VarUint(StringIndex(k));
+	}
+
+	void Int64(int64_t k)
+	{
+		Tag(BT_Int);
+		VarUint((uint64_t(k) << 1) ^ uint64_t(k >> 63));
+	}
+
+	void Uint64(uint64_t k)
+	{
+		Tag(BT_Uint);
+		VarUint(k);
+	}
+
+	void Double(double k)
+	{
+		uint64_t bits;
+		memcpy(&bits, &k, 8);
+		Tag(BT_Double);
+		for (int i = 0; i < 8; i++) mData.Push(uint8_t(bits >> (i * 8)));
+	}
+
+	// Appends the string table. The data is followed by a 0 byte that does not count toward its size.
+	void Finish();
+};
+
+bool ReadBinarySave(rapidjson::Document &doc, TArray<char> &storage, const char *buffer, size_t length);
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -39,21 +159,26 @@ struct FWriter
 
 	Writer *mWriter1;
 	PrettyWriter *mWriter2;
+	FBinaryWriter *mBinary = nullptr;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
 
-	FWriter(bool pretty)
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		mWriter1 = nullptr;
+		mWriter2 = nullptr;
+		if (binary)
+		{
+			mBinary = new FBinaryWriter;
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
-			mWriter2 = nullptr;
 		}
 		else
 		{
-			mWriter1 = nullptr;
 			mWriter2 = new PrettyWriter(mOutString);
 		}
 	}
@@ -62,6 +187,19 @@ struct FWriter
 	{
 		if (mWriter1) delete mWriter1;
 		if (mWriter2) delete mWriter2;
+		if (mBinary) delete mBinary;
+	}
+
+	const char *GetOutput(size_t &len)
+	{
+		if (mBinary)
+		{
+			mBinary->Finish();
+			len = mBinary->mData.Size() - 1;
+			return (const char *)mBinary->mData.Data();
+		}
+		len = mOutString.GetSize();
+		return mOutString.GetString();
 	}
 
 
@@ -74,36 +212,42 @@ struct FWriter
 	{
 		if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
+		else if (mBinary) mBinary->StartObject();
 	}
 
 	void EndObject()
 	{
 		if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
+		else if (mBinary) mBinary->EndObject();
 	}
 
 	void StartArray()
 	{
 		if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
+		else if (mBinary) mBinary->StartArray();
 	}
 
 	void EndArray()
 	{
 		if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
+		else if (mBinary) mBinary->EndArray();
 	}
 
 	void Key(const char *k)
 	{
 		if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
+		else if (mBinary) mBinary->Key(k);
 	}
 
 	void Null()
 	{
 		if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
+		else if (mBinary) mBinary->Null();
 	}
 
 	void StringU(const char *k, bool encode)
@@ -111,6 +255,7 @@ struct FWriter
 		if (encode) k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mBinary) mBinary->String(k);
 	}
 
 	void String(const char *k)
@@ -118,6 +263,7 @@ struct FWriter
 		k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mBinary) mBinary->String(k);
 	}
 
 	void String(const char *k, int size)
@@ -125,36 +271,42 @@ struct FWriter
 		k = StringToUnicode(k, size);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mBinary) mBinary->String(k);
 	}
 
 	void Bool(bool k)
 	{
 		if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
+		else if (mBinary) mBinary->Bool(k);
 	}
 
 	void Int(int32_t k)
 	{
 		if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
+		else if (mBinary) mBinary->Int64(k);
 	}
 
 	void Int64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
+		else if (mBinary) mBinary->Int64(k);
 	}
 
 	void Uint(uint32_t k)
 	{
 		if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
+		else if (mBinary) mBinary->Uint64(k);
 	}
 
 	void Uint64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
+		else if (mBinary) mBinary->Uint64(k);
 	}
 
 	void Double(double k)
@@ -167,6 +319,10 @@ struct FWriter
 		{
 			mWriter2->Double(k);
 		}
+		else if (mBinary)
+		{
+			mBinary->Double(k);
+		}
 	}
 
 };
@@ -183,11 +339,20 @@ struct FReader
 	rapidjson::Document mDoc;
 	TArray<DObject *> mDObjects;
 	rapidjson::Value *mKeyValue = nullptr;
+	TArray<char> mBinaryData;	// the document's strings point into this
 	bool mObjectsRead = false;
+	bool mValid = true;
 
 	FReader(const char *buffer, size_t length)
 	{
-		mDoc.Parse(buffer, length);
+		if (length >= BINARYSAVE_HEADERSIZE && !memcmp(buffer, "GZSB", 4))
+		{
+			mValid = ReadBinarySave(mDoc, mBinaryData, buffer, length);
+		}
+		else
+		{
+			mDoc.Parse(buffer, length);
+		}
 		mObjects.Push(FJSONObject(&mDoc));
 	}
 
@@ -42,6 +42,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <functional>
+#include <memory>
 #include <vector>
 #include "fs_swap.h"
 
@@ -74,11 +75,13 @@ public:
 class FileReader;
 
 // an opaque memory buffer to the file's content. Can either own the memory or just point to an external buffer.
+// A non-owning view may hold a reference to the object that keeps the external buffer alive (e.g. a file mapping).
 class FileData
 {
 	void* memory;
 	size_t length;
 	bool owned;
+	std::shared_ptr<const void> keepalive;
 
 public:
 	using value_type = uint8_t;
@@ -99,6 +102,11 @@ public:
 			owned = false;
 		}
 	}
+	FileData(const void* memory_, size_t len, std::shared_ptr<const void> owner)
+		: FileData(memory_, len, false)
+	{
+		keepalive = std::move(owner);
+	}
 	uint8_t* writable() const { return owned? (uint8_t*)memory : nullptr; }
 	const void* data() const { return memory; }
 	size_t size() const { return length; }
@@ -107,6 +115,7 @@ public:
 
 	FileData& operator = (const FileData& copy)
 	{
+		if (this == &copy) return *this;
 		if (owned && memory) free(memory);
 		length = copy.length;
 		owned = copy.owned;
@@ -114,8 +123,13 @@ public:
 		{
 			memory = malloc(length);
 			memcpy(memory, copy.memory, length);
+			keepalive.reset();
+		}
+		else
+		{
+			memory = copy.memory;
+			keepalive = copy.keepalive;
 		}
-		else memory = copy.memory;
 		return *this;
 	}
 
@@ -125,6 +139,7 @@ public:
 		length = copy.length;
 		owned = copy.owned;
 		memory = copy.memory;
+		keepalive = std::move(copy.keepalive);
 		copy.memory = nullptr;
 		copy.length = 0;
 		copy.owned = true;
@@ -134,6 +149,7 @@ public:
 	FileData(const FileData& copy)
 	{
 		memory = nullptr;
+		owned = true;
 		*this = copy;
 	}
 
@@ -147,6 +163,7 @@ public:
 		if (!owned) memory = nullptr;
 		length = len;
 		owned = true;
+		keepalive.reset();
 		memory = realloc(memory, length);
 		return memory;
 	}
@@ -156,6 +173,7 @@ public:
 		memory = (void*)mem;
 		length = len;
 		owned = false;
+		keepalive.reset();
 	}
 
 	void clear()
@@ -164,6 +182,7 @@ public:
 		memory = nullptr;
 		length = 0;
 		owned = true;
+		keepalive.reset();
 	}
 
 };
@@ -179,6 +198,8 @@ public:
 	virtual ptrdiff_t Read (void *buffer, ptrdiff_t len) = 0;
 	virtual char *Gets(char *strbuf, ptrdiff_t len) = 0;
 	virtual const char *GetBuffer() const { return nullptr; }
+	// the object keeping GetBuffer's memory alive, if it can outlive the reader (e.g. a file mapping)
+	virtual std::shared_ptr<const void> GetBufferOwner() const { return nullptr; }
 	ptrdiff_t GetLength () const { return Length; }
 };
 
@@ -247,8 +268,9 @@ public:
 	}
 
 	bool OpenFile(const char *filename, Size start = 0, Size length = -1, bool buffered = false);
+	bool OpenMappedFile(const char *filename);	// maps the entire file into memory. Fails on empty files or if the system cannot map it.
 	bool OpenFilePart(FileReader &parent, Size start, Size length);
-	bool OpenMemory(const void *mem, Size length);	// read directly from the buffer
+	bool OpenMemory(const void *mem, Size length, std::shared_ptr<const void> owner = nullptr);	// read directly from the buffer
 	bool OpenMemoryArray(FileData& data);	// take the given array
 
 	Size Tell() const
@@ -285,6 +307,11 @@ public:
 		return mReader->GetBuffer();
 	}
 
+	std::shared_ptr<const void> GetBufferOwner() const
+	{
+		return mReader->GetBufferOwner();
+	}
+
 	Size GetLength() const
 	{
 		return mReader->GetLength();
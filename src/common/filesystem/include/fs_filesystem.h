@@ -22,6 +22,12 @@ union LumpShortName
 };
 
 
+// Runs the given function on some worker thread.
+using FileSystemTaskFunc = std::function<void(std::function<void()>)>;
+
+class PrefetchCache;
+class DirectoryCache;
+
 struct FolderEntry
 {
 	const char *name;
@@ -41,6 +47,18 @@ public:
 	int GetMaxIwadNum() { return MaxIwadIndex; }
 	void SetMaxIwadNum(int x) { MaxIwadIndex = x; }
 
+	// Map resource files into memory instead of reading them through stdio.
+	// Uncompressed lumps are then returned as views into the mapping without being copied.
+	void SetMapFiles(bool on) { MapFiles = on; }
+
+	// Keep the parsed archive directories and the hash chains in the given file to speed up the next start with the same files.
+	// The tag identifies the program version. Caches written by a different one are discarded.
+	void SetDirectoryCache(const char* cachefile, const char* tag)
+	{
+		DirCacheFile = cachefile ? cachefile : "";
+		DirCacheTag = tag ? tag : "";
+	}
+
 	bool InitSingleFile(const char *filename, FileSystemMessageFunc Printf = nullptr);
 	bool InitMultipleFiles (std::vector<std::string>& filenames, LumpFilterInfo* filter = nullptr, FileSystemMessageFunc Printf = nullptr, bool allowduplicates = false, FILE* hashfile = nullptr);
 	void AddFile (const char *filename, FileReader *wadinfo, LumpFilterInfo* filter, FileSystemMessageFunc Printf, FILE* hashfile);
@@ -93,6 +111,11 @@ public:
 	FileData ReadFile (const char *name) { return ReadFile (GetNumForName (name)); }
 	FileData ReadFileFullName(const char* name) { return ReadFile(GetNumForFullName(name)); }
 
+	// Decompresses the given lumps ahead of time through runtask. Up to maxbytes of data are kept until ReadFile
+	// or OpenFileReader asks for them. Lumps that can be read without decompression are not queued.
+	void PrefetchFiles(const std::vector<int>& lumps, FileSystemTaskFunc runtask, size_t maxbytes);
+	void EndPrefetch();	// discards everything that has not been picked up yet.
+
 	FileReader OpenFileReader(int lump, int readertype, int readerflags);		// opens a reader that redirects to the containing file's one.
 	FileReader OpenFileReader(const char* name);
 	FileReader ReopenFileReader(const char* name, bool alwayscache = false);
@@ -171,6 +194,10 @@ protected:
 
 	int IwadIndex = -1;
 	int MaxIwadIndex = -1;
+	bool MapFiles = false;
+	PrefetchCache* Prefetch = nullptr;
+	DirectoryCache* DirCache = nullptr;	// only exists during InitMultipleFiles
+	std::string DirCacheFile, DirCacheTag;
 
 	StringPool* stringpool = nullptr;
 
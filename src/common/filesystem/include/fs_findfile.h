@@ -24,6 +24,8 @@ using FileList = std::vector<FileListEntry>;
 struct FCompressedBuffer;
 bool ScanDirectory(std::vector<FileListEntry>& list, const char* dirpath, const char* match, bool nosubdir = false, bool readhidden = false);
 bool FS_DirEntryExists(const char* pathname, bool* isdir);
+bool FS_GetFileStamp(const char* pathname, uint64_t* size, int64_t* mtime);
+bool FS_ReplaceFile(const char* from, const char* to);
 
 inline void FixPathSeparator(char* path)
 {
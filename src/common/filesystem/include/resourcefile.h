@@ -112,6 +112,8 @@ void SetMainThread();
 
 class FResourceFile
 {
+	friend class DirectoryCache;
+
 public:
 	FResourceFile(const char* filename, StringPool* sp);
 	FResourceFile(const char* filename, FileReader& r, StringPool* sp);
@@ -124,7 +126,7 @@ protected:
 	const char* FileName;
 	FResourceEntry* Entries = nullptr;
 	uint32_t NumLumps;
-	char Hash[48];
+	char Hash[48] = {};
 	StringPool* stringpool;
 
 	// for archives that can contain directories
@@ -168,6 +170,9 @@ public:
 		return (entry < NumLumps) ? Entries[entry].Position : 0;
 	}
 
+	// Archives whose entire state is in the entry list can be restored from the directory cache.
+	virtual bool CanCacheDirectory() const { return false; }
+
 	// default is the safest reader type.
 	virtual FileReader GetEntryReader(uint32_t entry, int readertype = READER_NEW, int flags = READERFLAG_SEEKABLE);
 
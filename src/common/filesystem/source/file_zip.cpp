@@ -114,6 +114,7 @@ public:
 	FZipFile(const char* filename, FileReader& file, StringPool* sp);
 	bool Open(LumpFilterInfo* filter, FileSystemMessageFunc Printf);
 	FCompressedBuffer GetRawData(uint32_t entry) override;
+	bool CanCacheDirectory() const override { return true; }
 };
 
 //==========================================================================
@@ -394,5 +395,15 @@ FResourceFile *CheckZip(const char *filename, FileReader &file, LumpFilterInfo*
 	return NULL;
 }
 
+//==========================================================================
+//
+// Creates an empty Zip whose directory gets filled in by the directory cache
+//
+//==========================================================================
+
+FResourceFile *CreateZipFile(const char *filename, FileReader &file, StringPool* sp)
+{
+	return new FZipFile(filename, file, sp);
+}
 
 }
@@ -40,6 +40,19 @@
 #include <string.h>
 #include "files_internal.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace FileSys {
 	
 #ifdef _WIN32
@@ -171,6 +184,68 @@ private:
 	}
 };
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into the address space. The mapping is shared with
+// all FileData views and memory readers created from this reader's buffer,
+// so they remain valid after the reader itself has been closed.
+// The pages are mapped copy-on-write so that code which patches lump data
+// in place only ever touches a private copy and never the file itself.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+public:
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		auto widename = toWide(filename);
+		HANDLE file = CreateFileW(widename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > (uint64_t)PTRDIFF_MAX)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr) return false;
+
+		void *view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+		CloseHandle(mapping);	// the view keeps the mapping object alive.
+		if (view == nullptr) return false;
+
+		owner = std::shared_ptr<const void>(view, [](const void *p) { UnmapViewOfFile(p); });
+		Length = (ptrdiff_t)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || (uint64_t)info.st_size > (uint64_t)PTRDIFF_MAX)
+		{
+			close(fd);
+			return false;
+		}
+		size_t size = (size_t)info.st_size;
+		void *view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);	// the mapping stays valid after the descriptor is closed.
+		if (view == MAP_FAILED) return false;
+
+		owner = std::shared_ptr<const void>(view, [size](const void *p) { munmap((void*)p, size); });
+		Length = (ptrdiff_t)size;
+#endif
+		bufptr = (const char *)owner.get();
+		FilePos = 0;
+		return true;
+	}
+};
+
 //==========================================================================
 //
 // FileReaderRedirect
@@ -380,6 +455,19 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenMappedFile(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		delete reader;
+		return false;
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, start, length);
@@ -388,10 +476,10 @@ bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileRe
 	return true;
 }
 
-bool FileReader::OpenMemory(const void *mem, FileReader::Size length)
+bool FileReader::OpenMemory(const void *mem, FileReader::Size length, std::shared_ptr<const void> owner)
 {
 	Close();
-	mReader = new MemoryReader((const char *)mem, length);
+	mReader = new MemoryReader((const char *)mem, length, std::move(owner));
 	return true;
 }
 
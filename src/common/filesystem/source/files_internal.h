@@ -10,12 +10,14 @@ class MemoryReader : public FileReaderInterface
 protected:
 	const char * bufptr = nullptr;
 	ptrdiff_t FilePos = 0;
+	std::shared_ptr<const void> owner;
 
 	MemoryReader()
 	{}
 
 public:
-	MemoryReader(const char *buffer, ptrdiff_t length)
+	MemoryReader(const char *buffer, ptrdiff_t length, std::shared_ptr<const void> owner_ = nullptr)
+		: owner(std::move(owner_))
 	{
 		bufptr = buffer;
 		Length = length;
@@ -27,6 +29,7 @@ public:
 	ptrdiff_t Read(void *buffer, ptrdiff_t len) override;
 	char *Gets(char *strbuf, ptrdiff_t len) override;
 	virtual const char *GetBuffer() const override { return bufptr; }
+	std::shared_ptr<const void> GetBufferOwner() const override { return owner; }
 };
 
 class BufferingReader : public MemoryReader
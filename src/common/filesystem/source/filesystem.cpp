@@ -44,6 +44,8 @@
 #include "resourcefile.h"
 #include "fs_filesystem.h"
 #include "fs_findfile.h"
+#include "fs_prefetch.h"
+#include "fs_dircache.h"
 #include "md5.hpp"
 #include "fs_stringpool.h"
 
@@ -80,9 +82,14 @@ static void md5Hash(FileReader& reader, uint8_t* digest)
 	md5_state_t state;
 	md5_init(&state);
 	md5_byte_t buffer[4096];
-	while (auto len = reader.Read(buffer, 4096))
+	// Hashes from the start. Decompressing readers do not allow reading past the end.
+	auto remaining = reader.GetLength();
+	while (remaining > 0)
 	{
-		md5_append(&state, buffer, len);
+		auto len = reader.Read(buffer, remaining < 4096 ? remaining : 4096);
+		if (len <= 0) break;
+		md5_append(&state, buffer, (unsigned)len);
+		remaining -= len;
 	}
 	md5_finish(&state, digest);
 }
@@ -211,6 +218,7 @@ FileSystem::~FileSystem ()
 
 void FileSystem::DeleteAll ()
 {
+	EndPrefetch();
 	Hashes.clear();
 	NumEntries = 0;
 
@@ -270,6 +278,11 @@ bool FileSystem::InitMultipleFiles (std::vector<std::string>& filenames, LumpFil
 		}
 	}
 
+	if (!DirCacheFile.empty())
+	{
+		DirCache = new DirectoryCache(DirCacheFile.c_str(), DirCacheTag.c_str(), filter);
+	}
+
 	for(size_t i=0;i<filenames.size(); i++)
 	{
 		AddFile(filenames[i].c_str(), nullptr, filter, Printf, hashfile);
@@ -283,12 +296,21 @@ bool FileSystem::InitMultipleFiles (std::vector<std::string>& filenames, LumpFil
 	NumEntries = (uint32_t)FileInfo.size();
 	if (NumEntries == 0)
 	{
+		delete DirCache;
+		DirCache = nullptr;
 		return false;
 	}
 	if (filter && filter->postprocessFunc) filter->postprocessFunc();
 
 	// [RH] Set up hash table
 	InitHashChains ();
+
+	if (DirCache != nullptr)
+	{
+		DirCache->Save();
+		delete DirCache;
+		DirCache = nullptr;
+	}
 	return true;
 }
 
@@ -351,7 +373,8 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, LumpFilterInf
 
 		if (!isdir)
 		{
-			if (!filereader.OpenFile(filename))
+			// fall back to regular file access if the file cannot be mapped.
+			if (!(MapFiles && filereader.OpenMappedFile(filename)) && !filereader.OpenFile(filename))
 			{ // Didn't find file
 				if (Printf)
 				{
@@ -370,7 +393,17 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, LumpFilterInf
 
 
 	if (!isdir)
-		resfile = FResourceFile::OpenResourceFile(filename, filereader, false, filter, Printf, stringpool);
+	{
+		resfile = nullptr;
+		// Only files opened from disk can be checked against the directory cache.
+		bool cacheable = DirCache != nullptr && filer == nullptr;
+		if (cacheable) resfile = DirCache->OpenArchive(filename, filereader, stringpool);
+		if (resfile == nullptr)
+		{
+			resfile = FResourceFile::OpenResourceFile(filename, filereader, false, filter, Printf, stringpool);
+			if (cacheable && resfile != nullptr) DirCache->AddArchive(filename, resfile);
+		}
+	}
 	else
 		resfile = FResourceFile::OpenDirectory(filename, filter, Printf, stringpool);
 
@@ -409,17 +442,24 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, LumpFilterInf
 			char cksumout[33];
 			memset(cksumout, 0, sizeof(cksumout));
 
-			if (filereader.isOpen())
+			// The resource file has taken over the reader.
+			auto containerreader = resfile->GetContainerReader();
+			if (containerreader != nullptr)
 			{
-				filereader.Seek(0, FileReader::SeekSet);
-				md5Hash(filereader, cksum);
+				bool cacheable = DirCache != nullptr && filer == nullptr;
+				if (!cacheable || !DirCache->GetMD5(filename, cksum))
+				{
+					containerreader->Seek(0, FileReader::SeekSet);
+					md5Hash(*containerreader, cksum);
+					if (cacheable) DirCache->SetMD5(filename, cksum);
+				}
 
 				for (size_t j = 0; j < sizeof(cksum); ++j)
 				{
 					snprintf(cksumout + (j * 2), 3, "%02X", cksum[j]);
 				}
 
-				fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)filereader.GetLength());
+				fprintf(hashfile, "file: %s, hash: %s, size: %d\n", filename, cksumout, (int)containerreader->GetLength());
 			}
 
 			else
@@ -431,7 +471,7 @@ void FileSystem::AddFile (const char *filename, FileReader *filer, LumpFilterInf
 				if (!(flags & RESFF_EMBEDDED))
 				{
 					auto reader = resfile->GetEntryReader(i, READER_SHARED, 0);
-					md5Hash(filereader, cksum);
+					md5Hash(reader, cksum);
 
 					for (size_t j = 0; j < sizeof(cksum); ++j)
 					{
@@ -827,6 +867,12 @@ void FileSystem::InitHashChains (void)
 	FirstLumpIndex_ResId = &Hashes[NumEntries * 6];
 	NextLumpIndex_ResId = &Hashes[NumEntries * 7];
 
+	if (DirCache != nullptr && DirCache->GetHashChains(Files, Hashes))
+	{
+		FileInfo.shrink_to_fit();
+		Files.shrink_to_fit();
+		return;
+	}
 
 	// Now set up the chains
 	for (i = 0; i < (unsigned)NumEntries; i++)
@@ -857,6 +903,7 @@ void FileSystem::InitHashChains (void)
 
 		}
 	}
+	if (DirCache != nullptr) DirCache->SetHashChains(Hashes);
 	FileInfo.shrink_to_fit();
 	Files.shrink_to_fit();
 }
@@ -1296,9 +1343,43 @@ FileData FileSystem::ReadFile (int lump)
 	{
 		throw FileSystemException("ReadFile: %u >= NumEntries", lump);
 	}
+	FileData data;
+	if (Prefetch != nullptr && Prefetch->Take(lump, data))
+	{
+		return data;
+	}
 	return FileInfo[lump].resfile->Read(FileInfo[lump].resindex);
 }
 
+//==========================================================================
+//
+// PrefetchFiles
+//
+// Compressed lumps are decompressed on the worker threads in the given
+// order and kept until someone reads them.
+//
+//==========================================================================
+
+void FileSystem::PrefetchFiles(const std::vector<int>& lumps, FileSystemTaskFunc runtask, size_t maxbytes)
+{
+	EndPrefetch();
+	Prefetch = new PrefetchCache(std::move(runtask), maxbytes);
+	for (int lump : lumps)
+	{
+		if ((unsigned)lump >= (unsigned)FileInfo.size()) continue;
+		auto& rec = FileInfo[lump];
+		if (!(rec.resfile->GetEntryFlags(rec.resindex) & RESFF_COMPRESSED) || rec.resfile->Length(rec.resindex) == 0) continue;
+		Prefetch->Add(lump, rec.resfile, rec.resindex);
+	}
+	Prefetch->Pump();
+}
+
+void FileSystem::EndPrefetch()
+{
+	if (Prefetch != nullptr) delete Prefetch;
+	Prefetch = nullptr;
+}
+
 //==========================================================================
 //
 // OpenFileReader
@@ -1315,6 +1396,14 @@ FileReader FileSystem::OpenFileReader(int lump, int readertype, int readerflags)
 		throw FileSystemException("OpenFileReader: %u >= NumEntries", lump);
 	}
 
+	FileData data;
+	if (Prefetch != nullptr && Prefetch->Take(lump, data))
+	{
+		FileReader fr;
+		fr.OpenMemoryArray(data);
+		return fr;
+	}
+
 	auto file = FileInfo[lump].resfile;
 	return file->GetEntryReader(FileInfo[lump].resindex, readertype, readerflags);
 }
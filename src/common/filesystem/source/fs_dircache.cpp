@@ -0,0 +1,490 @@
+/*
+** fs_dircache.cpp
+** Persistent cache for archive directories and lump hash chains
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The cache file is memory mapped and used in place. It consists of
+**
+**	- a header identifying the format version and the engine build,
+**	- the offsets of all archive records,
+**	- the archive records: the file's size and time stamp, the lump filter
+**	  they were processed with, the final directory after filtering and
+**	  sorting, and optionally the file's MD5,
+**	- the hash chains of the last file system set up from these files.
+**
+** Records are only trusted if path, size, time stamp and filter all match.
+** Anything that does not validate is ignored and rebuilt from the files.
+**
+*/
+
+#include <string.h>
+#include "fs_dircache.h"
+#include "fs_findfile.h"
+#include "fs_stringpool.h"
+
+namespace FileSys {
+
+FResourceFile *CreateZipFile(const char *filename, FileReader &file, StringPool* sp);
+
+enum
+{
+	DIRCACHE_VERSION = 1,
+	MAX_CACHED_ARCHIVES = 256,
+
+	DCA_HASMD5 = 1,
+};
+
+struct DirCacheHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint64_t TagKey;
+	uint64_t FileSize;
+	uint64_t SetKey;
+	uint64_t HashesOffset;
+	uint32_t NumHashes;
+	uint32_t NumArchives;
+	// followed by NumArchives offsets to the archive records.
+};
+
+struct DirectoryCache::CachedArchive
+{
+	uint32_t RecordSize;	// including the entries and the strings.
+	uint32_t NumEntries;
+	uint64_t FileSize;
+	int64_t MTime;
+	uint64_t FilterKey;
+	uint32_t PathOffset;
+	uint32_t Flags;
+	char Hash[48];
+	uint8_t MD5[16];
+	// followed by NumEntries CachedEntry and the strings.
+};
+
+struct DirectoryCache::CachedEntry
+{
+	uint64_t Length;
+	uint64_t CompressedSize;
+	uint64_t Position;
+	uint32_t NameOffset;
+	int32_t ResourceID;
+	uint32_t CRC32;
+	uint16_t Flags;
+	uint16_t Method;
+	int16_t Namespace;
+	uint16_t Padding[3];
+};
+
+static_assert(sizeof(DirCacheHeader) % 8 == 0 && sizeof(DirectoryCache::CachedArchive) % 8 == 0 && sizeof(DirectoryCache::CachedEntry) % 8 == 0, "cache records must stay 8 byte aligned");
+
+//==========================================================================
+//
+// FNV-1a
+//
+//==========================================================================
+
+uint64_t DirectoryCache::HashBytes(const void* data, size_t length, uint64_t hash)
+{
+	auto p = (const uint8_t*)data;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash = (hash ^ p[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t HashString(const char* str, uint64_t hash)
+{
+	return DirectoryCache::HashBytes(str, strlen(str) + 1, hash);
+}
+
+//==========================================================================
+//
+// Maps the cache file and indexes the records that pass validation
+//
+//==========================================================================
+
+DirectoryCache::DirectoryCache(const char* cachefile, const char* tag, const LumpFilterInfo* filter)
+{
+	CacheFile = cachefile;
+	TagKey = HashString(tag, HashBytes(nullptr, 0));
+
+	// The filter decides which lumps survive the post processing, so it is part of each archive's key.
+	FilterKey = HashBytes(nullptr, 0);
+	if (filter != nullptr)
+	{
+		for (auto list : { &filter->gameTypeFilter, &filter->reservedFolders, &filter->requiredPrefixes, &filter->embeddings, &filter->blockednames })
+		{
+			for (auto& str : *list) FilterKey = HashString(str.c_str(), FilterKey);
+			FilterKey = HashBytes("\n", 1, FilterKey);
+		}
+	}
+
+	if (!Mapping.OpenMappedFile(cachefile))
+	{
+		if (!Mapping.OpenFile(cachefile)) return;
+		auto data = Mapping.Read();
+		Mapping.OpenMemoryArray(data);
+		if (!Mapping.isOpen()) return;
+	}
+
+	auto base = (const uint8_t*)Mapping.GetBuffer();
+	uint64_t length = (uint64_t)Mapping.GetLength();
+	auto header = (const DirCacheHeader*)base;
+	if (length < sizeof(DirCacheHeader) || memcmp(header->Magic, "FSDC", 4) || header->Version != DIRCACHE_VERSION ||
+		header->TagKey != TagKey || header->FileSize != length ||
+		sizeof(DirCacheHeader) + header->NumArchives * sizeof(uint64_t) > length)
+	{
+		Mapping.Close();
+		return;
+	}
+
+	if (header->HashesOffset % 4 == 0 && header->HashesOffset <= length && header->NumHashes <= (length - header->HashesOffset) / 4)
+	{
+		LoadedSetKey = header->SetKey;
+		LoadedHashes = (const uint32_t*)(base + header->HashesOffset);
+		NumLoadedHashes = header->NumHashes;
+	}
+
+	auto offsets = (const uint64_t*)(header + 1);
+	for (uint32_t i = 0; i < header->NumArchives; i++)
+	{
+		uint64_t offset = offsets[i];
+		if (offset % 8 != 0 || offset > length || length - offset < sizeof(CachedArchive)) continue;
+
+		auto rec = (const CachedArchive*)(base + offset);
+		if (rec->RecordSize < sizeof(CachedArchive) || rec->RecordSize > length - offset || rec->PathOffset >= rec->RecordSize) continue;
+		if ((rec->RecordSize - sizeof(CachedArchive)) / sizeof(CachedEntry) < rec->NumEntries) continue;
+		// All strings are terminated if the record is.
+		if (((const char*)rec)[rec->RecordSize - 1] != 0) continue;
+
+		Loaded[(const char*)rec + rec->PathOffset] = rec;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+const DirectoryCache::CachedArchive* DirectoryCache::FindArchive(const char* filename, uint64_t* size, int64_t* mtime)
+{
+	if (!FS_GetFileStamp(filename, size, mtime)) return nullptr;
+
+	auto it = Loaded.find(filename);
+	if (it == Loaded.end()) return nullptr;
+
+	auto rec = it->second;
+	if (rec->FileSize != *size || rec->MTime != *mtime || rec->FilterKey != FilterKey) return nullptr;
+	return rec;
+}
+
+//==========================================================================
+//
+// Only creates the archive if the record is valid, so the reader is left
+// alone for the regular code path otherwise.
+//
+//==========================================================================
+
+FResourceFile* DirectoryCache::OpenArchive(const char* filename, FileReader& file, StringPool* sp)
+{
+	uint64_t size;
+	int64_t mtime;
+	auto rec = FindArchive(filename, &size, &mtime);
+	if (rec == nullptr || (uint64_t)file.GetLength() != rec->FileSize) return nullptr;
+
+	auto entries = (const CachedEntry*)(rec + 1);
+	for (uint32_t i = 0; i < rec->NumEntries; i++)
+	{
+		if (entries[i].NameOffset >= rec->RecordSize) return nullptr;
+	}
+
+	auto resfile = CreateZipFile(filename, file, sp);
+	auto Entries = resfile->AllocateEntries(rec->NumEntries);
+	for (uint32_t i = 0; i < rec->NumEntries; i++)
+	{
+		auto& src = entries[i];
+		auto& dest = Entries[i];
+		dest.Length = (size_t)src.Length;
+		dest.CompressedSize = (size_t)src.CompressedSize;
+		dest.FileName = sp->Strdup((const char*)rec + src.NameOffset);
+		dest.Position = (size_t)src.Position;
+		dest.ResourceID = src.ResourceID;
+		dest.CRC32 = src.CRC32;
+		dest.Flags = src.Flags;
+		dest.Method = src.Method;
+		dest.Namespace = src.Namespace;
+		dest.SystemFilePath = nullptr;
+	}
+	memcpy(resfile->Hash, rec->Hash, sizeof(resfile->Hash));
+	resfile->Hash[sizeof(resfile->Hash) - 1] = 0;
+	return resfile;
+}
+
+//==========================================================================
+//
+// Records the directory of a freshly opened archive
+//
+//==========================================================================
+
+void DirectoryCache::AddArchive(const char* filename, FResourceFile* resfile)
+{
+	uint64_t size;
+	int64_t mtime;
+	if (!resfile->CanCacheDirectory() || !FS_GetFileStamp(filename, &size, &mtime)) return;
+	if (resfile->Reader.GetLength() != (ptrdiff_t)size) return;
+
+	std::vector<uint8_t> blob(sizeof(CachedArchive) + resfile->NumLumps * sizeof(CachedEntry));
+	auto addString = [&](const char* str)
+	{
+		auto offset = (uint32_t)blob.size();
+		blob.insert(blob.end(), str, str + strlen(str) + 1);
+		return offset;
+	};
+
+	auto pathOffset = addString(filename);
+	for (uint32_t i = 0; i < resfile->NumLumps; i++)
+	{
+		auto& src = resfile->Entries[i];
+		CachedEntry entry = {};
+		entry.Length = src.Length;
+		entry.CompressedSize = src.CompressedSize;
+		entry.Position = src.Position;
+		entry.NameOffset = addString(src.FileName);
+		entry.ResourceID = src.ResourceID;
+		entry.CRC32 = src.CRC32;
+		entry.Flags = src.Flags;
+		entry.Method = src.Method;
+		entry.Namespace = src.Namespace;
+		memcpy(blob.data() + sizeof(CachedArchive) + i * sizeof(CachedEntry), &entry, sizeof(entry));
+	}
+	blob.resize((blob.size() + 7) & ~7);
+
+	CachedArchive rec = {};
+	rec.RecordSize = (uint32_t)blob.size();
+	rec.NumEntries = resfile->NumLumps;
+	rec.FileSize = size;
+	rec.MTime = mtime;
+	rec.FilterKey = FilterKey;
+	rec.PathOffset = pathOffset;
+	memcpy(rec.Hash, resfile->Hash, sizeof(rec.Hash));
+	memcpy(blob.data(), &rec, sizeof(rec));
+
+	Added[filename] = std::move(blob);
+	Dirty = true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool DirectoryCache::GetMD5(const char* filename, uint8_t* digest)
+{
+	const CachedArchive* rec = nullptr;
+	auto added = Added.find(filename);
+	if (added != Added.end())
+	{
+		rec = (const CachedArchive*)added->second.data();
+	}
+	else
+	{
+		uint64_t size;
+		int64_t mtime;
+		rec = FindArchive(filename, &size, &mtime);
+	}
+	if (rec == nullptr || !(rec->Flags & DCA_HASMD5)) return false;
+	memcpy(digest, rec->MD5, 16);
+	return true;
+}
+
+void DirectoryCache::SetMD5(const char* filename, const uint8_t* digest)
+{
+	auto added = Added.find(filename);
+	if (added != Added.end())
+	{
+		auto rec = (CachedArchive*)added->second.data();
+		memcpy(rec->MD5, digest, 16);
+		rec->Flags |= DCA_HASMD5;
+		Dirty = true;
+	}
+	else
+	{
+		uint64_t size;
+		int64_t mtime;
+		if (FindArchive(filename, &size, &mtime) == nullptr) return;
+		NewMD5[filename].assign(digest, digest + 16);
+		Dirty = true;
+	}
+}
+
+//==========================================================================
+//
+// The hash chains only depend on the lumps, which are fully determined by
+// the files in their order and the filter. So files on disk are keyed the
+// same way as their archive records, by path, size and time stamp.
+// Directories and archives inside other archives have no stamp of their
+// own, only for these the lump names are hashed.
+//
+//==========================================================================
+
+static uint64_t MakeSetKey(const std::vector<FResourceFile*>& files, uint32_t numhashes, uint64_t filterkey)
+{
+	uint64_t key = DirectoryCache::HashBytes(&numhashes, sizeof(numhashes), filterkey);
+	for (auto file : files)
+	{
+		int count = file->EntryCount();
+		key = HashString(file->GetFileName(), key);
+		key = DirectoryCache::HashBytes(&count, sizeof(count), key);
+
+		uint64_t size;
+		int64_t mtime;
+		if (FS_GetFileStamp(file->GetFileName(), &size, &mtime))
+		{
+			key = DirectoryCache::HashBytes(&size, sizeof(size), key);
+			key = DirectoryCache::HashBytes(&mtime, sizeof(mtime), key);
+			continue;
+		}
+		for (int i = 0; i < count; i++)
+		{
+			auto name = file->getName(i);
+			int ns = file->GetEntryNamespace(i);
+			int flags = file->GetEntryFlags(i);
+			key = HashString(name != nullptr ? name : "", key);
+			key = DirectoryCache::HashBytes(&ns, sizeof(ns), key);
+			key = DirectoryCache::HashBytes(&flags, sizeof(flags), key);
+		}
+	}
+	return key;
+}
+
+bool DirectoryCache::GetHashChains(const std::vector<FResourceFile*>& files, std::vector<uint32_t>& hashes)
+{
+	SetKey = MakeSetKey(files, (uint32_t)hashes.size(), FilterKey);
+	if (LoadedHashes == nullptr || LoadedSetKey != SetKey || NumLoadedHashes != hashes.size()) return false;
+	memcpy(hashes.data(), LoadedHashes, hashes.size() * sizeof(uint32_t));
+	return true;
+}
+
+void DirectoryCache::SetHashChains(const std::vector<uint32_t>& hashes)
+{
+	Hashes = hashes;
+	Dirty = true;
+}
+
+//==========================================================================
+//
+// Writes the records of this session, followed by the still valid
+// looking ones from before until the limit is reached.
+//
+//==========================================================================
+
+void DirectoryCache::Save()
+{
+	if (!Dirty) return;
+
+	std::vector<uint8_t> records;
+	std::vector<uint64_t> offsets;
+
+	auto addRecord = [&](const void* data, size_t size)
+	{
+		offsets.push_back(records.size());
+		records.insert(records.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+		return (CachedArchive*)(records.data() + offsets.back());
+	};
+
+	for (auto& [path, blob] : Added)
+	{
+		addRecord(blob.data(), blob.size());
+	}
+	for (auto& [path, rec] : Loaded)
+	{
+		if (offsets.size() >= MAX_CACHED_ARCHIVES) break;
+		if (Added.count(path)) continue;
+		auto copy = addRecord(rec, rec->RecordSize);
+		auto md5 = NewMD5.find(path);
+		if (md5 != NewMD5.end())
+		{
+			memcpy(copy->MD5, md5->second.data(), 16);
+			copy->Flags |= DCA_HASMD5;
+		}
+	}
+
+	// The offset table goes in front of the records.
+	uint64_t recordStart = sizeof(DirCacheHeader) + offsets.size() * sizeof(uint64_t);
+	recordStart = (recordStart + 7) & ~7ull;
+	for (auto& offset : offsets) offset += recordStart;
+
+	const uint32_t* hashes = Hashes.data();
+	size_t numhashes = Hashes.size();
+	uint64_t setkey = SetKey;
+	if (numhashes == 0 && LoadedHashes != nullptr)
+	{
+		hashes = LoadedHashes;
+		numhashes = NumLoadedHashes;
+		setkey = LoadedSetKey;
+	}
+
+	DirCacheHeader header = {};
+	memcpy(header.Magic, "FSDC", 4);
+	header.Version = DIRCACHE_VERSION;
+	header.TagKey = TagKey;
+	header.SetKey = setkey;
+	header.NumArchives = (uint32_t)offsets.size();
+	header.NumHashes = (uint32_t)numhashes;
+	header.HashesOffset = recordStart + records.size();
+	header.FileSize = header.HashesOffset + numhashes * sizeof(uint32_t);
+
+	std::vector<uint8_t> out(recordStart);
+	memcpy(out.data(), &header, sizeof(header));
+	if (offsets.size() > 0) memcpy(out.data() + sizeof(header), offsets.data(), offsets.size() * sizeof(uint64_t));
+	out.insert(out.end(), records.begin(), records.end());
+	out.insert(out.end(), (const uint8_t*)hashes, (const uint8_t*)(hashes + numhashes));
+
+	// Everything has been copied out of the old file, which must be unmapped before it can be replaced.
+	Loaded.clear();
+	LoadedHashes = nullptr;
+	Mapping.Close();
+
+	// Write a new file and move it over the old one, so that an interrupted save cannot leave a truncated cache behind.
+	std::string tempFile = CacheFile + ".tmp";
+	auto fw = FileWriter::Open(tempFile.c_str());
+	if (fw != nullptr)
+	{
+		bool written = fw->Write(out.data(), out.size()) == out.size();
+		delete fw;
+		if (written) FS_ReplaceFile(tempFile.c_str(), CacheFile.c_str());
+	}
+	Dirty = false;
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "fs_filesystem.h"
+
+namespace FileSys {
+
+// Keeps the parsed directories of archives and the file system's hash chains
+// in a file so that the next launch with the same files can skip rebuilding them.
+class DirectoryCache
+{
+public:
+	struct CachedArchive;
+	struct CachedEntry;
+
+	DirectoryCache(const char* cachefile, const char* tag, const LumpFilterInfo* filter);
+
+	// Returns the archive with its directory restored from the cache, or nullptr if there is no valid record for the file.
+	FResourceFile* OpenArchive(const char* filename, FileReader& file, StringPool* sp);
+	void AddArchive(const char* filename, FResourceFile* resfile);
+
+	bool GetMD5(const char* filename, uint8_t* digest);
+	void SetMD5(const char* filename, const uint8_t* digest);
+
+	// hashes must already have the size of the complete set of chains.
+	bool GetHashChains(const std::vector<FResourceFile*>& files, std::vector<uint32_t>& hashes);
+	void SetHashChains(const std::vector<uint32_t>& hashes);
+
+	uint64_t GetFilterKey() const { return FilterKey; }
+
+	// Writes the cache back if anything was added.
+	void Save();
+
+	static uint64_t HashBytes(const void* data, size_t length, uint64_t hash = 14695981039346656037ull);
+
+private:
+	const CachedArchive* FindArchive(const char* filename, uint64_t* size, int64_t* mtime);
+
+	std::string CacheFile;
+	uint64_t TagKey;
+	uint64_t FilterKey;
+	FileReader Mapping;
+
+	std::map<std::string, const CachedArchive*> Loaded;	// records in the mapped cache file
+	std::map<std::string, std::vector<uint8_t>> Added;	// records created this time
+	std::map<std::string, std::vector<uint8_t>> NewMD5;
+	uint64_t SetKey = 0;
+	std::vector<uint32_t> Hashes;
+	const uint32_t* LoadedHashes = nullptr;
+	uint32_t NumLoadedHashes = 0;
+	uint64_t LoadedSetKey = 0;
+	bool Dirty = false;
+};
+
+}
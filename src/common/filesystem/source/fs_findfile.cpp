@@ -33,6 +33,7 @@
 */
 
 #include "fs_findfile.h"
+#include <stdio.h>
 #include <string.h>
 #include <vector>
 
@@ -418,4 +419,51 @@ bool FS_DirEntryExists(const char* pathname, bool* isdir)
 	return res;
 }
 
+
+//==========================================================================
+//
+// FS_GetFileStamp
+//
+// Size and modification time of a regular file, to tell whether it has
+// changed since it was last seen.
+//
+//==========================================================================
+
+bool FS_GetFileStamp(const char* pathname, uint64_t* size, int64_t* mtime)
+{
+	if (pathname == NULL || *pathname == 0)
+		return false;
+
+#ifndef _WIN32
+	struct stat info;
+	bool res = stat(pathname, &info) == 0;
+#else
+	auto wstr = toWide(pathname);
+	struct _stat64 info;
+	bool res = _wstat64(wstr.c_str(), &info) == 0;
+#endif
+	if (!res || (info.st_mode & S_IFDIR)) return false;
+	*size = (uint64_t)info.st_size;
+	*mtime = (int64_t)info.st_mtime;
+	return true;
+}
+
+//==========================================================================
+//
+// FS_ReplaceFile
+//
+// Moves a freshly written file over another one, so that nobody ever
+// sees a partially written file under the final name.
+//
+//==========================================================================
+
+bool FS_ReplaceFile(const char* from, const char* to)
+{
+#ifndef _WIN32
+	return rename(from, to) == 0;
+#else
+	return MoveFileExW(toWide(from).c_str(), toWide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#endif
+}
+
 }
@@ -0,0 +1,223 @@
+/*
+** fs_prefetch.cpp
+** Background decompression of lumps that are known to be needed soon
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The compressed data is read on the owning thread, since the container's
+** reader cannot be shared. Only the decompression itself runs on the workers.
+**
+*/
+
+#include "fs_prefetch.h"
+#include "fs_decompress.h"
+
+namespace FileSys {
+
+//==========================================================================
+//
+// Only these are safe to run concurrently. The bzip2 decompressor reports
+// errors through a global and the others are too rare to bother.
+//
+//==========================================================================
+
+static bool IsThreadSafeMethod(int method)
+{
+	switch (method)
+	{
+	case METHOD_DEFLATE:
+	case METHOD_ZLIB:
+	case METHOD_LZMA:
+	case METHOD_XZ:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+PrefetchCache::PrefetchCache(FileSystemTaskFunc runtask, size_t maxbytes)
+	: RunTask(std::move(runtask)), Owner(std::this_thread::get_id()), MaxBytes(maxbytes)
+{
+}
+
+PrefetchCache::~PrefetchCache()
+{
+	// The tasks reference this object.
+	std::unique_lock<std::mutex> lock(Mutex);
+	DoneCondition.wait(lock, [&]() { return Running == 0; });
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void PrefetchCache::Add(int lump, FResourceFile* file, uint32_t entry)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	if (Entries.count(lump)) return;
+	Entries.emplace(lump, Entry{ file, entry, file->Length(entry), PF_Queued, {} });
+	Queue.push_back(lump);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void PrefetchCache::Pump()
+{
+	if (std::this_thread::get_id() != Owner) return;
+
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (!Queue.empty())
+	{
+		int lump = Queue.front();
+		auto it = Entries.find(lump);
+		if (it == Entries.end() || it->second.State != PF_Queued)
+		{
+			// already picked up by the caller.
+			Queue.pop_front();
+			continue;
+		}
+		auto& entry = it->second;
+		if (UsedBytes > 0 && UsedBytes + entry.Size > MaxBytes) break;
+
+		Queue.pop_front();
+		UsedBytes += entry.Size;
+		entry.State = PF_Running;
+		Running++;
+		auto file = entry.File;
+		auto index = entry.Index;
+		lock.unlock();
+
+		FCompressedBuffer raw = { 0, 0, METHOD_STORED, 0, nullptr, nullptr };
+		bool ok = true;
+		try
+		{
+			raw = file->GetRawData(index);
+		}
+		catch (const FileSystemException&)
+		{
+			ok = false;
+		}
+
+		if (!ok || raw.mBuffer == nullptr || !IsThreadSafeMethod(raw.mMethod))
+		{
+			// Stored data was already decoded by the container. Anything else is left to the caller.
+			FileData data;
+			ok = ok && raw.mMethod == METHOD_STORED && raw.mBuffer != nullptr;
+			if (ok) data = FileData(raw.mBuffer, raw.mSize);
+			raw.Clean();
+			Finish(lump, std::move(data), ok);
+		}
+		else
+		{
+			RunTask([this, lump, raw]() mutable
+			{
+				FileData data;
+				bool ok = false;
+				try
+				{
+					FileReader mr, frz;
+					mr.OpenMemory(raw.mBuffer, raw.mCompressedSize);
+					if (OpenDecompressor(frz, mr, raw.mSize, raw.mMethod, DCF_EXCEPTIONS))
+					{
+						ok = frz.Read(data.allocate(raw.mSize), raw.mSize) == (FileReader::Size)raw.mSize;
+					}
+				}
+				catch (const FileSystemException&)
+				{
+					ok = false;
+				}
+				raw.Clean();
+				Finish(lump, std::move(data), ok);
+			});
+		}
+		lock.lock();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void PrefetchCache::Finish(int lump, FileData&& data, bool ok)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	auto& entry = Entries[lump];
+	entry.State = ok ? PF_Ready : PF_Failed;
+	if (ok) entry.Data = std::move(data);
+	else UsedBytes -= entry.Size;
+	Running--;
+	DoneCondition.notify_all();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool PrefetchCache::Take(int lump, FileData& data)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	auto it = Entries.find(lump);
+	if (it == Entries.end()) return false;
+
+	DoneCondition.wait(lock, [&]() { return Entries[lump].State != PF_Running; });
+
+	it = Entries.find(lump);
+	auto& entry = it->second;
+	bool ok = entry.State == PF_Ready;
+	if (ok)
+	{
+		data = std::move(entry.Data);
+		UsedBytes -= entry.Size;
+	}
+	Entries.erase(it);
+	lock.unlock();
+
+	// The space is free again.
+	if (ok) Pump();
+	return ok;
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "fs_filesystem.h"
+
+namespace FileSys {
+
+// Decompresses lumps ahead of time on worker threads and holds the results
+// until the file system is asked for them. The amount of data held at once is bounded.
+class PrefetchCache
+{
+public:
+	PrefetchCache(FileSystemTaskFunc runtask, size_t maxbytes);
+	~PrefetchCache();
+
+	void Add(int lump, FResourceFile* file, uint32_t entry);
+
+	// Starts work on queued lumps as long as the budget allows. Only does something on the thread that created the cache.
+	void Pump();
+
+	// Hands out a prefetched lump, waiting for it if it is being worked on.
+	// Returns false if the lump was not prefetched, the caller must then read it itself.
+	bool Take(int lump, FileData& data);
+
+private:
+	enum EState
+	{
+		PF_Queued,
+		PF_Running,
+		PF_Ready,
+		PF_Failed,
+	};
+
+	struct Entry
+	{
+		FResourceFile* File;
+		uint32_t Index;
+		size_t Size;
+		EState State;
+		FileData Data;
+	};
+
+	void Finish(int lump, FileData&& data, bool ok);
+
+	std::mutex Mutex;
+	std::condition_variable DoneCondition;
+	std::unordered_map<int, Entry> Entries;
+	std::deque<int> Queue;
+	FileSystemTaskFunc RunTask;
+	std::thread::id Owner;
+	size_t MaxBytes;
+	size_t UsedBytes = 0;
+	int Running = 0;
+};
+
+}
@@ -673,7 +673,7 @@ FileReader FResourceFile::GetEntryReader(uint32_t entry, int readertype, int rea
 			// if this is backed by a memory buffer, create a new reader directly referencing it.
 			if (buf != nullptr)
 			{
-				fr.OpenMemory(buf + Entries[entry].Position, Entries[entry].Length);
+				fr.OpenMemory(buf + Entries[entry].Position, Entries[entry].Length, Reader.GetBufferOwner());
 			}
 			else
 			{
@@ -698,7 +698,10 @@ FileReader FResourceFile::GetEntryReader(uint32_t entry, int readertype, int rea
 		else
 		{
 			FileReader fri;
-			if (readertype == READER_NEW || !mainThread) fri.OpenFile(FileName, Entries[entry].Position, Entries[entry].CompressedSize);
+			auto buf = Reader.GetBuffer();
+			// a memory backed (e.g. mapped) file can feed the decompressor directly, from any thread.
+			if (buf != nullptr) fri.OpenMemory(buf + Entries[entry].Position, Entries[entry].CompressedSize, Reader.GetBufferOwner());
+			else if (readertype == READER_NEW || !mainThread) fri.OpenFile(FileName, Entries[entry].Position, Entries[entry].CompressedSize);
 			else fri.OpenFilePart(Reader, Entries[entry].Position, Entries[entry].CompressedSize);
 			int flags = DCF_TRANSFEROWNER | DCF_EXCEPTIONS;
 			if (readertype == READER_CACHED) flags |= DCF_CACHED;
@@ -717,6 +720,8 @@ FileData FResourceFile::Read(int entry)
 		// if this is backed by a memory buffer, we can just return a reference to the backing store.
 		if (buf != nullptr)
 		{
+			auto owner = Reader.GetBufferOwner();
+			if (owner != nullptr) return FileData(buf + Entries[entry].Position, Entries[entry].Length, std::move(owner));
 			return FileData(buf + Entries[entry].Position, Entries[entry].Length, false);
 		}
 	}
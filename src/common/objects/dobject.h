@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <type_traits>
 #include "m_alloc.h"
+#include "dobjpool.h"
 #include "vectors.h"
 #include "name.h"
 #include "palentry.h"
@@ -266,18 +267,18 @@ private:
 
 	void *operator new(size_t len, nonew&)
 	{
-		return M_Calloc(len, 1);
+		return memset(M_AllocObject(len), 0, len);
 	}
 public:
 
 	void operator delete (void *mem, nonew&)
 	{
-		M_Free(mem);
+		M_FreeObject(mem);
 	}
 
 	void operator delete (void *mem)
 	{
-		M_Free(mem);
+		M_FreeObject(mem);
 	}
 
 	// GC fiddling
@@ -0,0 +1,282 @@
+/*
+** dobjpool.cpp
+** Size class slab pools for DObject memory
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Slabs are aligned to their size, so the slab an object lives in is found
+** by masking its address. A map of all live slabs tells pooled memory apart
+** from memory that came from M_Malloc.
+**
+** Each size class allocates from the slab that most recently had room, and a
+** fresh slab hands out its space front to back. Objects spawned together
+** therefore end up next to each other, which is also the order in which the
+** thinker lists tick them.
+**
+*/
+
+#include <stdlib.h>
+#include <new>
+#include "dobjpool.h"
+#include "dobject.h"
+#include "m_alloc.h"
+#include "stats.h"
+#include "engineerrors.h"
+
+// MACROS ------------------------------------------------------------------
+
+#define SLAB_SHIFT			17
+#define SLAB_SIZE			(1 << SLAB_SHIFT)
+
+// Sizes are rounded up to whole cache lines.
+#define POOL_GRANULARITY	64
+#define MAX_POOLED_SIZE		4096
+#define NUM_SIZE_CLASSES	(MAX_POOLED_SIZE / POOL_GRANULARITY)
+
+// TYPES -------------------------------------------------------------------
+
+struct FObjectPool;
+
+struct FObjectSlab
+{
+	FObjectSlab *Next, *Prev;	// Slabs with room left
+	FObjectPool *Pool;
+	void *FreeList;
+	uint8_t *Unused;			// Start of the space that was never handed out
+	unsigned InUse;
+};
+
+struct FObjectPool
+{
+	size_t Size;
+	unsigned Capacity;
+	FObjectSlab *Partial;		// Slabs with room left, most recently used first
+	FObjectSlab *Spare;			// One empty slab is kept around to avoid thrashing
+	unsigned NumSlabs;
+};
+
+// PRIVATE DATA DEFINITIONS ------------------------------------------------
+
+static FObjectPool Pools[NUM_SIZE_CLASSES];
+static TMap<uintptr_t, FObjectSlab *> SlabMap;
+static size_t PooledBytes;
+
+// CODE --------------------------------------------------------------------
+
+static size_t SlabHeaderSize()
+{
+	return (sizeof(FObjectSlab) + POOL_GRANULARITY - 1) & ~(size_t)(POOL_GRANULARITY - 1);
+}
+
+static void *AllocSlabMemory()
+{
+	void *ptr;
+#if defined (_MSC_VER) || defined (__MINGW32__)
+	ptr = _aligned_malloc(SLAB_SIZE, SLAB_SIZE);
+#else
+	if (posix_memalign(&ptr, SLAB_SIZE, SLAB_SIZE) != 0) ptr = nullptr;
+#endif
+	if (ptr == nullptr)
+	{
+		I_FatalError("Could not allocate object slab");
+	}
+	return ptr;
+}
+
+static void FreeSlabMemory(void *ptr)
+{
+#if defined (_MSC_VER) || defined (__MINGW32__)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+//==========================================================================
+//
+// Slab list handling
+//
+//==========================================================================
+
+static void LinkSlab(FObjectSlab *slab)
+{
+	FObjectPool *pool = slab->Pool;
+	slab->Prev = nullptr;
+	slab->Next = pool->Partial;
+	if (pool->Partial != nullptr) pool->Partial->Prev = slab;
+	pool->Partial = slab;
+}
+
+static void UnlinkSlab(FObjectSlab *slab)
+{
+	FObjectPool *pool = slab->Pool;
+	if (slab->Prev != nullptr) slab->Prev->Next = slab->Next;
+	else pool->Partial = slab->Next;
+	if (slab->Next != nullptr) slab->Next->Prev = slab->Prev;
+	slab->Next = slab->Prev = nullptr;
+}
+
+static FObjectSlab *NewSlab(FObjectPool *pool)
+{
+	FObjectSlab *slab = pool->Spare;
+	if (slab != nullptr)
+	{
+		pool->Spare = nullptr;
+	}
+	else
+	{
+		slab = (FObjectSlab *)AllocSlabMemory();
+		slab->Pool = pool;
+		SlabMap[(uintptr_t)slab] = slab;
+		pool->NumSlabs++;
+	}
+	slab->FreeList = nullptr;
+	slab->Unused = (uint8_t *)slab + SlabHeaderSize();
+	slab->InUse = 0;
+	LinkSlab(slab);
+	return slab;
+}
+
+static void ReleaseSlab(FObjectSlab *slab)
+{
+	FObjectPool *pool = slab->Pool;
+	UnlinkSlab(slab);
+	if (pool->Spare == nullptr)
+	{
+		pool->Spare = slab;
+	}
+	else
+	{
+		SlabMap.Remove((uintptr_t)slab);
+		pool->NumSlabs--;
+		FreeSlabMemory(slab);
+	}
+}
+
+//==========================================================================
+//
+// M_AllocObject
+//
+// The returned memory is uninitialized, just like M_Malloc's.
+//
+//==========================================================================
+
+void *M_AllocObject(size_t size)
+{
+	if (size == 0 || size > MAX_POOLED_SIZE)
+	{
+		return M_Malloc(size);
+	}
+	FObjectPool *pool = &Pools[(size - 1) / POOL_GRANULARITY];
+	if (pool->Size == 0)
+	{
+		pool->Size = ((size - 1) / POOL_GRANULARITY + 1) * POOL_GRANULARITY;
+		pool->Capacity = unsigned((SLAB_SIZE - SlabHeaderSize()) / pool->Size);
+	}
+
+	FObjectSlab *slab = pool->Partial;
+	if (slab == nullptr)
+	{
+		slab = NewSlab(pool);
+	}
+
+	void *mem;
+	if (slab->FreeList != nullptr)
+	{
+		mem = slab->FreeList;
+		slab->FreeList = *(void **)mem;
+	}
+	else
+	{
+		mem = slab->Unused;
+		slab->Unused += pool->Size;
+	}
+	if (++slab->InUse == pool->Capacity)
+	{
+		UnlinkSlab(slab);
+	}
+	PooledBytes += pool->Size;
+	GC::ReportAlloc(pool->Size);
+	return mem;
+}
+
+//==========================================================================
+//
+// M_FreeObject
+//
+//==========================================================================
+
+void M_FreeObject(void *mem)
+{
+	if (mem == nullptr)
+	{
+		return;
+	}
+	FObjectSlab **pslab = SlabMap.CheckKey((uintptr_t)mem & ~(uintptr_t)(SLAB_SIZE - 1));
+	if (pslab == nullptr)
+	{
+		M_Free(mem);
+		return;
+	}
+	FObjectSlab *slab = *pslab;
+	FObjectPool *pool = slab->Pool;
+
+	*(void **)mem = slab->FreeList;
+	slab->FreeList = mem;
+	if (slab->InUse-- == pool->Capacity)
+	{
+		LinkSlab(slab);
+	}
+	if (slab->InUse == 0)
+	{
+		ReleaseSlab(slab);
+	}
+	PooledBytes -= pool->Size;
+	GC::ReportDealloc(pool->Size);
+}
+
+//==========================================================================
+//
+// STAT objpool
+//
+//==========================================================================
+
+ADD_STAT(objpool)
+{
+	FString out;
+	unsigned slabs = 0, classes = 0;
+	for (auto &pool : Pools)
+	{
+		slabs += pool.NumSlabs;
+		if (pool.NumSlabs > 0) classes++;
+	}
+	out.Format("Pooled:%6zuK  Slabs:%4u (%6zuK)  Size classes:%3u",
+		(PooledBytes + 1023) >> 10, slabs, ((size_t)slabs * SLAB_SIZE) >> 10, classes);
+	return out;
+}
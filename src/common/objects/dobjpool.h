@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+
+// Slab pools for object memory. Objects up to a few kilobytes are grouped by
+// size, so objects of the same class are packed together instead of being
+// spread over the heap. Larger objects go straight to M_Malloc.
+
+void *M_AllocObject(size_t size);
+
+// Must be used for every object allocated with M_AllocObject.
+void M_FreeObject(void *mem);
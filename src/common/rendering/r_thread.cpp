@@ -47,7 +47,6 @@ DrawerThreads::DrawerThreads()
 
 DrawerThreads::~DrawerThreads()
 {
-	StopThreads();
 }
 
 void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
@@ -57,22 +56,23 @@ void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
 
 	auto queue = Instance();
 
-	queue->StartThreads();
+	if (queue->active_commands.empty())
+		queue->SetupThreads();
 
-	// Add to queue and awaken worker threads
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
+	// Keep the commands alive until WaitForWorkers. Each thread runs its slice of them,
+	// and since the tasks are pinned every thread sees the queues in submission order.
 	queue->active_commands.push_back(commands);
-	queue->tasks_left += queue->threads.size();
-	end_lock.unlock();
-	start_lock.unlock();
-	queue->start_condition.notify_all();
+	for (auto &thread : queue->threads)
+	{
+		DrawerThread *t = &thread;
+		DrawerCommandQueue *list = commands.get();
+		queue->tasks.Run([=]() { queue->ExecuteCommands(t, list); }, t->worker);
+	}
 }
 
 void DrawerThreads::ResetDebugDrawPos()
 {
 	auto queue = Instance();
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
 	bool reached_end = false;
 	for (auto &thread : queue->threads)
 	{
@@ -92,18 +92,12 @@ void DrawerThreads::WaitForWorkers()
 
 	// Wait for workers to finish
 	auto queue = Instance();
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
-	if (!queue->end_condition.wait_for(end_lock, 5s, [&]() { return queue->tasks_left == 0; }))
+	if (!queue->tasks.WaitFor(5s))
 	{
 		I_FatalError("Drawer threads did not finish within 5 seconds!");
 	}
-	end_lock.unlock();
 
 	// Clean up
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
-	for (auto &thread : queue->threads)
-		thread.current_queue = 0;
-
 	for (auto &list : queue->active_commands)
 	{
 		for (auto &command : list->commands)
@@ -113,130 +107,85 @@ void DrawerThreads::WaitForWorkers()
 	queue->active_commands.clear();
 }
 
-void DrawerThreads::WorkerMain(DrawerThread *thread)
+void DrawerThreads::ExecuteCommands(DrawerThread *thread, DrawerCommandQueue *list)
 {
-	while (true)
+	if (r_debug_draw)
 	{
-		// Wait until we are signalled to run:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
-		start_condition.wait(start_lock, [&]() { return thread->current_queue < active_commands.size() || shutdown_flag; });
-		if (shutdown_flag)
-			break;
-
-		// Grab the commands
-		DrawerCommandQueuePtr list = active_commands[thread->current_queue];
-		thread->current_queue++;
-		thread->numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
-		thread->numa_end_y = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes;
-		start_lock.unlock();
-
-		// Do the work:
-		if (r_debug_draw)
-		{
-			for (auto& command : list->commands)
-			{
-				thread->debug_draw_pos++;
-				if (thread->debug_draw_pos < debug_draw_end)
-					command->Execute(thread);
-			}
-		}
-		else
+		for (auto& command : list->commands)
 		{
-			for (auto& command : list->commands)
-			{
+			thread->debug_draw_pos++;
+			if (thread->debug_draw_pos < debug_draw_end)
 				command->Execute(thread);
-			}
 		}
-
-		// Notify main thread that we finished:
-		std::unique_lock<std::mutex> end_lock(end_mutex);
-		tasks_left--;
-		bool finishedTasks = tasks_left == 0;
-		end_lock.unlock();
-		if (finishedTasks)
-			end_condition.notify_all();
 	}
-}
-
-void DrawerThreads::StartThreads()
-{
-	std::unique_lock<std::mutex> lock(threads_mutex);
-
-	int num_numathreads = 0;
-	for (int i = 0; i < I_GetNumaNodeCount(); i++)
-		num_numathreads += I_GetNumaNodeThreadCount(i);
-
-	int num_threads = num_numathreads;
-	if (num_threads == 0)
+	else
 	{
-		static bool firstCall = true;
-		if (firstCall)
+		for (auto& command : list->commands)
 		{
-			firstCall = false;
-			if (r_multithreaded == 1)
-				Printf("Warning: Unable to determine number of CPU cores/threads for this computer. To improve performance, please type 'r_multithreaded x' in the console, where x is the number of threads to use.\n");
+			command->Execute(thread);
 		}
-
-		num_threads = 1;
 	}
+}
 
+void DrawerThreads::SetupThreads()
+{
+	auto &scheduler = FTaskScheduler::Get();
+	int num_workers = scheduler.NumWorkers();
+
+	// Threads can only be pinned to distinct workers, or a barrier command would never complete.
+	int num_threads = num_workers;
 	if (r_multithreaded == 0)
 		num_threads = 1;
 	else if (r_multithreaded != 1)
-		num_threads = r_multithreaded;
+		num_threads = std::min<int>(r_multithreaded, num_workers);
 
-	if (num_threads != (int)threads.size())
-	{
-		StopThreads();
+	threads.resize(num_threads);
 
-		threads.resize(num_threads);
+	if (num_threads == num_workers)
+	{
+		// Split the lines between the NUMA nodes the workers belong to
+		int num_numa_nodes = 1;
+		for (int i = 0; i < num_threads; i++)
+			num_numa_nodes = max(num_numa_nodes, scheduler.GetWorkerNumaNode(i) + 1);
 
-		if (num_threads == num_numathreads)
+		for (int i = 0; i < num_threads; i++)
 		{
-			int curThread = 0;
-			for (int numaNode = 0; numaNode < I_GetNumaNodeCount(); numaNode++)
+			DrawerThread *thread = &threads[i];
+			int numaNode = scheduler.GetWorkerNumaNode(i);
+			thread->worker = i;
+			thread->core = 0;
+			thread->num_cores = 0;
+			for (int j = 0; j < num_threads; j++)
 			{
-				for (int i = 0; i < I_GetNumaNodeThreadCount(numaNode); i++)
+				if (scheduler.GetWorkerNumaNode(j) == numaNode)
 				{
-					DrawerThreads *queue = this;
-					DrawerThread *thread = &threads[curThread++];
-					thread->core = i;
-					thread->num_cores = I_GetNumaNodeThreadCount(numaNode);
-					thread->numa_node = numaNode;
-					thread->num_numa_nodes = I_GetNumaNodeCount();
-					thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-					I_SetThreadNumaNode(thread->thread, numaNode);
+					if (j < i)
+						thread->core++;
+					thread->num_cores++;
 				}
 			}
+			thread->numa_node = numaNode;
+			thread->num_numa_nodes = num_numa_nodes;
 		}
-		else
+	}
+	else
+	{
+		for (int i = 0; i < num_threads; i++)
 		{
-			for (int i = 0; i < num_threads; i++)
-			{
-				DrawerThreads *queue = this;
-				DrawerThread *thread = &threads[i];
-				thread->core = i;
-				thread->num_cores = num_threads;
-				thread->numa_node = 0;
-				thread->num_numa_nodes = 1;
-				thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-				I_SetThreadNumaNode(thread->thread, 0);
-			}
+			DrawerThread *thread = &threads[i];
+			thread->worker = i;
+			thread->core = i;
+			thread->num_cores = num_threads;
+			thread->numa_node = 0;
+			thread->num_numa_nodes = 1;
 		}
 	}
-}
 
-void DrawerThreads::StopThreads()
-{
-	std::unique_lock<std::mutex> lock(start_mutex);
-	shutdown_flag = true;
-	lock.unlock();
-	start_condition.notify_all();
 	for (auto &thread : threads)
-		thread.thread.join();
-	threads.clear();
-	lock.lock();
-	shutdown_flag = false;
+	{
+		thread.numa_start_y = thread.numa_node * screen->GetHeight() / thread.num_numa_nodes;
+		thread.numa_end_y = (thread.numa_node + 1) * screen->GetHeight() / thread.num_numa_nodes;
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -24,12 +24,12 @@
 
 #include <vector>
 #include <memory>
-#include <thread>
 #include <mutex>
 #include <condition_variable>
 
 #include "c_cvars.h"
 #include "basics.h"
+#include "tasks.h"
 
 // Use multiple threads when drawing
 EXTERN_CVAR(Int, r_multithreaded)
@@ -40,8 +40,8 @@ namespace swrenderer { class WallColumnDrawerArgs; }
 class DrawerThread
 {
 public:
-	std::thread thread;
-	size_t current_queue = 0;
+	// Task scheduler worker running this thread's slice of the commands
+	int worker = 0;
 
 	// Thread line index of this thread
 	int core = 0;
@@ -156,23 +156,16 @@ private:
 	DrawerThreads();
 	~DrawerThreads();
 
-	void StartThreads();
-	void StopThreads();
-	void WorkerMain(DrawerThread *thread);
+	void SetupThreads();
+	void ExecuteCommands(DrawerThread *thread, DrawerCommandQueue *list);
 
 	static DrawerThreads *Instance();
 
-	std::mutex threads_mutex;
+	// Every drawer thread is a task pinned to its own scheduler worker,
+	// as the commands may synchronize all threads with GroupMemoryBarrierCommand.
 	std::vector<DrawerThread> threads;
-
-	std::mutex start_mutex;
-	std::condition_variable start_condition;
 	std::vector<DrawerCommandQueuePtr> active_commands;
-	bool shutdown_flag = false;
-
-	std::mutex end_mutex;
-	std::condition_variable end_condition;
-	size_t tasks_left = 0;
+	FTaskGroup tasks;
 
 	size_t debug_draw_end = 0;
 
@@ -0,0 +1,480 @@
+/*
+** rt_headless.cpp
+** Stand-in RTGL1 interface and frame statistics for benchmarking the RT frontend
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "rt_headless.h"
+
+#include "m_argv.h"
+#include "printf.h"
+
+// The stand-in never creates a surface, so no surface type is needed here.
+#include <RTGL1/RTGL1.h>
+
+#include <algorithm>
+#include <vector>
+
+FRtBenchClocks g_rtbench = {};
+
+namespace
+{
+
+template< typename Fn >
+struct RtFnTraits;
+
+template< typename R, typename... Args >
+struct RtFnTraits< R ( * )( Args... ) >
+{
+    using Ret = R;
+};
+
+// return type of a function in the RgInterface table
+#define RT_RET( fn ) RtFnTraits< decltype( RgInterface::fn ) >::Ret
+
+template< typename T >
+T* FindInChain( const void* pNext, RgStructureType type )
+{
+    struct Header
+    {
+        RgStructureType sType;
+        const void*     pNext;
+    };
+    for( auto h = static_cast< const Header* >( pNext ); h; h = static_cast< const Header* >( h->pNext ) )
+    {
+        if( h->sType == type )
+        {
+            return reinterpret_cast< T* >( const_cast< Header* >( h ) );
+        }
+    }
+    return nullptr;
+}
+
+void SetIdentity( float ( &m )[ 16 ] )
+{
+    for( int i = 0; i < 16; i++ )
+    {
+        m[ i ] = ( i % 5 == 0 ) ? 1.0f : 0.0f;
+    }
+}
+
+uint8_t ToByte( float f )
+{
+    return uint8_t( std::clamp( f, 0.0f, 1.0f ) * 255.0f + 0.5f );
+}
+
+
+
+enum RtCall
+{
+    RTCALL_StartFrame,
+    RTCALL_DrawFrame,
+    RTCALL_UploadMeshPrimitive,
+    RTCALL_UploadLight,
+    RTCALL_UploadCamera,
+    RTCALL_ProvideOriginalTexture,
+    RTCALL_SpawnFluid,
+
+    RTCALL_Count
+};
+
+const char* const RtCallNames[ RTCALL_Count ] = {
+    "rgStartFrame",
+    "rgDrawFrame",
+    "rgUploadMeshPrimitive",
+    "rgUploadLight",
+    "rgUploadCamera",
+    "rgProvideOriginalTexture",
+    "rgSpawnFluid",
+};
+
+struct RtCallCounter
+{
+    uint64_t calls{ 0 };
+    uint64_t bytes{ 0 };
+};
+
+struct RtBenchSample
+{
+    double   beginFrame;
+    double   drawFrame;
+    double   internalDraw;
+    double   rgCalls;
+    double   submission;
+    uint32_t primitives;
+    uint32_t lights;
+};
+
+bool g_headless{ false };
+
+// the table the recording layer forwards to
+RgInterface g_forward{};
+
+RtCallCounter g_total[ RTCALL_Count ]{};
+RtCallCounter g_frame[ RTCALL_Count ]{};
+
+// time spent inside the forwarded calls
+cycle_t g_rgcalls{};
+// from rgStartFrame to rgDrawFrame
+cycle_t g_submission{};
+
+std::vector< RtBenchSample > g_samples;
+RtBenchSample                g_lastsample{};
+
+void Count( RtCall c, uint64_t bytes )
+{
+    g_total[ c ].calls++;
+    g_total[ c ].bytes += bytes;
+    g_frame[ c ].calls++;
+    g_frame[ c ].bytes += bytes;
+}
+
+template< typename Fn, typename... Args >
+auto Forward( Fn fn, Args... args )
+{
+    using R = decltype( fn( args... ) );
+
+    g_rgcalls.Clock();
+    if constexpr( std::is_void_v< R > )
+    {
+        fn( args... );
+        g_rgcalls.Unclock();
+    }
+    else
+    {
+        R r = fn( args... );
+        g_rgcalls.Unclock();
+        return r;
+    }
+}
+
+
+
+//
+// Stand-in for the RTGL1 library: accepts everything, draws nothing
+//
+
+void FillStandIn( RgInterface& dst )
+{
+    dst = RgInterface{};
+
+    dst.rgDestroyInstance = []() -> RT_RET( rgDestroyInstance ) { return RG_RESULT_SUCCESS; };
+
+    dst.rgStartFrame = []( auto pInfo ) -> RT_RET( rgStartFrame ) {
+        if( pInfo && pInfo->pResultStaticSceneStatus )
+        {
+            *pInfo->pResultStaticSceneStatus = 0;
+        }
+        return RG_RESULT_SUCCESS;
+    };
+    dst.rgDrawFrame = []( auto ) -> RT_RET( rgDrawFrame ) { return RG_RESULT_SUCCESS; };
+
+    dst.rgUploadMeshPrimitive = []( auto, auto ) -> RT_RET( rgUploadMeshPrimitive ) {
+        return RG_RESULT_SUCCESS;
+    };
+    dst.rgUploadLight = []( auto ) -> RT_RET( rgUploadLight ) { return RG_RESULT_SUCCESS; };
+    dst.rgUploadCamera = []( auto pInfo ) -> RT_RET( rgUploadCamera ) {
+        // the frontend reads back the inverse matrices for the first-person quads
+        if( auto readback = FindInChain< RgCameraInfoReadbackEXT >(
+                pInfo ? pInfo->pNext : nullptr, RG_STRUCTURE_TYPE_CAMERA_INFO_READ_BACK_EXT ) )
+        {
+            SetIdentity( readback->viewInverse );
+            SetIdentity( readback->projectionInverse );
+        }
+        return RG_RESULT_SUCCESS;
+    };
+
+    dst.rgProvideOriginalTexture = []( auto ) -> RT_RET( rgProvideOriginalTexture ) {
+        return RG_RESULT_SUCCESS;
+    };
+    dst.rgMarkOriginalTextureAsDeleted = []( auto ) -> RT_RET( rgMarkOriginalTextureAsDeleted ) {
+        return RG_RESULT_SUCCESS;
+    };
+    dst.rgSpawnFluid = []( auto ) -> RT_RET( rgSpawnFluid ) { return RG_RESULT_SUCCESS; };
+
+    dst.rgUtilPackColorByte4D = []( auto r, auto g, auto b, auto a ) -> RT_RET( rgUtilPackColorByte4D ) {
+        return RT_RET( rgUtilPackColorByte4D )( ( uint32_t( a ) << 24 ) | ( uint32_t( b ) << 16 ) |
+                                                ( uint32_t( g ) << 8 ) | ( uint32_t( r ) ) );
+    };
+    dst.rgUtilPackColorFloat4D = []( auto r, auto g, auto b, auto a ) -> RT_RET( rgUtilPackColorFloat4D ) {
+        return RT_RET( rgUtilPackColorFloat4D )(
+            ( uint32_t( ToByte( a ) ) << 24 ) | ( uint32_t( ToByte( b ) ) << 16 ) |
+            ( uint32_t( ToByte( g ) ) << 8 ) | ( uint32_t( ToByte( r ) ) ) );
+    };
+    dst.rgUtilPackNormal = []( auto x, auto y, auto z ) -> RT_RET( rgUtilPackNormal ) {
+        auto tounorm = []( float f ) {
+            return uint32_t( std::clamp( f * 0.5f + 0.5f, 0.0f, 1.0f ) * 1023.0f + 0.5f );
+        };
+        return RT_RET( rgUtilPackNormal )( tounorm( x ) | ( tounorm( y ) << 10 ) |
+                                           ( tounorm( z ) << 20 ) );
+    };
+
+    dst.rgUtilScratchGetIndices =
+        []( auto topology, auto vertexCount, auto ppOutIndices, auto pOutIndexCount ) {
+            static std::vector< uint32_t > s_indices;
+            s_indices.clear();
+
+            if( vertexCount >= 3 )
+            {
+                for( uint32_t i = 0; i + 2 < uint32_t( vertexCount ); i++ )
+                {
+                    if( topology == RG_UTIL_IM_SCRATCH_TOPOLOGY_TRIANGLE_FAN )
+                    {
+                        s_indices.insert( s_indices.end(), { 0, i + 1, i + 2 } );
+                    }
+                    else if( i % 2 == 0 )
+                    {
+                        s_indices.insert( s_indices.end(), { i, i + 1, i + 2 } );
+                    }
+                    else
+                    {
+                        s_indices.insert( s_indices.end(), { i + 1, i, i + 2 } );
+                    }
+                }
+            }
+
+            *ppOutIndices   = s_indices.data();
+            *pOutIndexCount = uint32_t( s_indices.size() );
+        };
+
+    dst.rgUtilRequestMemoryUsage = []() -> RT_RET( rgUtilRequestMemoryUsage ) { return {}; };
+    dst.rgUtilGetSupportedFeatures = []() -> RT_RET( rgUtilGetSupportedFeatures ) { return 0; };
+    dst.rgUtilDXGIAvailable = []( auto ppFailureReason ) -> RT_RET( rgUtilDXGIAvailable ) {
+        if( ppFailureReason )
+        {
+            *ppFailureReason = "Headless";
+        }
+        return false;
+    };
+    dst.rgUtilIsUpscaleTechniqueAvailable =
+        []( auto, auto, auto ppFailureReason ) -> RT_RET( rgUtilIsUpscaleTechniqueAvailable ) {
+        if( ppFailureReason )
+        {
+            *ppFailureReason = "Headless";
+        }
+        return false;
+    };
+}
+
+
+
+//
+// Recording layer: counts calls and payload, and times the forwarded calls
+//
+
+void InstallRecorder( RgInterface& dst )
+{
+    g_forward = dst;
+
+    if( dst.rgStartFrame )
+    {
+        dst.rgStartFrame = []( auto pInfo ) -> RT_RET( rgStartFrame ) {
+            Count( RTCALL_StartFrame, sizeof( *pInfo ) );
+            auto r = Forward( g_forward.rgStartFrame, pInfo );
+            g_submission.Reset();
+            g_submission.Clock();
+            return r;
+        };
+    }
+    if( dst.rgDrawFrame )
+    {
+        dst.rgDrawFrame = []( auto pInfo ) -> RT_RET( rgDrawFrame ) {
+            g_submission.Unclock();
+            Count( RTCALL_DrawFrame, sizeof( *pInfo ) );
+            return Forward( g_forward.rgDrawFrame, pInfo );
+        };
+    }
+    if( dst.rgUploadMeshPrimitive )
+    {
+        dst.rgUploadMeshPrimitive = []( auto pMesh, auto pPrimitive ) -> RT_RET( rgUploadMeshPrimitive ) {
+            Count( RTCALL_UploadMeshPrimitive,
+                   pPrimitive ? pPrimitive->vertexCount * sizeof( RgPrimitiveVertex ) +
+                                    pPrimitive->indexCount * sizeof( uint32_t )
+                              : 0 );
+            return Forward( g_forward.rgUploadMeshPrimitive, pMesh, pPrimitive );
+        };
+    }
+    if( dst.rgUploadLight )
+    {
+        dst.rgUploadLight = []( auto pInfo ) -> RT_RET( rgUploadLight ) {
+            Count( RTCALL_UploadLight, sizeof( *pInfo ) );
+            return Forward( g_forward.rgUploadLight, pInfo );
+        };
+    }
+    if( dst.rgUploadCamera )
+    {
+        dst.rgUploadCamera = []( auto pInfo ) -> RT_RET( rgUploadCamera ) {
+            Count( RTCALL_UploadCamera, sizeof( *pInfo ) );
+            return Forward( g_forward.rgUploadCamera, pInfo );
+        };
+    }
+    if( dst.rgProvideOriginalTexture )
+    {
+        dst.rgProvideOriginalTexture = []( auto pInfo ) -> RT_RET( rgProvideOriginalTexture ) {
+            Count( RTCALL_ProvideOriginalTexture,
+                   pInfo ? uint64_t( pInfo->size.width ) * pInfo->size.height * 4 : 0 );
+            return Forward( g_forward.rgProvideOriginalTexture, pInfo );
+        };
+    }
+    if( dst.rgSpawnFluid )
+    {
+        dst.rgSpawnFluid = []( auto pInfo ) -> RT_RET( rgSpawnFluid ) {
+            Count( RTCALL_SpawnFluid, sizeof( *pInfo ) );
+            return Forward( g_forward.rgSpawnFluid, pInfo );
+        };
+    }
+}
+
+double Percentile( std::vector< double >& values, double p )
+{
+    if( values.empty() )
+    {
+        return 0;
+    }
+    auto n = std::min( values.size() - 1, size_t( p * double( values.size() - 1 ) + 0.5 ) );
+    std::nth_element( values.begin(), values.begin() + n, values.end() );
+    return values[ n ];
+}
+
+}
+
+
+
+bool RT_IsHeadless()
+{
+    return g_headless;
+}
+
+bool RT_IsBenchmark()
+{
+    static const bool bench = Args->CheckParm( "-rtbench" ) != 0;
+    return bench;
+}
+
+// Called by Win32RTVideo instead of loading the RTGL1 library
+void RT_CreateHeadlessInterface( RgInterface* dst )
+{
+    g_headless = true;
+    FillStandIn( *dst );
+    InstallRecorder( *dst );
+}
+
+// Called after a real RTGL1 instance was created, to record what's submitted to it
+void RT_CreateRecordingInterface( RgInterface* dst )
+{
+    InstallRecorder( *dst );
+}
+
+void RT_BenchEndFrame()
+{
+    g_lastsample = RtBenchSample{
+        .beginFrame   = g_rtbench.beginFrame.TimeMS(),
+        .drawFrame    = g_rtbench.drawFrame.TimeMS(),
+        .internalDraw = g_rtbench.internalDraw.TimeMS(),
+        .rgCalls      = g_rgcalls.TimeMS(),
+        .submission   = g_submission.TimeMS(),
+        .primitives   = uint32_t( g_frame[ RTCALL_UploadMeshPrimitive ].calls ),
+        .lights       = uint32_t( g_frame[ RTCALL_UploadLight ].calls ),
+    };
+
+    if( RT_IsBenchmark() )
+    {
+        g_samples.push_back( g_lastsample );
+    }
+
+    g_rtbench.beginFrame.Reset();
+    g_rtbench.drawFrame.Reset();
+    g_rtbench.internalDraw.Reset();
+    g_rgcalls.Reset();
+    std::ranges::fill( g_frame, RtCallCounter{} );
+}
+
+void RT_BenchPrintReport()
+{
+    if( !RT_IsBenchmark() || g_samples.empty() )
+    {
+        return;
+    }
+
+    Printf( "RT frontend benchmark: %zu frames%s\n",
+            g_samples.size(),
+            g_headless ? " (headless)" : "" );
+    Printf( "%-24s %9s %9s %9s %9s\n", "ms per frame", "avg", "median", "95%", "max" );
+
+    auto l_print = [ & ]( const char* name, auto field ) {
+        auto values = std::vector< double >{};
+        values.reserve( g_samples.size() );
+        double sum = 0;
+        for( const RtBenchSample& s : g_samples )
+        {
+            values.push_back( double( s.*field ) );
+            sum += double( s.*field );
+        }
+        const double avg = sum / double( values.size() );
+        const double med = Percentile( values, 0.5 );
+        const double p95 = Percentile( values, 0.95 );
+        const double max = *std::ranges::max_element( values );
+        Printf( "%-24s %9.3f %9.3f %9.3f %9.3f\n", name, avg, med, p95, max );
+    };
+
+    l_print( "RT_BeginFrame", &RtBenchSample::beginFrame );
+    l_print( "RT_DrawFrame", &RtBenchSample::drawFrame );
+    l_print( "InternalDraw", &RtBenchSample::internalDraw );
+    l_print( "inside rg* calls", &RtBenchSample::rgCalls );
+    l_print( "submission window", &RtBenchSample::submission );
+    l_print( "primitives", &RtBenchSample::primitives );
+    l_print( "lights", &RtBenchSample::lights );
+
+    Printf( "%-24s %12s %14s\n", "totals", "calls", "KiB" );
+    for( int i = 0; i < RTCALL_Count; i++ )
+    {
+        Printf( "%-24s %12llu %14llu\n",
+                RtCallNames[ i ],
+                (unsigned long long)g_total[ i ].calls,
+                (unsigned long long)( g_total[ i ].bytes / 1024 ) );
+    }
+}
+
+ADD_STAT( rtbench )
+{
+    const RtBenchSample& s = g_lastsample;
+
+    FString out;
+    out.Format( "BeginFrame=%.3f ms  DrawFrame=%.3f ms  InternalDraw=%.3f ms  rg*=%.3f ms  "
+                "prims=%u  lights=%u",
+                s.beginFrame,
+                s.drawFrame,
+                s.internalDraw,
+                s.rgCalls,
+                s.primitives,
+                s.lights );
+    return out;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#if HAVE_RT
+
+#include "stats.h"
+
+// -rtheadless: the RTGL1 function table is a stand-in that doesn't touch any GPU device,
+// but records call counts, payload sizes and submission timings.
+// This file does not depend on a surface type, but the RT frontend that installs it
+// (rt_main.cpp, Win32RTVideo) only exists in the Windows build, and the game window
+// is created as usual.
+bool RT_IsHeadless();
+
+
+// CPU cost of the RT frontend, accumulated over a frame
+struct FRtBenchClocks
+{
+    cycle_t beginFrame;
+    cycle_t drawFrame;
+    cycle_t internalDraw;
+};
+
+extern FRtBenchClocks g_rtbench;
+
+bool RT_IsBenchmark();
+void RT_BenchEndFrame();
+// -rtbench: prints the per-frame statistics after the timed demo
+void RT_BenchPrintReport();
+
+#endif
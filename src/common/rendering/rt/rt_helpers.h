@@ -9,6 +9,7 @@ void RT_BakeExportables( const std::vector< bool >& animatedTexnums );
 bool RT_IsSectorExportable( const sector_t* sector, bool ceiling );
 bool RT_IsSectorExportable2( int sectornum, bool ceiling );
 bool RT_IsWallExportable( const seg_t* seg );
+void RT_InvalidateSectorLights();
 
 void RT_RequestMelt();
 bool RT_IsMeltActive();
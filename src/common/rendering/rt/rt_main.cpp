@@ -21,11 +21,13 @@
 #include "i_modelvertexbuffer.h"
 #include "p_lnspec.h"
 #include "image.h"
+#include "stats.h"
 
 #include "rt_state.h"
 
 #include <shellapi.h>
 
+#include <bit>
 #include <filesystem>
 #include <span>
 #include <variant>
@@ -43,6 +45,8 @@
 #define RG_USE_SURFACE_WIN32
 #include <RTGL1/RTGL1.h>
 
+#include "rt_headless.h"
+
 RgInterface rt      = {};
 FRtState    rtstate = {};
 
@@ -95,6 +99,7 @@ namespace cvar
 
     RT_CVAR( rt_cpu_cullmode,           0,      "[IMPACTS CPU PERFORMANCE HEAVILY] 0: BSP + all neighbor sectors of visible,  1 - original GZDoom's BSP/clip checks,  2: uploading whole map, no culling at all" )
     RT_CVAR( rt_cpu_nocullradius,       10.f,   "[IMPACTS CPU PERFORMANCE] Radius (in meters) in which culling must not be applied. Applicable with rt_cpu_cullmode=0" )
+    RT_CVAR( rt_cpu_batching,           true,   "[IMPACTS CPU PERFORMANCE] merge static world primitives with the same texture and state into one upload per frame" )
 
     RT_CVAR( rt_autoexport,             true,   "if true: if map's gltf doesn't exist on disk, export to gltf "
                                                 "and process the map as if it's static (which improves performance / stability)" )
@@ -283,6 +288,8 @@ extern float RT_CutsceneTime();
 extern void  RT_ForceIntroCutsceneMusicStop();
 
 extern void RT_CloseLauncherWindow();
+extern void RT_CreateHeadlessInterface( RgInterface* dst );
+extern void RT_CreateRecordingInterface( RgInterface* dst );
 
 auto RT_MakeUpRightForwardVectors( const DRotator& rotation ) -> std::tuple< RgFloat3D, RgFloat3D, RgFloat3D >;
 
@@ -593,6 +600,17 @@ private:
     std::vector< uint8_t > m_buffer;
 };
 
+// Per-frame counters of RTVertexBuffer's converted-vertex cache, see 'stat rtvertexcache'
+struct RTVertexCacheStats
+{
+    uint32_t hits{ 0 };
+    uint32_t misses{ 0 };
+    uint32_t convertedVertices{ 0 };
+    uint32_t invalidations{ 0 };
+};
+static RTVertexCacheStats g_vertexcachestats_cur{};
+static RTVertexCacheStats g_vertexcachestats_prev{};
+
 class RTVertexBuffer
     : public IVertexBuffer
     , public VectorAsBuffer
@@ -601,6 +619,10 @@ class RTVertexBuffer
     using VertexTypeHolder = std::
         variant< std::monostate, FSkyVertex, FModelVertex, FFlatVertex, F2DDrawer::TwoDVertex >;
 
+    // Granularity of the converted cache: big enough to amortize the bookkeeping,
+    // small enough so that a per-frame dynamic tail doesn't drag static data along
+    constexpr static uint32_t ChunkSize = 256;
+
 public:
     void SetFormat( int                           numBindingPoints,
                     int                           numAttributes,
@@ -636,13 +658,14 @@ public:
             assert( 0 );
             m_vertextype = std::monostate{};
         }
-        m_formatted.clear();
+        InvalidateAll();
     }
 
-    static void MakeFormatted( std::vector< RgPrimitiveVertex >& dst,
-                               size_t                            targetCount,
-                               std::span< const uint8_t >        srcbuf,
-                               const VertexTypeHolder&           vertextype )
+    // Convert source vertices [first, first + dst.size()) into dst
+    static void MakeFormatted( std::span< RgPrimitiveVertex > dst,
+                               size_t                         first,
+                               std::span< const uint8_t >     srcbuf,
+                               const VertexTypeHolder&        vertextype )
     {
         // TODO: mStreamData.uVertexColor for lightstyled?
 
@@ -666,31 +689,31 @@ public:
         std::visit(
             [ & ]< typename T >( const T& ) {
                 assert( srcbuf.size_bytes() % sizeof( T ) == 0 );
+                assert( ( first + dst.size() ) * sizeof( T ) <= srcbuf.size_bytes() );
 
-                dst.reserve( targetCount );
-                for( size_t i = dst.size(); i < targetCount; i++ )
+                for( size_t k = 0; k < dst.size(); k++ )
                 {
                     static_assert( sizeof( decltype( srcbuf )::value_type ) == 1 );
-                    const auto* ptr = &srcbuf[ i * sizeof( T ) ];
+                    const auto* ptr = &srcbuf[ ( first + k ) * sizeof( T ) ];
 
                     if constexpr( std::is_same_v< T, FSkyVertex > )
                     {
                         auto src = reinterpret_cast< const FSkyVertex* >( ptr );
 
-                        dst.push_back( RgPrimitiveVertex{
+                        dst[ k ] = RgPrimitiveVertex{
                             .position     = { src->x * ONEGAMEUNIT_IN_METERS,
                                               src->y * ONEGAMEUNIT_IN_METERS,
                                               src->z * ONEGAMEUNIT_IN_METERS },
                             .normalPacked = rg_packednormal_fallback,
                             .texCoord     = { src->u, src->v },
                             .color        = rtcolor( src->color ),
-                        } );
+                        };
                     }
                     else if constexpr( std::is_same_v< T, FModelVertex > )
                     {
                         auto src = reinterpret_cast< const FModelVertex* >( ptr );
 
-                        dst.push_back( RgPrimitiveVertex{
+                        dst[ k ] = RgPrimitiveVertex{
                             .position = { src->x * ONEGAMEUNIT_IN_METERS,
                                           src->y * ONEGAMEUNIT_IN_METERS,
                                           src->z * ONEGAMEUNIT_IN_METERS },
@@ -700,31 +723,31 @@ public:
                                                      gz_unpacknormal_z( src->packedNormal ) ),
                             .texCoord = { src->u, src->v },
                             .color    = RG_PACKED_COLOR_WHITE,
-                        } );
+                        };
                     }
                     else if constexpr( std::is_same_v< T, FFlatVertex > )
                     {
                         auto src = reinterpret_cast< const FFlatVertex* >( ptr );
 
-                        dst.push_back( RgPrimitiveVertex{
+                        dst[ k ] = RgPrimitiveVertex{
                             .position     = { src->x * ONEGAMEUNIT_IN_METERS,
                                               src->y * ONEGAMEUNIT_IN_METERS,
                                               src->z * ONEGAMEUNIT_IN_METERS },
                             .normalPacked = rg_packednormal_fallback,
                             .texCoord     = { src->u, src->v },
                             .color        = RG_PACKED_COLOR_WHITE,
-                        } );
+                        };
                     }
                     else if constexpr( std::is_same_v< T, F2DDrawer::TwoDVertex > )
                     {
                         auto src = reinterpret_cast< const F2DDrawer::TwoDVertex* >( ptr );
 
-                        dst.push_back( RgPrimitiveVertex{
+                        dst[ k ] = RgPrimitiveVertex{
                             .position     = { src->x, src->y, src->z },
                             .normalPacked = rg_packednormal_fallback,
                             .texCoord     = { src->u, src->v },
                             .color        = rtcolor_bgr_alphagamma( src->color0 ),
-                        } );
+                        };
                     }
                     else
                     {
@@ -737,14 +760,46 @@ public:
 
     auto AccessFormatted( uint32_t first, uint32_t count ) -> std::span< const RgPrimitiveVertex >
     {
-        if( std::holds_alternative< std::monostate >( m_vertextype ) )
+        if( std::holds_alternative< std::monostate >( m_vertextype ) || count == 0 )
         {
             return {};
         }
 
-        if( first + count > m_formatted.size() )
+        const size_t vertexcount = AccessBuffer().size_bytes() / VertexStride();
+        assert( first + count <= vertexcount );
+
+        const uint32_t firstchunk = first / ChunkSize;
+        const uint32_t lastchunk  = ( first + count - 1 ) / ChunkSize;
+
+        if( m_chunkversion.size() < lastchunk + 1 )
         {
-            MakeFormatted( m_formatted, first + count, AccessBuffer(), m_vertextype );
+            m_chunkversion.resize( lastchunk + 1, 0 );
+        }
+
+        for( uint32_t c = firstchunk; c <= lastchunk; c++ )
+        {
+            if( m_chunkversion[ c ] == m_version )
+            {
+                g_vertexcachestats_cur.hits++;
+                continue;
+            }
+
+            const size_t cfirst = size_t( c ) * ChunkSize;
+            const size_t ccount = std::min< size_t >( ChunkSize, vertexcount - cfirst );
+
+            if( m_formatted.size() < cfirst + ccount )
+            {
+                m_formatted.resize( cfirst + ccount );
+            }
+
+            MakeFormatted(
+                std::span{ &m_formatted[ cfirst ], ccount }, cfirst, AccessBuffer(), m_vertextype );
+
+            // while mapped, the source can be silently overwritten, so don't trust the result
+            m_chunkversion[ c ] = map ? 0 : m_version;
+
+            g_vertexcachestats_cur.misses++;
+            g_vertexcachestats_cur.convertedVertices += uint32_t( ccount );
         }
 
         assert( first + count <= m_formatted.size() );
@@ -757,31 +812,117 @@ public:
 
     void SetData( size_t size, const void* data, BufferUsageType type ) override
     {
-        m_formatted.clear();
+        InvalidateAll();
         Super::SetData( size, data, type );
     }
 
     void SetSubData( size_t offset, size_t size, const void* data ) override
     {
-        m_formatted.clear();
+        InvalidateRange( offset, size );
         Super::SetSubData( offset, size, data );
     }
 
-    void Unmap() override
+    void* Lock( unsigned size ) override
+    {
+        m_lockedsize = size;
+        return Super::Lock( size );
+    }
+
+    void Unlock() override
     {
-        m_formatted.clear();
-        Super::Unmap();
+        // the locked memory was written after Lock
+        InvalidateRange( 0, m_lockedsize );
+        m_lockedsize = 0;
+        Super::Unlock();
+    }
+
+    void Resize( size_t newsize ) override
+    {
+        InvalidateAll();
+        Super::Resize( newsize );
+    }
+
+    // Writes through a mapped pointer are published by Upload,
+    // so Map/Unmap themselves don't invalidate anything
+    void Upload( size_t start, size_t size ) override
+    {
+        InvalidateRange( start, size );
+        Super::Upload( start, size );
     }
 
     bool IsSky() const { return std::holds_alternative< FSkyVertex >( m_vertextype ); }
     bool IsUI() const { return std::holds_alternative< F2DDrawer::TwoDVertex >( m_vertextype ); }
 
+private:
+    size_t VertexStride() const
+    {
+        return std::visit(
+            []< typename T >( const T& ) -> size_t {
+                if constexpr( std::is_same_v< T, std::monostate > )
+                {
+                    return 1;
+                }
+                else
+                {
+                    return sizeof( T );
+                }
+            },
+            m_vertextype );
+    }
+
+    void InvalidateAll()
+    {
+        m_version++;
+        if( m_version == 0 )
+        {
+            // wrapped around, old stamps could alias
+            std::ranges::fill( m_chunkversion, 0 );
+            m_version = 1;
+        }
+        g_vertexcachestats_cur.invalidations++;
+    }
+
+    void InvalidateRange( size_t offsetInBytes, size_t sizeInBytes )
+    {
+        if( sizeInBytes == 0 || m_chunkversion.empty() )
+        {
+            return;
+        }
+
+        const size_t stride     = VertexStride();
+        const size_t firstchunk = ( offsetInBytes / stride ) / ChunkSize;
+        const size_t lastchunk  = ( ( offsetInBytes + sizeInBytes - 1 ) / stride ) / ChunkSize;
+
+        for( size_t c = firstchunk; c <= lastchunk && c < m_chunkversion.size(); c++ )
+        {
+            m_chunkversion[ c ] = 0;
+        }
+        g_vertexcachestats_cur.invalidations++;
+    }
+
 private:
     VertexTypeHolder m_vertextype;
 
     std::vector< RgPrimitiveVertex > m_formatted;
+    // if equals to m_version, the chunk in m_formatted is up-to-date
+    std::vector< uint32_t > m_chunkversion;
+    uint32_t                m_version{ 1 };
+    unsigned                m_lockedsize{ 0 };
 };
 
+ADD_STAT( rtvertexcache )
+{
+    const auto& s = g_vertexcachestats_prev;
+
+    FString out;
+    out.Format( "Vertex cache: %u chunk hits, %u chunk misses (%u vertices converted), %u invalidations",
+                s.hits,
+                s.misses,
+                s.convertedVertices,
+                s.invalidations );
+    return out;
+}
+
 class RTIndexBuffer
     : public IIndexBuffer
     , public VectorAsBuffer
@@ -840,6 +981,34 @@ private:
 
 
 
+// RTGL identifies a texture by its name: hardware textures of different translations
+// can resolve to the same name, and a name can be provided again after a texture is
+// recreated. Give each distinct name a small stable id, so it can be compared cheaply.
+class RTTextureIds
+{
+public:
+    uint32_t Intern( const std::string& name )
+    {
+        auto [ iter, isnew ] = m_ids.try_emplace( name, uint32_t( m_names.size() + 1 ) );
+        if( isnew )
+        {
+            m_names.push_back( name );
+        }
+        return iter->second;
+    }
+
+    const char* Name( uint32_t id ) const
+    {
+        return id > 0 && id <= m_names.size() ? m_names[ id - 1 ].c_str() : nullptr;
+    }
+
+private:
+    ankerl::unordered_dense::map< std::string, uint32_t > m_ids{};
+    std::vector< std::string >                            m_names{};
+};
+
+static RTTextureIds g_rttextureids{};
+
 class RTHardwareTexture : public IHardwareTexture
 {
 public:
@@ -929,6 +1098,7 @@ public:
             assert( 0 );
             return;
         }
+        m_id = g_rttextureids.Intern( m_name );
 
         auto texbuffer = src.GetTexture()->CreateTexBuffer( translation, flags | CTF_ProcessData );
         desaturateIfNeed( texbuffer, flags, fileSystem.GetFileShortName( src.GetSourceLump() ) );
@@ -979,6 +1149,9 @@ public:
         return m_created && !m_name.empty() ? m_name.c_str() : nullptr;
     }
 
+    // 0, if no name
+    auto GetRTId() const -> uint32_t { return m_id; }
+
 private:
     static auto MakeTextureName( FGameTexture& fgametex ) -> std::string
     {
@@ -1009,6 +1182,7 @@ private:
 private:
     bool        m_created{ false };
     std::string m_name{};
+    uint32_t    m_id{ 0 };
 };
 
 
@@ -1052,6 +1226,73 @@ RgFloat3D FromHomogeneous( const RgFloat4D& v )
                       v.data[ 2 ] / v.data[ 3 ] };
 }
 
+// Everything that must be equal for two primitives to be merged into one upload
+struct RTBatchKey
+{
+    uint32_t             texid; // see RTTextureIds
+    const char*          meshname;
+    RgMeshInfoFlags      meshflags;
+    RgTransform          transform;
+    bool                 isExportable;
+    float                localLightsIntensity;
+    RgMeshPrimitiveFlags primflags;
+    RgColor4DPacked32    color;
+    float                emissive;
+    float                classicLight;
+
+    bool operator==( const RTBatchKey& other ) const
+    {
+        return texid == other.texid && meshname == other.meshname &&
+               meshflags == other.meshflags &&
+               memcmp( &transform, &other.transform, sizeof( RgTransform ) ) == 0 &&
+               isExportable == other.isExportable &&
+               localLightsIntensity == other.localLightsIntensity &&
+               primflags == other.primflags && color == other.color &&
+               emissive == other.emissive && classicLight == other.classicLight;
+    }
+};
+
+struct RTBatchKeyHash
+{
+    using is_avalanching = void;
+
+    uint64_t operator()( const RTBatchKey& k ) const noexcept
+    {
+        auto h = ankerl::unordered_dense::hash< std::string_view >{}( std::string_view{
+            reinterpret_cast< const char* >( &k.transform ), sizeof( RgTransform ) } );
+
+        auto l_combine = [ &h ]( uint64_t v ) {
+            h = ankerl::unordered_dense::hash< uint64_t >{}( h ^ ( v + UINT64_C( 0x9E3779B97F4A7C15 ) ) );
+        };
+        l_combine( k.texid );
+        l_combine( reinterpret_cast< uint64_t >( k.meshname ) );
+        l_combine( ( uint64_t( k.meshflags ) << 32 ) | uint64_t( k.primflags ) );
+        l_combine( ( uint64_t( k.color ) << 1 ) | uint64_t( k.isExportable ) );
+        l_combine( std::bit_cast< uint32_t >( k.localLightsIntensity ) );
+        l_combine( ( uint64_t( std::bit_cast< uint32_t >( k.emissive ) ) << 32 ) |
+                   std::bit_cast< uint32_t >( k.classicLight ) );
+        return h;
+    }
+};
+
+// draws merged, primitives uploaded instead of them; see 'stat rtbatch'
+static std::pair< uint32_t, uint32_t > g_batchstats{};
+
+ADD_STAT( rtbatch )
+{
+    FString out;
+    out.Format( "Batching: %u draws merged into %u primitives", g_batchstats.first, g_batchstats.second );
+    return out;
+}
+
+struct RTBatch
+{
+    std::vector< RgPrimitiveVertex > verts;
+    std::vector< uint32_t >          indices;
+    // stable between frames, so the merged primitive keeps its identity
+    uint32_t primitiveIndex;
+};
+
 class RTRenderState : public FRenderState
 {
 public:
@@ -1465,6 +1706,9 @@ private:
                        const bool                           isUI,
                        const bool                           islines = false )
     {
+        g_rtbench.internalDraw.Clock();
+        defer { g_rtbench.internalDraw.Unclock(); };
+
         assert( RG_PACKED_COLOR_WHITE == rt.rgUtilPackColorByte4D( 255, 255, 255, 255 ) );
 
         if( islines && !isUI )
@@ -1480,6 +1724,7 @@ private:
         }
 
         const char* texname = nullptr;
+        uint32_t    texid   = 0;
         if( mTextureEnabled && mMaterial.mMaterial )
         {
             if( FGameTexture* gametex = mMaterial.mMaterial->sourcetex )
@@ -1495,6 +1740,7 @@ private:
                                               mMaterial.mMaterial->GetScaleFlags(),
                                               mRenderStyle );
                         texname = hwtex->GetRTName();
+                        texid   = hwtex->GetRTId();
                     }
                 }
             }
@@ -1695,11 +1941,141 @@ private:
         }
 #endif
 
+        if( m_batching && IsBatchable( mesh, prim, isUI, rtstate.is< RtPrim::ExportMap >() ) )
+        {
+            AddToBatch( mesh, prim, texid );
+            return;
+        }
+
         RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
         RG_CHECK( r );
     }
 
+    // World geometry that never moves by itself can lose its identity: exportable walls and
+    // flats (not adjacent to a movable sector, no animated texture), and everything that
+    // was already marked as not needing per-object motion vectors
+    static bool IsBatchable( const RgMeshInfo&          mesh,
+                             const RgMeshPrimitiveInfo& prim,
+                             bool                       isUI,
+                             bool                       isStatic )
+    {
+        constexpr RgMeshPrimitiveFlags nonbatchable =
+            RG_MESH_PRIMITIVE_TRANSLUCENT | RG_MESH_PRIMITIVE_SKY |
+            RG_MESH_PRIMITIVE_SKY_VISIBILITY | RG_MESH_PRIMITIVE_DECAL |
+            RG_MESH_PRIMITIVE_MIRROR | RG_MESH_PRIMITIVE_GLASS;
+
+        return !isUI && !prim.pNext && mesh.flags == 0 &&
+               ( isStatic || ( prim.flags & RG_MESH_PRIMITIVE_NO_MOTION_VECTORS ) ) &&
+               !( prim.flags & nonbatchable ) && prim.textureFrame == 0;
+    }
+
+    void AddToBatch( const RgMeshInfo& mesh, const RgMeshPrimitiveInfo& prim, uint32_t texid )
+    {
+        auto key = RTBatchKey{
+            .texid                = texid,
+            .meshname             = mesh.pMeshName,
+            .meshflags            = mesh.flags,
+            .transform            = mesh.transform,
+            .isExportable         = !!mesh.isExportable,
+            .localLightsIntensity = mesh.localLightsIntensity,
+            // the merged vertices change with visibility, so there is nothing to match
+            // the previous frame against; static geometry has no motion of its own anyway
+            .primflags            = prim.flags | RG_MESH_PRIMITIVE_NO_MOTION_VECTORS,
+            .color                = prim.color,
+            .emissive             = prim.emissive,
+            .classicLight         = prim.classicLight,
+        };
+
+        auto [ iter, isnew ] = m_batches.try_emplace( key );
+        RTBatch& batch       = iter->second;
+        if( isnew )
+        {
+            batch.primitiveIndex = m_nextBatchPrimitiveIndex++;
+        }
+
+        const auto base = static_cast< uint32_t >( batch.verts.size() );
+        batch.verts.insert( batch.verts.end(), prim.pVertices, prim.pVertices + prim.vertexCount );
+
+        if( prim.pIndices )
+        {
+            for( uint32_t i = 0; i < prim.indexCount; i++ )
+            {
+                batch.indices.push_back( base + prim.pIndices[ i ] );
+            }
+        }
+        else
+        {
+            // non-indexed is a triangle list
+            for( uint32_t i = 0; i < prim.vertexCount; i++ )
+            {
+                batch.indices.push_back( base + i );
+            }
+        }
+
+        m_batchedDraws++;
+    }
+
 public:
+    void RT_SetBatching( bool enable ) { m_batching = enable; }
+
+    void RT_FlushBatches()
+    {
+        uint32_t uploaded = 0;
+
+        for( auto& [ key, batch ] : m_batches )
+        {
+            if( batch.verts.empty() )
+            {
+                continue;
+            }
+
+            auto mesh = RgMeshInfo{
+                .sType                = RG_STRUCTURE_TYPE_MESH_INFO,
+                .pNext                = nullptr,
+                .flags                = key.meshflags,
+                .uniqueObjectID       = BatchedMeshId,
+                .pMeshName            = key.meshname,
+                .transform            = key.transform,
+                .isExportable         = key.isExportable,
+                .animationTime        = 0.0f,
+                .localLightsIntensity = key.localLightsIntensity,
+            };
+
+            auto prim = RgMeshPrimitiveInfo{
+                .sType                = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+                .pNext                = nullptr,
+                .flags                = key.primflags,
+                .primitiveIndexInMesh = batch.primitiveIndex,
+                .pVertices            = batch.verts.data(),
+                .vertexCount          = static_cast< uint32_t >( batch.verts.size() ),
+                .pIndices             = batch.indices.data(),
+                .indexCount           = static_cast< uint32_t >( batch.indices.size() ),
+                .pTextureName         = g_rttextureids.Name( key.texid ),
+                .textureFrame         = 0,
+                .color                = key.color,
+                .emissive             = key.emissive,
+                .classicLight         = key.classicLight,
+            };
+
+            RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
+            RG_CHECK( r );
+
+            // keep the capacity for the next frame
+            batch.verts.clear();
+            batch.indices.clear();
+            uploaded++;
+        }
+
+        g_batchstats   = { m_batchedDraws, uploaded };
+        m_batchedDraws = 0;
+
+        // don't let batches of the previous levels pile up
+        if( m_batches.size() > MaxBatchKeys )
+        {
+            m_batches.clear();
+        }
+    }
+
     void RT_SetMatrices( const VSMatrix& view, const VSMatrix& proj )
     {
         // TODO: only calculate when UI mode;
@@ -1920,6 +2296,14 @@ private:
 
     std::vector< RgPrimitiveVertex > m_tempverts{};
 
+    constexpr static uint64_t BatchedMeshId = 0xFFFFFFF;
+    constexpr static size_t   MaxBatchKeys  = 16384;
+
+    bool                                                                m_batching{ false };
+    ankerl::unordered_dense::map< RTBatchKey, RTBatch, RTBatchKeyHash > m_batches{};
+    uint32_t m_nextBatchPrimitiveIndex{ 0 };
+    uint32_t m_batchedDraws{ 0 };
+
 public:
     RTFrameBuffer* m_fb{ nullptr };
 };
@@ -2028,8 +2412,10 @@ Win32RTVideo::Win32RTVideo()
         exit( 1 );
     }
 
+    const bool headless = Args->CheckParm( "-rtheadless" );
+
     // warn if no needed dll-s
-    if( !Args->CheckParm( "-nodllcheck" ) )
+    if( !Args->CheckParm( "-nodllcheck" ) && !headless )
     {
         enum rt_feature_flag_t
         {
@@ -2180,7 +2566,19 @@ Win32RTVideo::Win32RTVideo()
 
     const char* remixdll = g_isremix ? "\\bin_remix\\RTGL1.dll" : nullptr;
 
-    RgResult r = rgLoadLibraryAndCreate( &info, isdebug, remixdll, &rt, nullptr );
+    RgResult r = RG_RESULT_SUCCESS;
+    if( headless )
+    {
+        RT_CreateHeadlessInterface( &rt );
+    }
+    else
+    {
+        r = rgLoadLibraryAndCreate( &info, isdebug, remixdll, &rt, nullptr );
+        if( r == RG_RESULT_SUCCESS && RT_IsBenchmark() )
+        {
+            RT_CreateRecordingInterface( &rt );
+        }
+    }
     if( r != RG_RESULT_SUCCESS )
     {
         auto msg = std::string{ "RgResult code: " };
@@ -2923,84 +3321,205 @@ void RT_MakeLightstyles()
     }
 }
 
-void RT_UploadExportableSectorLights()
+// Sector light emitters are precomputed on level load, and then only the sectors
+// that were reported by RT_MarkSectorPlanesChanged are re-evaluated.
+// Light level doesn't need that, as it's provided through lightstyles.
+struct RTSectorLight
 {
-    assert( g_sectorlightlevels.size() == primaryLevel->sectors.Size() );
+    float    z;
+    bool     thin;
+    bool     dirty;
+    uint32_t slot; // index in g_sectorlights.thick or g_sectorlights.thin
+};
+
+struct RTSectorLights
+{
+    const FLevelLocals*          level{ nullptr };
+    bool                         valid{ false };
+    std::vector< RTSectorLight > sectors{};
+    std::vector< uint32_t >      thick{};
+    std::vector< uint32_t >      thin{};
+    std::vector< uint32_t >      dirty{};
+} g_sectorlights;
+
+bool RT_IsLightingSpecial( int special )
+{
+    switch( special )
+    {
+        case Light_Phased:
+        case LightSequenceStart:
+        case LightSequenceSpecial1:
+        case LightSequenceSpecial2:
+        case dLight_Flicker:
+        case dLight_StrobeFast:
+        case dLight_StrobeSlow:
+        case dLight_Strobe_Hurt:
+        case dLight_Glow:
+        case dLight_StrobeSlowSync:
+        case dLight_StrobeFastSync:
+        case dLight_FireFlicker:
+        case sLight_Strobe_Hurt:
+        case Light_OutdoorLightning:
+        case Light_IndoorLightning1:
+        case Light_IndoorLightning2:   return true;
+        default:                       return false;
+    }
+}
+
+void RT_EvaluateSectorLight( const sector_t& sector, RTSectorLight& dst )
+{
+    auto zfloor   = float( sector.floorplane.ZatPoint( sector.centerspot ) );
+    auto zceiling = float( sector.ceilingplane.ZatPoint( sector.centerspot ) );
+
+    dst.z    = ( zfloor + zceiling ) / 2;
+    dst.thin = std::abs( zfloor - zceiling ) < 0.1f;
+}
+
+void RT_RebuildSectorLights()
+{
+    auto& sl = g_sectorlights;
+
+    sl.level = primaryLevel;
+    sl.valid = true;
+    sl.sectors.resize( primaryLevel->sectors.Size() );
+    sl.thick.clear();
+    sl.thin.clear();
+    sl.dirty.clear();
 
     for( uint32_t i = 0; i < primaryLevel->sectors.Size(); i++ )
     {
-        const sector_t& sector = primaryLevel->sectors[ i ];
+        RTSectorLight& dst = sl.sectors[ i ];
+        RT_EvaluateSectorLight( primaryLevel->sectors[ i ], dst );
 
-        float z;
-        {
-            auto zfloor   = float( sector.floorplane.ZatPoint( sector.centerspot ) );
-            auto zceiling = float( sector.ceilingplane.ZatPoint( sector.centerspot ) );
+        auto& list = dst.thin ? sl.thin : sl.thick;
+        dst.dirty  = false;
+        dst.slot   = uint32_t( list.size() );
+        list.push_back( i );
+    }
+}
 
-            // if too thin
-            if( std::abs( zfloor - zceiling ) < 0.1f )
-            {
-                bool important = ( sector.special == Light_Phased ) ||
-                                 ( sector.special == LightSequenceStart ) ||
-                                 ( sector.special == LightSequenceSpecial1 ) ||
-                                 ( sector.special == LightSequenceSpecial2 ) ||
-                                 ( sector.special == dLight_Flicker ) ||
-                                 ( sector.special == dLight_StrobeFast ) ||
-                                 ( sector.special == dLight_StrobeSlow ) ||
-                                 ( sector.special == dLight_Strobe_Hurt ) ||
-                                 ( sector.special == dLight_Glow ) ||
-                                 ( sector.special == dLight_StrobeSlowSync ) ||
-                                 ( sector.special == dLight_StrobeFastSync ) ||
-                                 ( sector.special == dLight_FireFlicker ) ||
-                                 ( sector.special == sLight_Strobe_Hurt ) ||
-                                 ( sector.special == Light_OutdoorLightning ) ||
-                                 ( sector.special == Light_IndoorLightning1 ) ||
-                                 ( sector.special == Light_IndoorLightning2 );
-                if( !important )
-                {
-                    continue;
-                }
-            }
+void RT_UpdateDirtySectorLights()
+{
+    auto& sl = g_sectorlights;
+
+    for( uint32_t i : sl.dirty )
+    {
+        RTSectorLight& dst     = sl.sectors[ i ];
+        const bool     wasthin = dst.thin;
+
+        RT_EvaluateSectorLight( primaryLevel->sectors[ i ], dst );
+        dst.dirty = false;
 
-            z = ( zfloor + zceiling ) / 2;
+        if( dst.thin != wasthin )
+        {
+            // swap-remove from the old list
+            auto& from       = wasthin ? sl.thin : sl.thick;
+            uint32_t moved   = from.back();
+            from[ dst.slot ] = moved;
+            sl.sectors[ moved ].slot = dst.slot;
+            from.pop_back();
+
+            auto& to = dst.thin ? sl.thin : sl.thick;
+            dst.slot = uint32_t( to.size() );
+            to.push_back( i );
         }
+    }
+    sl.dirty.clear();
+}
 
-        const auto center = FVector3{
-            float( sector.centerspot.X ),
-            float( sector.centerspot.Y ),
-            z,
-        };
+void RT_UploadSectorLight( uint32_t i, const sector_t& sector, float z )
+{
+    const auto center = FVector3{
+        float( sector.centerspot.X ),
+        float( sector.centerspot.Y ),
+        z,
+    };
 
-        auto adt = RgLightAdditionalEXT{
-            .sType      = RG_STRUCTURE_TYPE_LIGHT_ADDITIONAL_EXT,
-            .pNext      = nullptr,
-            .flags      = RG_LIGHT_ADDITIONAL_LIGHTSTYLE,
-            .lightstyle = int( i ), // references g_sectorlightlevels
-            .hashName   = "",
-        };
+    auto adt = RgLightAdditionalEXT{
+        .sType      = RG_STRUCTURE_TYPE_LIGHT_ADDITIONAL_EXT,
+        .pNext      = nullptr,
+        .flags      = RG_LIGHT_ADDITIONAL_LIGHTSTYLE,
+        .lightstyle = int( i ), // references g_sectorlightlevels
+        .hashName   = "",
+    };
 
-        auto lsph = RgLightSphericalEXT{
-            .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
-            .pNext     = &adt,
-            .color     = RG_PACKED_COLOR_WHITE,
-            .intensity = cvar::rt_autoexport_light,
-            .position  = { center.X * ONEGAMEUNIT_IN_METERS,
-                           center.Y * ONEGAMEUNIT_IN_METERS,
-                           center.Z * ONEGAMEUNIT_IN_METERS },
-            .radius    = 0.05f,
-        };
+    auto lsph = RgLightSphericalEXT{
+        .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
+        .pNext     = &adt,
+        .color     = RG_PACKED_COLOR_WHITE,
+        .intensity = cvar::rt_autoexport_light,
+        .position  = { center.X * ONEGAMEUNIT_IN_METERS,
+                       center.Y * ONEGAMEUNIT_IN_METERS,
+                       center.Z * ONEGAMEUNIT_IN_METERS },
+        .radius    = 0.05f,
+    };
 
-        auto linfo = RgLightInfo{
-            .sType        = RG_STRUCTURE_TYPE_LIGHT_INFO,
-            .pNext        = &lsph,
-            .uniqueID     = SectorLightId_Base + i,
-            .isExportable = true, // so we can write in the gltf
-        };
+    auto linfo = RgLightInfo{
+        .sType        = RG_STRUCTURE_TYPE_LIGHT_INFO,
+        .pNext        = &lsph,
+        .uniqueID     = SectorLightId_Base + i,
+        .isExportable = true, // so we can write in the gltf
+    };
 
-        RgResult r = rt.rgUploadLight( &linfo );
-        RG_CHECK( r );
+    RgResult r = rt.rgUploadLight( &linfo );
+    RG_CHECK( r );
+}
+
+void RT_UploadExportableSectorLights()
+{
+    assert( g_sectorlightlevels.size() == primaryLevel->sectors.Size() );
+
+    auto& sl = g_sectorlights;
+
+    if( !sl.valid || sl.level != primaryLevel ||
+        sl.sectors.size() != primaryLevel->sectors.Size() )
+    {
+        RT_RebuildSectorLights();
     }
+    else
+    {
+        RT_UpdateDirtySectorLights();
+    }
+
+    for( uint32_t i : sl.thick )
+    {
+        RT_UploadSectorLight( i, primaryLevel->sectors[ i ], sl.sectors[ i ].z );
+    }
+
+    // specials are changed without a notification, so recheck them; thin sectors are few
+    for( uint32_t i : sl.thin )
+    {
+        const sector_t& sector = primaryLevel->sectors[ i ];
+        if( RT_IsLightingSpecial( sector.special ) )
+        {
+            RT_UploadSectorLight( i, sector, sl.sectors[ i ].z );
+        }
+    }
+}
+
+}
+
+void RT_MarkSectorPlanesChanged( const sector_t* sector )
+{
+    auto& sl = g_sectorlights;
+
+    if( !sl.valid || !sector || sector->Level != sl.level )
+    {
+        return;
+    }
+
+    auto i = uint32_t( sector->Index() );
+    if( i >= sl.sectors.size() || sl.sectors[ i ].dirty )
+    {
+        return;
+    }
+    sl.sectors[ i ].dirty = true;
+    sl.dirty.push_back( i );
 }
 
+void RT_InvalidateSectorLights()
+{
+    g_sectorlights.valid = false;
 }
 
 //
@@ -3021,6 +3540,8 @@ struct ext_RgStartFrameRemixParams
 
 void RTFrameBuffer::RT_BeginFrame()
 {
+    g_rtbench.beginFrame.Clock();
+
     // HACKHACK begin
     if( g_rt_skipinitframes == -10 )
     {
@@ -3040,6 +3561,7 @@ void RTFrameBuffer::RT_BeginFrame()
 
 
     m_state->RT_BeginFrame();
+    g_vertexcachestats_prev = std::exchange( g_vertexcachestats_cur, {} );
 
     classic_toggle::Animate();
 
@@ -3142,10 +3664,18 @@ void RTFrameBuffer::RT_BeginFrame()
     };
 
     rt_cullmode = l_clm();
+
+    // keep the export output per-primitive
+    m_state->RT_SetBatching( cvar::rt_cpu_batching &&
+                             !( staticscene_status & RG_STATIC_SCENE_STATUS_EXPORT_STARTED ) );
+
+    g_rtbench.beginFrame.Unclock();
 }
 
 void RTFrameBuffer::RT_DrawFrame()
 {
+    g_rtbench.drawFrame.Clock();
+
     const double   curtime      = RT_GetCurrentTime();
     const uint32_t powerupflags = RT_CalcPowerupFlags();
 
@@ -3462,6 +3992,8 @@ void RTFrameBuffer::RT_DrawFrame()
         .currentTime      = curtime,
     };
 
+    m_state->RT_FlushBatches();
+
     RgResult r = rt.rgDrawFrame( &info );
     RG_CHECK( r );
 
@@ -3475,6 +4007,9 @@ void RTFrameBuffer::RT_DrawFrame()
         m_wassky           = false;
         g_resetposteffects = false;
     }
+
+    g_rtbench.drawFrame.Unclock();
+    RT_BenchEndFrame();
 }
 
 //
@@ -4119,6 +4654,7 @@ void RT_BakeExportables( const std::vector< bool >& animatedTexnums )
     rt_wallPegged.clear();
     g_tagsSafeToIgnore.clear();
     g_stairsSectors.clear();
+    RT_InvalidateSectorLights();
 
     if( !primaryLevel )
     {
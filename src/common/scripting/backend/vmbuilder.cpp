@@ -43,6 +43,7 @@ CVAR(Bool, strictdecorate, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
 
 EXTERN_CVAR(Bool, vm_jit)
 EXTERN_CVAR(Bool, vm_jit_aot)
+EXTERN_CVAR(Bool, vm_jit_tiered)
 
 struct VMRemap
 {
@@ -933,7 +934,7 @@ void FFunctionBuildList::Build()
 				sfunc->Unsafe = ctx.Unsafe;
 
 				#if HAVE_VM_JIT
-					if(vm_jit && vm_jit_aot)
+					if(vm_jit && vm_jit_aot && !vm_jit_tiered)
 					{
 						sfunc->JitCompile();
 					}
@@ -951,6 +952,13 @@ void FFunctionBuildList::Build()
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = strictdecorate;
 
+#ifdef HAVE_VM_JIT
+	if (vm_jit && vm_jit_aot && !vm_jit_tiered)
+	{
+		JitCacheSave();
+	}
+#endif
+
 	if (FScriptPosition::ErrorCounter == 0)
 	{
 		if (Args->CheckParm("-dumpjit")) DumpJit(true);
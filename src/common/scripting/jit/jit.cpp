@@ -10,15 +10,20 @@ extern PStruct* TypeVector4;
 extern PStruct* TypeQuaternion;
 extern PStruct* TypeFQuaternion;
 
-static void OutputJitLog(const asmjit::StringLogger &logger);
+static void OutputJitLog(const asmjit::StringLogger &logger, FString *errors);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, FString *errors)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName, "StatusScreen.drawNum") != 0)
 		return nullptr;
 #endif
 
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+
+	if (auto cached = JitCacheLoad(sfunc))
+		return cached;
+
 	using namespace asmjit;
 	StringLogger logger;
 	try
@@ -34,8 +39,11 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
-		OutputJitLog(logger);
-		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName, e.what());
+		OutputJitLog(logger, errors);
+		if (errors)
+			errors->AppendFormat("%s: Unexpected JIT error: %s\n", sfunc->PrintableName, e.what());
+		else
+			Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName, e.what());
 		return nullptr;
 	}
 }
@@ -44,6 +52,7 @@ void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
 	StringLogger logger;
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
 
 	if(sfunc->VarFlags & VARF_Abstract)
 	{
@@ -77,8 +86,14 @@ void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 	}
 }
 
-static void OutputJitLog(const asmjit::StringLogger &logger)
+static void OutputJitLog(const asmjit::StringLogger &logger, FString *errors)
 {
+	if (errors)
+	{
+		*errors += logger.getString();
+		return;
+	}
+
 	// Write line by line since I_FatalError seems to cut off long strings
 	const char *pos = logger.getString();
 	const char *end = pos;
@@ -399,7 +414,7 @@ void JitCompiler::SetupFullVMFrame()
 	stack = cc.newIntPtr("stack");
 	auto allocFrame = CreateCall<VMFrameStack *, VMScriptFunction *, VMValue *, int>(CreateFullVMFrame);
 	allocFrame->setRet(0, stack);
-	allocFrame->setArg(0, imm_ptr(sfunc));
+	allocFrame->setArg(0, ImmPtr(sfunc));
 	allocFrame->setArg(1, args);
 	allocFrame->setArg(2, numargs);
 
@@ -440,7 +455,7 @@ void JitCompiler::IncrementVMCalls()
 	// VMCalls[0]++
 	auto vmcallsptr = newTempIntPtr();
 	auto vmcalls = newTempInt32();
-	cc.mov(vmcallsptr, asmjit::imm_ptr(VMCalls));
+	cc.mov(vmcallsptr, ImmPtr(VMCalls));
 	cc.mov(vmcalls, asmjit::x86::dword_ptr(vmcallsptr));
 	cc.add(vmcalls, (int)1);
 	cc.mov(asmjit::x86::dword_ptr(vmcallsptr), vmcalls);
@@ -3,6 +3,7 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+JitFuncPtr JitCompile(VMScriptFunction *func, FString *errors = nullptr);	// with errors set, nothing is printed and the function may be called from any thread
 void JitDumpLog(FILE *file, VMScriptFunction *func);
+void JitCacheSave();
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int maxFrames = -1);
@@ -0,0 +1,745 @@
+/*
+** jit_cache.cpp
+** Keeps JIT compiled script functions on disk between launches
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** A record holds the machine code of one function as asmjit emitted it,
+** before relocation, together with everything needed to place it somewhere
+** else:
+**
+**	- the embedded pointers, described by what they point to: the function
+**	  itself, an entry in one of its constant tables, the value of an address
+**	  constant, or something inside the executable,
+**	- asmjit's relocation entries, with call targets described the same way,
+**	- the line info for stack traces and the unwind info.
+**
+** Records are keyed by a hash of everything the code generator looks at:
+** the bytecode, the constants, the prototype and the called functions. The
+** whole file is tied to the executable it was written by, since targets
+** inside the executable are stored as offsets from its load address.
+**
+** Functions that embed anything that cannot be described are simply not
+** cached.
+**
+*/
+
+#include <string.h>
+#include "jit.h"
+#include "jitintern.h"
+#include "md5.h"
+#include "c_cvars.h"
+#include "cmdlib.h"
+#include "m_argv.h"
+#include "version.h"
+#include "i_specialpaths.h"
+#include "fs_findfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+CVAR(Bool, vm_jit_cache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)	// keep JIT compiled functions in the cache folder
+
+enum
+{
+	JITCACHE_VERSION = 2,
+	MAX_UNUSED_LAUNCHES = 4,	// records not used in this many launches in a row are dropped
+};
+
+enum EJitCacheTarget : uint8_t
+{
+	JCT_Raw,			// used as is
+	JCT_Function,		// the function itself
+	JCT_KonstD,			// byte offset into one of the constant tables
+	JCT_KonstF,
+	JCT_KonstS,
+	JCT_KonstA,
+	JCT_KonstAValue,	// the value of an address constant
+	JCT_Image,			// offset from the executable's load address
+	JCT_CallSite,		// inline cache of a call site, by its index in the function
+};
+
+struct JitCacheHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint8_t BuildKey[16];
+	uint32_t NumRecords;
+	uint32_t Reserved;
+};
+
+struct JitCacheRecord
+{
+	uint8_t Key[16];
+	uint32_t RecordSize;
+	uint32_t CodeSize;
+	uint32_t NumPatches;
+	uint32_t NumRelocs;
+	uint32_t NumLines;
+	uint32_t UnwindSize;
+	uint32_t UnwindFunctionStart;
+	uint32_t Unused;
+	// followed by the patches, relocations, lines, code and unwind info.
+};
+
+struct JitCachePatch
+{
+	uint32_t Offset;
+	uint8_t Target;
+	uint8_t Reserved[3];
+	uint64_t Value;
+};
+
+struct JitCacheReloc
+{
+	uint32_t Offset;
+	uint8_t Type;
+	uint8_t Size;
+	uint8_t Target;
+	uint8_t Reserved;
+	uint64_t Value;
+};
+
+struct JitCacheLine
+{
+	uint32_t Offset;
+	int32_t LineNumber;
+};
+
+static struct FJitCache
+{
+	bool Opened = false;
+	bool Enabled = false;
+	bool Dirty = false;
+	bool Pruned = false;			// the file has been written without the records that got too old
+	FString CacheFile;
+	uint8_t BuildKey[16];
+	uintptr_t ImageBase = 0;
+
+	TArray<uint8_t> Data;			// the records read from the file
+	TArray<uint32_t> Offsets;
+	TArray<bool> Used;				// per entry in Offsets, whether the record was loaded this time
+	TArray<TArray<uint8_t>> Added;	// records created this time
+	TMap<uint64_t, unsigned> Index;	// first half of the key -> Offsets or, past its end, Added
+} JitCache;
+
+//==========================================================================
+//
+// The executable's load address and its file
+//
+//==========================================================================
+
+static bool FindImage(uintptr_t &base, FString &path)
+{
+#ifdef _WIN32
+	HMODULE module = GetModuleHandleW(nullptr);
+	WCHAR buffer[1024];
+	if (module == nullptr || GetModuleFileNameW(module, buffer, 1024) == 0)
+		return false;
+	buffer[1023] = 0;
+	base = (uintptr_t)module;
+	path = FString(buffer);
+#else
+	Dl_info info;
+	if (dladdr((void *)&FindImage, &info) == 0 || info.dli_fbase == nullptr)
+		return false;
+	base = (uintptr_t)info.dli_fbase;
+
+	char buffer[4096];
+	ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+	if (len > 0)
+	{
+		buffer[len] = 0;
+		path = buffer;
+	}
+	else if (info.dli_fname != nullptr)
+	{
+		path = info.dli_fname;
+	}
+	else
+	{
+		return false;
+	}
+#endif
+	return true;
+}
+
+static bool IsInImage(const void *p)
+{
+#ifdef _WIN32
+	HMODULE module;
+	if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCWSTR)p, &module))
+		return false;
+	return (uintptr_t)module == JitCache.ImageBase;
+#else
+	Dl_info info;
+	return dladdr(p, &info) != 0 && (uintptr_t)info.dli_fbase == JitCache.ImageBase;
+#endif
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool OpenJitCache()
+{
+	auto &cache = JitCache;
+	if (cache.Opened) return cache.Enabled;
+	cache.Opened = true;
+
+	if (!vm_jit_cache || Args->CheckParm("-nojitcache"))
+		return false;
+
+	FString exepath;
+	uint64_t exesize;
+	int64_t exetime;
+	if (!FindImage(cache.ImageBase, exepath) || !FileSys::FS_GetFileStamp(exepath.GetChars(), &exesize, &exetime))
+		return false;
+
+	MD5Context md5;
+	FStringf tag("%d %s %s %s %d", JITCACHE_VERSION, GetVersionString(), GetGitHash(), exepath.GetChars(), (int)sizeof(void *));
+	md5.Update((const uint8_t *)tag.GetChars(), (unsigned)tag.Len());
+	md5.Update((const uint8_t *)&exesize, sizeof(exesize));
+	md5.Update((const uint8_t *)&exetime, sizeof(exetime));
+	// The code generator picks instructions by the host's features.
+	auto &features = asmjit::CpuInfo::getHost().getFeatures();
+	md5.Update((const uint8_t *)&features, sizeof(features));
+	md5.Final(cache.BuildKey);
+
+	cache.CacheFile = M_GetCachePath(true);
+	CreatePath(cache.CacheFile.GetChars());
+	cache.CacheFile << "/jitcache.zjc";
+	cache.Enabled = true;
+
+	FileReader fr;
+	if (!fr.OpenFile(cache.CacheFile.GetChars()))
+		return true;
+
+	JitCacheHeader header;
+	auto size = fr.GetLength();
+	if (size < (ptrdiff_t)sizeof(header) || fr.Read(&header, sizeof(header)) != sizeof(header) ||
+		memcmp(header.Magic, "ZJIT", 4) != 0 || header.Version != JITCACHE_VERSION || memcmp(header.BuildKey, cache.BuildKey, 16) != 0)
+	{
+		// From another build. It will be overwritten on the next save.
+		return true;
+	}
+
+	cache.Data.Resize(unsigned(size - sizeof(header)));
+	if (fr.Read(cache.Data.Data(), cache.Data.Size()) != (ptrdiff_t)cache.Data.Size())
+	{
+		cache.Data.Clear();
+		return true;
+	}
+
+	uint32_t pos = 0;
+	for (uint32_t i = 0; i < header.NumRecords; i++)
+	{
+		if (pos + sizeof(JitCacheRecord) > cache.Data.Size()) break;
+		auto record = (const JitCacheRecord *)&cache.Data[pos];
+		size_t expected = sizeof(JitCacheRecord) + record->NumPatches * sizeof(JitCachePatch) + record->NumRelocs * sizeof(JitCacheReloc) +
+			record->NumLines * sizeof(JitCacheLine) + record->CodeSize + record->UnwindSize;
+		if (record->RecordSize < expected || pos + record->RecordSize > cache.Data.Size() || record->RecordSize % 8 != 0) break;
+
+		uint64_t key;
+		memcpy(&key, record->Key, sizeof(key));
+		cache.Index[key] = cache.Offsets.Push(pos);
+		cache.Used.Push(false);
+		pos += record->RecordSize;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Everything the code generator's output depends on
+//
+//==========================================================================
+
+static void MakeKey(VMScriptFunction *sfunc, uint8_t key[16])
+{
+	MD5Context md5;
+	auto add = [&](const void *data, size_t size) { md5.Update((const uint8_t *)data, (unsigned)size); };
+	auto addInt = [&](int64_t value) { add(&value, sizeof(value)); };
+	auto addString = [&](const char *str)
+	{
+		if (str == nullptr) str = "";
+		size_t len = strlen(str);
+		addInt(len);
+		add(str, len);
+	};
+
+	addInt(sfunc->CodeSize);
+	addInt(sfunc->NumRegD);
+	addInt(sfunc->NumRegF);
+	addInt(sfunc->NumRegS);
+	addInt(sfunc->NumRegA);
+	addInt(sfunc->NumKonstD);
+	addInt(sfunc->NumKonstF);
+	addInt(sfunc->NumKonstS);
+	addInt(sfunc->NumKonstA);
+	addInt(sfunc->MaxParam);
+	addInt(sfunc->NumArgs);
+	addInt(sfunc->StackSize);
+	addInt(sfunc->ExtraSpace);
+	addInt(sfunc->SpecialInits.Size());
+	addInt(sfunc->VarFlags);
+	addInt(sfunc->ImplicitArgs);
+	addString(sfunc->Proto ? sfunc->Proto->DescriptiveName() : nullptr);
+	add(sfunc->ArgFlags.Data(), sfunc->ArgFlags.Size() * sizeof(uint32_t));
+
+	add(sfunc->Code, sfunc->CodeSize * sizeof(VMOP));
+	add(sfunc->LineInfo, sfunc->LineInfoCount * sizeof(FStatementInfo));
+	add(sfunc->KonstD, sfunc->NumKonstD * sizeof(int));
+	add(sfunc->KonstF, sfunc->NumKonstF * sizeof(double));
+	for (int i = 0; i < sfunc->NumKonstS; i++)
+	{
+		addString(sfunc->KonstS[i].GetChars());
+	}
+
+	// Address constants are patched in, only which of them are null or the same matters.
+	for (int i = 0; i < sfunc->NumKonstA; i++)
+	{
+		int first = i;
+		for (int j = 0; j < i; j++)
+		{
+			if (sfunc->KonstA[j].v == sfunc->KonstA[i].v)
+			{
+				first = j;
+				break;
+			}
+		}
+		addInt(sfunc->KonstA[i].v == nullptr ? -1 : first);
+	}
+
+	// Direct calls are compiled according to the called function.
+	for (int i = 0; i < sfunc->CodeSize; i++)
+	{
+		if (sfunc->Code[i].op == OP_CALL_K)
+		{
+			auto target = (VMFunction *)sfunc->KonstA[sfunc->Code[i].a].v;
+			addInt(i);
+			if (target == nullptr) continue;
+			addString(target->QualifiedName);
+			addInt(target->VarFlags);
+			addInt((target->VarFlags & VARF_Native) && static_cast<VMNativeFunction *>(target)->DirectNativeCall != nullptr);
+			addString(target->Proto ? target->Proto->DescriptiveName() : nullptr);
+		}
+	}
+
+	md5.Final(key);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static bool DescribeTarget(VMScriptFunction *sfunc, const TArray<JitCallSiteCache *> &sites, uint64_t address, uint8_t &target, uint64_t &value)
+{
+	auto inTable = [&](const void *table, size_t size, uint8_t kind)
+	{
+		if (address < (uintptr_t)table || address >= (uintptr_t)table + size) return false;
+		target = kind;
+		value = address - (uintptr_t)table;
+		return true;
+	};
+
+	if (address == (uintptr_t)sfunc)
+	{
+		target = JCT_Function;
+		value = 0;
+		return true;
+	}
+	if (inTable(sfunc->KonstD, sfunc->NumKonstD * sizeof(int), JCT_KonstD) ||
+		inTable(sfunc->KonstF, sfunc->NumKonstF * sizeof(double), JCT_KonstF) ||
+		inTable(sfunc->KonstS, sfunc->NumKonstS * sizeof(FString), JCT_KonstS) ||
+		inTable(sfunc->KonstA, sfunc->NumKonstA * sizeof(FVoidObj), JCT_KonstA))
+	{
+		return true;
+	}
+	for (int i = 0; i < sfunc->NumKonstA; i++)
+	{
+		if ((uintptr_t)sfunc->KonstA[i].v == address)
+		{
+			target = JCT_KonstAValue;
+			value = i;
+			return true;
+		}
+	}
+	for (unsigned i = 0; i < sites.Size(); i++)
+	{
+		if ((uintptr_t)sites[i] == address)
+		{
+			target = JCT_CallSite;
+			value = i;
+			return true;
+		}
+	}
+	if (IsInImage((const void *)(uintptr_t)address))
+	{
+		target = JCT_Image;
+		value = address - JitCache.ImageBase;
+		return true;
+	}
+	return false;
+}
+
+static bool ResolveTarget(VMScriptFunction *sfunc, TArray<JitCallSiteCache *> &sites, uint8_t target, uint64_t value, uint64_t &address)
+{
+	auto inTable = [&](const void *table, size_t size)
+	{
+		address = (uintptr_t)table + value;
+		return value < size;
+	};
+
+	switch (target)
+	{
+	case JCT_Raw:		address = value; return true;
+	case JCT_Function:	address = (uintptr_t)sfunc; return true;
+	case JCT_KonstD:	return inTable(sfunc->KonstD, sfunc->NumKonstD * sizeof(int));
+	case JCT_KonstF:	return inTable(sfunc->KonstF, sfunc->NumKonstF * sizeof(double));
+	case JCT_KonstS:	return inTable(sfunc->KonstS, sfunc->NumKonstS * sizeof(FString));
+	case JCT_KonstA:	return inTable(sfunc->KonstA, sfunc->NumKonstA * sizeof(FVoidObj));
+	case JCT_Image:		address = JitCache.ImageBase + value; return true;
+
+	case JCT_KonstAValue:
+		if (value >= sfunc->NumKonstA) return false;
+		address = (uintptr_t)sfunc->KonstA[value].v;
+		return true;
+
+	case JCT_CallSite:
+		// Every call site is a CALL instruction, which bounds the index. The caches start out empty.
+		if (value >= (uint64_t)sfunc->CodeSize) return false;
+		while (sites.Size() <= value) sites.Push(AllocJitCallSiteCache());
+		address = (uintptr_t)sites[value];
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static const JitCacheRecord *FindRecord(const uint8_t key[16], unsigned *index = nullptr)
+{
+	auto &cache = JitCache;
+	uint64_t shortkey;
+	memcpy(&shortkey, key, sizeof(shortkey));
+	auto pos = cache.Index.CheckKey(shortkey);
+	if (pos == nullptr) return nullptr;
+
+	const JitCacheRecord *record;
+	if (*pos < cache.Offsets.Size()) record = (const JitCacheRecord *)&cache.Data[cache.Offsets[*pos]];
+	else record = (const JitCacheRecord *)cache.Added[*pos - cache.Offsets.Size()].Data();
+
+	if (memcmp(record->Key, key, 16) != 0) return nullptr;
+	if (index) *index = *pos;
+	return record;
+}
+
+JitFuncPtr JitCacheLoad(VMScriptFunction *sfunc)
+{
+	if (!OpenJitCache()) return nullptr;
+
+	uint8_t key[16];
+	MakeKey(sfunc, key);
+	unsigned index;
+	auto record = FindRecord(key, &index);
+	if (record == nullptr) return nullptr;
+
+	auto patches = (const JitCachePatch *)(record + 1);
+	auto relocs = (const JitCacheReloc *)(patches + record->NumPatches);
+	auto lines = (const JitCacheLine *)(relocs + record->NumRelocs);
+	auto code = (const uint8_t *)(lines + record->NumLines);
+	auto unwindData = code + record->CodeSize;
+
+	TArray<JitCallSiteCache *> sites;
+	TArray<uint8_t> buffer(record->CodeSize, true);
+	memcpy(buffer.Data(), code, record->CodeSize);
+	for (uint32_t i = 0; i < record->NumPatches; i++)
+	{
+		uint64_t address;
+		if (patches[i].Offset + sizeof(address) > record->CodeSize || !ResolveTarget(sfunc, sites, patches[i].Target, patches[i].Value, address))
+			return nullptr;
+		memcpy(&buffer[patches[i].Offset], &address, sizeof(address));
+	}
+
+	using namespace asmjit;
+	CodeHolder holder;
+	holder.init(GetHostCodeInfo());
+	X86Assembler assembler(&holder);
+	if (assembler.embed(buffer.Data(), buffer.Size()) != kErrorOk)
+		return nullptr;
+
+	for (uint32_t i = 0; i < record->NumRelocs; i++)
+	{
+		RelocEntry *re;
+		uint64_t address;
+		if ((uint64_t)relocs[i].Offset + relocs[i].Size > record->CodeSize)
+			return nullptr;
+		if (!ResolveTarget(sfunc, sites, relocs[i].Target, relocs[i].Value, address) || holder.newRelocEntry(&re, relocs[i].Type, relocs[i].Size) != kErrorOk)
+			return nullptr;
+
+		re->_sourceSectionId = 0;
+		re->_targetSectionId = 0;
+		re->_sourceOffset = relocs[i].Offset;
+		re->_data = address;
+		if (relocs[i].Type == RelocEntry::kTypeTrampoline)
+			holder._trampolinesSize += 8;
+	}
+
+	TArray<JitLineInfo> lineInfo(record->NumLines, true);
+	for (uint32_t i = 0; i < record->NumLines; i++)
+	{
+		lineInfo[i].InstructionIndex = lines[i].Offset;
+		lineInfo[i].LineNumber = lines[i].LineNumber;
+	}
+
+	JitUnwindInfo unwind;
+	unwind.Data.Resize(record->UnwindSize);
+	memcpy(unwind.Data.Data(), unwindData, record->UnwindSize);
+	unwind.FunctionStart = record->UnwindFunctionStart;
+
+	auto p = InstallJitFunction(&holder, unwind, sfunc, lineInfo);
+	if (p != nullptr && index < JitCache.Used.Size())
+	{
+		JitCache.Used[index] = true;
+	}
+	return reinterpret_cast<JitFuncPtr>(p);
+}
+
+//==========================================================================
+//
+// The code as asmjit left it is searched for the pointers the compiler
+// embedded. Anything below 4 GB might have been encoded in a shorter form,
+// so such functions are not cached.
+//
+//==========================================================================
+
+void JitCacheStore(JitCompiler *compiler, asmjit::CodeHolder *code, const JitUnwindInfo &unwind)
+{
+	using namespace asmjit;
+
+	if (!OpenJitCache()) return;
+
+	auto sfunc = compiler->GetScriptFunction();
+	uint8_t key[16];
+	MakeKey(sfunc, key);
+	if (FindRecord(key) != nullptr) return;
+
+	if (code->getSections().getLength() != 1) return;
+	const CodeBuffer &buffer = code->getSectionEntry(0)->getBuffer();
+	const uint8_t *bytes = buffer.getData();
+	size_t size = buffer.getLength();
+
+	struct FTarget { uint8_t Target; uint64_t Value; unsigned Found; };
+	TMap<uint64_t, FTarget> pointers;
+	for (auto ptr : compiler->EmbeddedPointers)
+	{
+		uint64_t address = (uintptr_t)ptr;
+		if (address == 0 || pointers.CheckKey(address)) continue;
+		if (address < 0x100000000ull) return;
+
+		FTarget target = { 0, 0, 0 };
+		if (!DescribeTarget(sfunc, compiler->CallSites, address, target.Target, target.Value)) return;
+		pointers[address] = target;
+	}
+
+	TArray<JitCachePatch> patches;
+	for (size_t i = 0; i + sizeof(uint64_t) <= size; i++)
+	{
+		uint64_t value;
+		memcpy(&value, bytes + i, sizeof(value));
+		if (value < 0x100000000ull) continue;
+		auto target = pointers.CheckKey(value);
+		if (target == nullptr) continue;
+
+		JitCachePatch patch = {};
+		patch.Offset = (uint32_t)i;
+		patch.Target = target->Target;
+		patch.Value = target->Value;
+		patches.Push(patch);
+		target->Found++;
+		i += sizeof(uint64_t) - 1;
+	}
+
+	decltype(pointers)::Iterator it(pointers);
+	decltype(pointers)::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		if (pair->Value.Found == 0) return;
+	}
+
+	TArray<JitCacheReloc> relocs;
+	auto &entries = code->getRelocEntries();
+	for (size_t i = 0; i < entries.getLength(); i++)
+	{
+		const RelocEntry *re = entries[i];
+		if (re->getType() == RelocEntry::kTypeNone) continue;
+		if (re->getSourceSectionId() != 0) return;
+
+		JitCacheReloc reloc = {};
+		reloc.Offset = (uint32_t)re->getSourceOffset();
+		reloc.Type = (uint8_t)re->getType();
+		reloc.Size = (uint8_t)re->getSize();
+		if (re->getType() == RelocEntry::kTypeRelToAbs)
+		{
+			reloc.Target = JCT_Raw;
+			reloc.Value = re->getData();
+		}
+		else if (re->getType() == RelocEntry::kTypeTrampoline)
+		{
+			if (!DescribeTarget(sfunc, compiler->CallSites, re->getData(), reloc.Target, reloc.Value)) return;
+		}
+		else
+		{
+			// Plain absolute to relative relocations have no range check to fall back on.
+			return;
+		}
+		relocs.Push(reloc);
+	}
+
+	TArray<JitCacheLine> lines;
+	for (auto &info : compiler->LineInfo)
+	{
+		lines.Push({ (uint32_t)info.InstructionIndex, info.LineNumber });
+	}
+
+	JitCacheRecord header = {};
+	memcpy(header.Key, key, 16);
+	header.CodeSize = (uint32_t)size;
+	header.NumPatches = patches.Size();
+	header.NumRelocs = relocs.Size();
+	header.NumLines = lines.Size();
+	header.UnwindSize = unwind.Data.Size();
+	header.UnwindFunctionStart = unwind.FunctionStart;
+
+	TArray<uint8_t> record;
+	auto append = [&](const void *data, size_t len)
+	{
+		unsigned pos = record.Reserve((unsigned)len);
+		if (len > 0) memcpy(&record[pos], data, len);
+	};
+	append(&header, sizeof(header));
+	append(patches.Data(), patches.Size() * sizeof(JitCachePatch));
+	append(relocs.Data(), relocs.Size() * sizeof(JitCacheReloc));
+	append(lines.Data(), lines.Size() * sizeof(JitCacheLine));
+	append(bytes, size);
+	append(unwind.Data.Data(), unwind.Data.Size());
+	while (record.Size() % 8) record.Push(0);
+	((JitCacheRecord *)record.Data())->RecordSize = record.Size();
+
+	auto &cache = JitCache;
+	uint64_t shortkey;
+	memcpy(&shortkey, key, sizeof(shortkey));
+	cache.Index[shortkey] = cache.Offsets.Size() + cache.Added.Size();
+	cache.Added.Push(std::move(record));
+	cache.Dirty = true;
+}
+
+//==========================================================================
+//
+// Writes all records that have not gone unused for too long. Records only
+// age in memory, the file is rewritten when one was added or gets dropped.
+//
+//==========================================================================
+
+void JitCacheSave()
+{
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+	auto &cache = JitCache;
+	if (!cache.Enabled) return;
+
+	auto unusedAfter = [&](unsigned i)
+	{
+		auto record = (const JitCacheRecord *)&cache.Data[cache.Offsets[i]];
+		return cache.Used[i] ? 0u : record->Unused + 1;
+	};
+
+	bool dropped = false;
+	for (unsigned i = 0; i < cache.Offsets.Size() && !dropped && !cache.Pruned; i++)
+	{
+		dropped = unusedAfter(i) >= MAX_UNUSED_LAUNCHES;
+	}
+	if (!cache.Dirty && !dropped) return;
+
+	TArray<uint8_t> out;
+	auto append = [&](const void *data, size_t len)
+	{
+		unsigned pos = out.Reserve((unsigned)len);
+		memcpy(&out[pos], data, len);
+	};
+
+	JitCacheHeader header = {};
+	memcpy(header.Magic, "ZJIT", 4);
+	header.Version = JITCACHE_VERSION;
+	memcpy(header.BuildKey, cache.BuildKey, 16);
+	append(&header, sizeof(header));
+
+	for (unsigned i = 0; i < cache.Offsets.Size(); i++)
+	{
+		auto record = (const JitCacheRecord *)&cache.Data[cache.Offsets[i]];
+		uint32_t unused = unusedAfter(i);
+		if (unused >= MAX_UNUSED_LAUNCHES) continue;
+		unsigned pos = out.Size();
+		append(record, record->RecordSize);
+		((JitCacheRecord *)&out[pos])->Unused = unused;
+		header.NumRecords++;
+	}
+	for (auto &record : cache.Added)
+	{
+		append(record.Data(), record.Size());
+		header.NumRecords++;
+	}
+	memcpy(out.Data(), &header, sizeof(header));
+
+	// Written next to the old file and moved over it, so an interrupted save cannot leave a truncated cache behind.
+	FString tempFile = cache.CacheFile + ".tmp";
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(tempFile.GetChars()));
+	if (fw != nullptr)
+	{
+		bool written = fw->Write(out.Data(), out.Size()) == out.Size();
+		fw.reset();
+		if (written) FileSys::FS_ReplaceFile(tempFile.GetChars(), cache.CacheFile.GetChars());
+	}
+	cache.Dirty = false;
+	cache.Pruned = true;
+}
@@ -42,7 +42,22 @@ void JitCompiler::EmitVtbl(const VMOP *op)
 
 void JitCompiler::EmitCALL()
 {
-	EmitVMCall(regA[A], nullptr);
+	if (pc > sfunc->Code && (pc - 1)->op == OP_VTBL)
+	{
+		if (CanCacheVirtualCall())
+		{
+			EmitCachedVirtualCall(pc - 1);
+		}
+		else
+		{
+			EmitVtbl(pc - 1);
+			EmitVMCall(regA[A], nullptr);
+		}
+	}
+	else
+	{
+		EmitVMCall(regA[A], nullptr);
+	}
 	pc += C; // Skip RESULTs
 }
 
@@ -61,7 +76,7 @@ void JitCompiler::EmitCALL_K()
 	else
 	{
 		auto ptr = newTempIntPtr();
-		cc.mov(ptr, asmjit::imm_ptr(target));
+		cc.mov(ptr, ImmPtr(target));
 		EmitVMCall(ptr, target);
 	}
 
@@ -78,9 +93,6 @@ void JitCompiler::EmitVMCall(asmjit::X86Gp vmfunc, VMFunction *target)
 	if (numparams != B)
 		I_Error("OP_CALL parameter count does not match the number of preceding OP_PARAM instructions");
 
-	if (pc > sfunc->Code && (pc - 1)->op == OP_VTBL)
-		EmitVtbl(pc - 1);
-
 	FillReturns(pc + 1, C);
 
 	X86Gp paramsptr = newTempIntPtr();
@@ -105,6 +117,96 @@ void JitCompiler::EmitVMCall(asmjit::X86Gp vmfunc, VMFunction *target)
 	ParamOpcodes.Clear();
 }
 
+// The parameters only decide whether the direct call can be made, not which function is called,
+// so a site qualifies if a native function with a direct entry point could be called from it.
+bool JitCompiler::CanCacheVirtualCall()
+{
+	for (auto param : ParamOpcodes)
+	{
+		if (param->op == OP_PARAM && (param->a & REGT_ADDROF) && (param->a & REGT_TYPE) != REGT_STRING)
+			return false;
+	}
+	return true;
+}
+
+static void UpdateCallSiteCache(JitCallSiteCache *cache, PClass *cls, VMFunction *func)
+{
+	auto &entry = cache->Entries[cache->Misses % JitCallSiteCache::NumEntries];
+	entry.Class = cls;
+	entry.Func = func;
+	entry.DirectNativeCall = (func->VarFlags & VARF_Native) ? static_cast<VMNativeFunction *>(func)->DirectNativeCall : nullptr;
+	cache->Misses++;
+}
+
+void JitCompiler::EmitCachedVirtualCall(const VMOP *op)
+{
+	using namespace asmjit;
+
+	auto cache = AllocJitCallSiteCache();
+	CallSites.Push(cache);
+
+	X86Gp self = regA[op->b];
+	X86Gp func = regA[op->a];
+
+	auto label = EmitThrowExceptionLabel(X_READ_NIL);
+	cc.test(self, self);
+	cc.jz(label);
+
+	auto cls = newTempIntPtr();
+	auto cacheptr = newTempIntPtr();
+	auto entry = newTempIntPtr();
+	auto nativeptr = newTempIntPtr();
+	cc.mov(cls, x86::qword_ptr(self, myoffsetof(DObject, Class)));
+	cc.mov(cacheptr, ImmPtr(cache));
+
+	Label hits[JitCallSiteCache::NumEntries];
+	for (int i = 0; i < JitCallSiteCache::NumEntries; i++)
+	{
+		hits[i] = cc.newLabel();
+		cc.cmp(cls, x86::qword_ptr(cacheptr, myoffsetof(JitCallSiteCache, Entries) + i * (int)sizeof(JitCallSiteCache::Entry) + myoffsetof(JitCallSiteCache::Entry, Class)));
+		cc.je(hits[i]);
+	}
+
+	// Miss: resolve through the vtable and remember the result
+	auto hit = cc.newLabel();
+	auto native = cc.newLabel();
+	auto generic = cc.newLabel();
+	auto done = cc.newLabel();
+	cc.mov(func, x86::qword_ptr(cls, myoffsetof(PClass, Virtuals) + myoffsetof(FArray, Array)));
+	cc.mov(func, x86::qword_ptr(func, op->c * (int)sizeof(void*)));
+	cc.cmp(x86::dword_ptr(cacheptr, myoffsetof(JitCallSiteCache, Misses)), (int)JitCallSiteCache::MaxMisses);
+	cc.jae(generic);
+	auto update = CreateCall<void, JitCallSiteCache *, PClass *, VMFunction *>(UpdateCallSiteCache);
+	update->setArg(0, cacheptr);
+	update->setArg(1, cls);
+	update->setArg(2, func);
+	cc.jmp(generic);
+
+	for (int i = 0; i < JitCallSiteCache::NumEntries; i++)
+	{
+		cc.bind(hits[i]);
+		cc.lea(entry, x86::ptr(cacheptr, myoffsetof(JitCallSiteCache, Entries) + i * (int)sizeof(JitCallSiteCache::Entry)));
+		cc.jmp(hit);
+	}
+
+	cc.bind(hit);
+	cc.mov(func, x86::qword_ptr(entry, myoffsetof(JitCallSiteCache::Entry, Func)));
+	cc.mov(nativeptr, x86::qword_ptr(entry, myoffsetof(JitCallSiteCache::Entry, DirectNativeCall)));
+	cc.test(nativeptr, nativeptr);
+	cc.jnz(native);
+	cc.jmp(generic);
+
+	// All overrides share the prototype, so any direct entry point fits the signature of this site.
+	cc.bind(native);
+	EmitDirectNativeCall(nativeptr, "inline cached call");
+	cc.jmp(done);
+
+	cc.bind(generic);
+	EmitVMCall(func, nullptr);
+
+	cc.bind(done);
+}
+
 int JitCompiler::StoreCallParams()
 {
 	using namespace asmjit;
@@ -150,7 +252,7 @@ int JitCompiler::StoreCallParams()
 			cc.mov(x86::ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, a)), regS[bc]);
 			break;
 		case REGT_STRING | REGT_KONST:
-			cc.mov(tmp, asmjit::imm_ptr(&konsts[bc]));
+			cc.mov(tmp, ImmPtr(&konsts[bc]));
 			cc.mov(x86::ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, sp)), tmp);
 			break;
 		case REGT_POINTER:
@@ -162,7 +264,7 @@ int JitCompiler::StoreCallParams()
 			cc.mov(x86::ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, a)), stackPtr);
 			break;
 		case REGT_POINTER | REGT_KONST:
-			cc.mov(tmp, asmjit::imm_ptr(konsta[bc].v));
+			cc.mov(tmp, ImmPtr(konsta[bc].v));
 			cc.mov(x86::ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, a)), tmp);
 			break;
 		case REGT_FLOAT:
@@ -200,7 +302,7 @@ int JitCompiler::StoreCallParams()
 			cc.mov(x86::ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, a)), stackPtr);
 			break;
 		case REGT_FLOAT | REGT_KONST:
-			cc.mov(tmp, asmjit::imm_ptr(konstf + bc));
+			cc.mov(tmp, ImmPtr(konstf + bc));
 			cc.movsd(tmp2, asmjit::x86::qword_ptr(tmp));
 			cc.movsd(x86::qword_ptr(vmframe, offsetParams + slot * sizeof(VMValue) + myoffsetof(VMValue, f)), tmp2);
 			break;
@@ -358,9 +460,17 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 		cc.jz(label);
 	}
 
+	EmitDirectNativeCall(imm_ptr(target->DirectNativeCall), target->PrintableName);
+	ParamOpcodes.Clear();
+}
+
+void JitCompiler::EmitDirectNativeCall(const asmjit::Operand &callee, const char *comment)
+{
+	using namespace asmjit;
+
 	asmjit::CBNode *cursorBefore = cc.getCursor();
-	auto call = cc.call(imm_ptr(target->DirectNativeCall), CreateFuncSignature());
-	call->setInlineComment(target->PrintableName);
+	auto call = cc.addCall(X86Inst::kIdCall, callee, CreateFuncSignature());
+	call->setInlineComment(comment);
 	asmjit::CBNode *cursorAfter = cc.getCursor();
 	cc.setCursor(cursorBefore);
 
@@ -397,7 +507,7 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 				break;
 			case REGT_STRING | REGT_KONST:
 				tmp = newTempIntPtr();
-				cc.mov(tmp, imm_ptr(&konsts[bc]));
+				cc.mov(tmp, ImmPtr(&konsts[bc]));
 				call->setArg(slot, tmp);
 				break;
 			case REGT_POINTER:
@@ -405,7 +515,7 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 				break;
 			case REGT_POINTER | REGT_KONST:
 				tmp = newTempIntPtr();
-				cc.mov(tmp, imm_ptr(konsta[bc].v));
+				cc.mov(tmp, ImmPtr(konsta[bc].v));
 				call->setArg(slot, tmp);
 				break;
 			case REGT_FLOAT:
@@ -429,7 +539,7 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 			case REGT_FLOAT | REGT_KONST:
 				tmp = newTempIntPtr();
 				tmp2 = newTempXmmSd();
-				cc.mov(tmp, asmjit::imm_ptr(konstf + bc));
+				cc.mov(tmp, ImmPtr(konstf + bc));
 				cc.movsd(tmp2, asmjit::x86::qword_ptr(tmp));
 				call->setArg(slot, tmp2);
 				break;
@@ -585,8 +695,6 @@ void JitCompiler::EmitNativeCall(VMNativeFunction *target)
 			break;
 		}
 	}
-
-	ParamOpcodes.Clear();
 }
 
 static std::map<FString, std::unique_ptr<TArray<uint8_t>>> argsCache;
@@ -57,7 +57,7 @@ void JitCompiler::EmitSCOPE()
 	cc.jz(label);
 
 	auto f = newTempIntPtr();
-	cc.mov(f, asmjit::imm_ptr(konsta[C].v));
+	cc.mov(f, ImmPtr(konsta[C].v));
 
 	typedef int(*FuncPtr)(DObject*, VMFunction*, int);
 	auto call = CreateCall<void, DObject*, VMFunction*, int>(ValidateCall);
@@ -182,7 +182,7 @@ void JitCompiler::EmitRET()
 			cc.add(ptr, (int)(retnum * sizeof(VMReturn)));
 			auto call = CreateCall<void, VMReturn*, FString*>(SetString);
 			call->setArg(0, ptr);
-			if (regtype & REGT_KONST) call->setArg(1, asmjit::imm_ptr(&konsts[regnum]));
+			if (regtype & REGT_KONST) call->setArg(1, ImmPtr(&konsts[regnum]));
 			else                      call->setArg(1, regS[regnum]);
 			break;
 		}
@@ -192,7 +192,7 @@ void JitCompiler::EmitRET()
 				if (regtype & REGT_KONST)
 				{
 					auto ptr = newTempIntPtr();
-					cc.mov(ptr, asmjit::imm_ptr(konsta[regnum].v));
+					cc.mov(ptr, ImmPtr(konsta[regnum].v));
 					cc.mov(x86::qword_ptr(location), ptr);
 				}
 				else
@@ -205,7 +205,7 @@ void JitCompiler::EmitRET()
 				if (regtype & REGT_KONST)
 				{
 					auto ptr = newTempIntPtr();
-					cc.mov(ptr, asmjit::imm_ptr(konsta[regnum].v));
+					cc.mov(ptr, ImmPtr(konsta[regnum].v));
 					cc.mov(x86::dword_ptr(location), ptr);
 				}
 				else
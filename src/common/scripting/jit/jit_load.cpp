@@ -17,7 +17,7 @@ void JitCompiler::EmitLK()
 void JitCompiler::EmitLKF()
 {
 	auto base = newTempIntPtr();
-	cc.mov(base, asmjit::imm_ptr(konstf + BC));
+	cc.mov(base, ImmPtr(konstf + BC));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(base));
 }
 
@@ -25,32 +25,32 @@ void JitCompiler::EmitLKS()
 {
 	auto call = CreateCall<void, FString*, FString*>(&JitCompiler::CallAssignString);
 	call->setArg(0, regS[A]);
-	call->setArg(1, asmjit::imm_ptr(konsts + BC));
+	call->setArg(1, ImmPtr(konsts + BC));
 }
 
 void JitCompiler::EmitLKP()
 {
-	cc.mov(regA[A], (int64_t)konsta[BC].v);
+	cc.mov(regA[A], ImmPtr(konsta[BC].v));
 }
 
 void JitCompiler::EmitLK_R()
 {
 	auto base = newTempIntPtr();
-	cc.mov(base, asmjit::imm_ptr(konstd + C));
+	cc.mov(base, ImmPtr(konstd + C));
 	cc.mov(regD[A], asmjit::x86::ptr(base, regD[B], 2));
 }
 
 void JitCompiler::EmitLKF_R()
 {
 	auto base = newTempIntPtr();
-	cc.mov(base, asmjit::imm_ptr(konstf + C));
+	cc.mov(base, ImmPtr(konstf + C));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(base, regD[B], 3));
 }
 
 void JitCompiler::EmitLKS_R()
 {
 	auto base = newTempIntPtr();
-	cc.mov(base, asmjit::imm_ptr(konsts + C));
+	cc.mov(base, ImmPtr(konsts + C));
 	auto ptr = newTempIntPtr();
 	if (cc.is64Bit())
 		cc.lea(ptr, asmjit::x86::ptr(base, regD[B], 3));
@@ -64,7 +64,7 @@ void JitCompiler::EmitLKS_R()
 void JitCompiler::EmitLKP_R()
 {
 	auto base = newTempIntPtr();
-	cc.mov(base, asmjit::imm_ptr(konsta + C));
+	cc.mov(base, ImmPtr(konsta + C));
 	if (cc.is64Bit())
 		cc.mov(regA[A], asmjit::x86::ptr(base, regD[B], 3));
 	else
@@ -52,10 +52,10 @@ void JitCompiler::EmitCMPS()
 		auto result = newResultInt32();
 		call->setRet(0, result);
 
-		if (static_cast<bool>(A & CMP_BK)) call->setArg(0, asmjit::imm_ptr(&konsts[B]));
+		if (static_cast<bool>(A & CMP_BK)) call->setArg(0, ImmPtr(&konsts[B]));
 		else                               call->setArg(0, regS[B]);
 
-		if (static_cast<bool>(A & CMP_CK)) call->setArg(1, asmjit::imm_ptr(&konsts[C]));
+		if (static_cast<bool>(A & CMP_CK)) call->setArg(1, ImmPtr(&konsts[C]));
 		else                               call->setArg(1, regS[C]);
 
 		int method = A & CMP_METHOD_MASK;
@@ -229,7 +229,7 @@ void JitCompiler::EmitDIV_RK()
 		auto konstTmp = newTempIntPtr();
 		cc.mov(tmp0, regD[B]);
 		cc.cdq(tmp1, tmp0);
-		cc.mov(konstTmp, asmjit::imm_ptr(&konstd[C]));
+		cc.mov(konstTmp, ImmPtr(&konstd[C]));
 		cc.idiv(tmp1, tmp0, asmjit::x86::ptr(konstTmp));
 		cc.mov(regD[A], tmp0);
 	}
@@ -278,7 +278,7 @@ void JitCompiler::EmitDIVU_RK()
 		auto konstTmp = newTempIntPtr();
 		cc.mov(tmp0, regD[B]);
 		cc.mov(tmp1, 0);
-		cc.mov(konstTmp, asmjit::imm_ptr(&konstd[C]));
+		cc.mov(konstTmp, ImmPtr(&konstd[C]));
 		cc.div(tmp1, tmp0, asmjit::x86::ptr(konstTmp));
 		cc.mov(regD[A], tmp0);
 	}
@@ -327,7 +327,7 @@ void JitCompiler::EmitMOD_RK()
 		auto konstTmp = newTempIntPtr();
 		cc.mov(tmp0, regD[B]);
 		cc.cdq(tmp1, tmp0);
-		cc.mov(konstTmp, asmjit::imm_ptr(&konstd[C]));
+		cc.mov(konstTmp, ImmPtr(&konstd[C]));
 		cc.idiv(tmp1, tmp0, asmjit::x86::ptr(konstTmp));
 		cc.mov(regD[A], tmp1);
 	}
@@ -376,7 +376,7 @@ void JitCompiler::EmitMODU_RK()
 		auto konstTmp = newTempIntPtr();
 		cc.mov(tmp0, regD[B]);
 		cc.mov(tmp1, 0);
-		cc.mov(konstTmp, asmjit::imm_ptr(&konstd[C]));
+		cc.mov(konstTmp, ImmPtr(&konstd[C]));
 		cc.div(tmp1, tmp0, asmjit::x86::ptr(konstTmp));
 		cc.mov(regD[A], tmp1);
 	}
@@ -587,7 +587,7 @@ void JitCompiler::EmitLT_KR()
 {
 	EmitComparisonOpcode([&](bool check, asmjit::Label& fail, asmjit::Label& success) {
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstd[B]));
+		cc.mov(tmp, ImmPtr(&konstd[B]));
 		cc.cmp(asmjit::x86::ptr(tmp), regD[C]);
 		if (check) cc.jl(fail);
 		else       cc.jnl(fail);
@@ -616,7 +616,7 @@ void JitCompiler::EmitLE_KR()
 {
 	EmitComparisonOpcode([&](bool check, asmjit::Label& fail, asmjit::Label& success) {
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstd[B]));
+		cc.mov(tmp, ImmPtr(&konstd[B]));
 		cc.cmp(asmjit::x86::ptr(tmp), regD[C]);
 		if (check) cc.jle(fail);
 		else       cc.jnle(fail);
@@ -645,7 +645,7 @@ void JitCompiler::EmitLTU_KR()
 {
 	EmitComparisonOpcode([&](bool check, asmjit::Label& fail, asmjit::Label& success) {
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstd[B]));
+		cc.mov(tmp, ImmPtr(&konstd[B]));
 		cc.cmp(asmjit::x86::ptr(tmp), regD[C]);
 		if (check) cc.jb(fail);
 		else       cc.jnb(fail);
@@ -674,7 +674,7 @@ void JitCompiler::EmitLEU_KR()
 {
 	EmitComparisonOpcode([&](bool check, asmjit::Label& fail, asmjit::Label& success) {
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstd[B]));
+		cc.mov(tmp, ImmPtr(&konstd[B]));
 		cc.cmp(asmjit::x86::ptr(tmp), regD[C]);
 		if (check) cc.jbe(fail);
 		else       cc.jnbe(fail);
@@ -697,7 +697,7 @@ void JitCompiler::EmitADDF_RK()
 	auto tmp = newTempIntPtr();
 	if (A != B)
 		cc.movsd(regF[A], regF[B]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.addsd(regF[A], asmjit::x86::qword_ptr(tmp));
 }
 
@@ -714,7 +714,7 @@ void JitCompiler::EmitSUBF_RK()
 	auto tmp = newTempIntPtr();
 	if (A != B)
 		cc.movsd(regF[A], regF[B]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.subsd(regF[A], asmjit::x86::qword_ptr(tmp));
 }
 
@@ -722,7 +722,7 @@ void JitCompiler::EmitSUBF_KR()
 {
 	auto rc = CheckRegF(C, A);
 	auto tmp = newTempIntPtr();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[B]));
+	cc.mov(tmp, ImmPtr(&konstf[B]));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.subsd(regF[A], rc);
 }
@@ -740,7 +740,7 @@ void JitCompiler::EmitMULF_RK()
 	auto tmp = newTempIntPtr();
 	if (A != B)
 		cc.movsd(regF[A], regF[B]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 }
 
@@ -767,7 +767,7 @@ void JitCompiler::EmitDIVF_RK()
 	{
 		auto tmp = newTempIntPtr();
 		cc.movsd(regF[A], regF[B]);
-		cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+		cc.mov(tmp, ImmPtr(&konstf[C]));
 		cc.divsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	}
 }
@@ -776,7 +776,7 @@ void JitCompiler::EmitDIVF_KR()
 {
 	auto rc = CheckRegF(C, A);
 	auto tmp = newTempIntPtr();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[B]));
+	cc.mov(tmp, ImmPtr(&konstf[B]));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A], rc);
 }
@@ -811,7 +811,7 @@ void JitCompiler::EmitMODF_RK()
 	else
 	{
 		auto tmpPtr = newTempIntPtr();
-		cc.mov(tmpPtr, asmjit::imm_ptr(&konstf[C]));
+		cc.mov(tmpPtr, ImmPtr(&konstf[C]));
 
 		auto tmp = newTempXmmSd();
 		cc.movsd(tmp, asmjit::x86::qword_ptr(tmpPtr));
@@ -836,7 +836,9 @@ void JitCompiler::EmitMODF_KR()
 	cc.je(label);
 
 	auto tmp = newTempXmmSd();
-	cc.movsd(tmp, x86::ptr(ToMemAddress(&konstf[B])));
+	auto tmpPtr = newTempIntPtr();
+	cc.mov(tmpPtr, ImmPtr(&konstf[B]));
+	cc.movsd(tmp, x86::qword_ptr(tmpPtr));
 
 	auto result = newResultXmmSd();
 	auto call = CreateCall<double, double, double>(DoubleModF);
@@ -860,7 +862,7 @@ void JitCompiler::EmitPOWF_RK()
 {
 	auto tmp = newTempIntPtr();
 	auto tmp2 = newTempXmmSd();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.movsd(tmp2, asmjit::x86::qword_ptr(tmp));
 
 	auto result = newResultXmmSd();
@@ -875,7 +877,7 @@ void JitCompiler::EmitPOWF_KR()
 {
 	auto tmp = newTempIntPtr();
 	auto tmp2 = newTempXmmSd();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[B]));
+	cc.mov(tmp, ImmPtr(&konstf[B]));
 	cc.movsd(tmp2, asmjit::x86::qword_ptr(tmp));
 
 	auto result = newResultXmmSd();
@@ -898,7 +900,7 @@ void JitCompiler::EmitMINF_RK()
 {
 	auto rb = CheckRegF(B, A);
 	auto tmp = newTempIntPtr();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.minpd(regF[A], rb); // minsd requires SSE 4.1
 }
@@ -915,7 +917,7 @@ void JitCompiler::EmitMAXF_RK()
 {
 	auto rb = CheckRegF(B, A);
 	auto tmp = newTempIntPtr();
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.movsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.maxpd(regF[A], rb); // maxsd requires SSE 4.1
 }
@@ -931,7 +933,7 @@ void JitCompiler::EmitATAN2()
 
 	static const double constant = 180 / M_PI;
 	auto tmp = newTempIntPtr();
-	cc.mov(tmp, asmjit::imm_ptr(&constant));
+	cc.mov(tmp, ImmPtr(&constant));
 	cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 }
 
@@ -955,7 +957,7 @@ void JitCompiler::EmitFLOP()
 		{
 			static const double constant = M_PI / 180;
 			auto tmp = newTempIntPtr();
-			cc.mov(tmp, asmjit::imm_ptr(&constant));
+			cc.mov(tmp, ImmPtr(&constant));
 			cc.mulsd(v, asmjit::x86::qword_ptr(tmp));
 		}
 
@@ -999,7 +1001,7 @@ void JitCompiler::EmitFLOP()
 		{
 			static const double constant = 180 / M_PI;
 			auto tmp = newTempIntPtr();
-			cc.mov(tmp, asmjit::imm_ptr(&constant));
+			cc.mov(tmp, ImmPtr(&constant));
 			cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 		}
 	}
@@ -1052,7 +1054,7 @@ void JitCompiler::EmitEQF_K()
 		bool approx = static_cast<bool>(A & CMP_APPROX);
 		if (!approx) {
 			auto konstTmp = newTempIntPtr();
-			cc.mov(konstTmp, asmjit::imm_ptr(&konstf[C]));
+			cc.mov(konstTmp, ImmPtr(&konstf[C]));
 			cc.ucomisd(regF[B], x86::qword_ptr(konstTmp));
 			if (check) {
 				cc.jp(success);
@@ -1074,7 +1076,7 @@ void JitCompiler::EmitEQF_K()
 			auto epsilon = cc.newDoubleConst(kConstScopeLocal, VM_EPSILON);
 			auto epsilonXmm = newTempXmmSd();
 
-			cc.mov(konstTmp, asmjit::imm_ptr(&konstf[C]));
+			cc.mov(konstTmp, ImmPtr(&konstf[C]));
 
 			cc.movsd(subTmp, regF[B]);
 			cc.subsd(subTmp, x86::qword_ptr(konstTmp));
@@ -1107,7 +1109,7 @@ void JitCompiler::EmitLTF_RK()
 
 		auto constTmp = newTempIntPtr();
 		auto xmmTmp = newTempXmmSd();
-		cc.mov(constTmp, asmjit::imm_ptr(&konstf[C]));
+		cc.mov(constTmp, ImmPtr(&konstf[C]));
 		cc.movsd(xmmTmp, asmjit::x86::qword_ptr(constTmp));
 
 		cc.ucomisd(xmmTmp, regF[B]);
@@ -1122,7 +1124,7 @@ void JitCompiler::EmitLTF_KR()
 		if (static_cast<bool>(A & CMP_APPROX)) I_Error("CMP_APPROX not implemented for LTF_KR.\n");
 
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstf[B]));
+		cc.mov(tmp, ImmPtr(&konstf[B]));
 
 		cc.ucomisd(regF[C], asmjit::x86::qword_ptr(tmp));
 		if (check) cc.ja(fail);
@@ -1148,7 +1150,7 @@ void JitCompiler::EmitLEF_RK()
 
 		auto constTmp = newTempIntPtr();
 		auto xmmTmp = newTempXmmSd();
-		cc.mov(constTmp, asmjit::imm_ptr(&konstf[C]));
+		cc.mov(constTmp, ImmPtr(&konstf[C]));
 		cc.movsd(xmmTmp, asmjit::x86::qword_ptr(constTmp));
 
 		cc.ucomisd(xmmTmp, regF[B]);
@@ -1163,7 +1165,7 @@ void JitCompiler::EmitLEF_KR()
 		if (static_cast<bool>(A & CMP_APPROX)) I_Error("CMP_APPROX not implemented for LEF_KR.\n");
 
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(&konstf[B]));
+		cc.mov(tmp, ImmPtr(&konstf[B]));
 
 		cc.ucomisd(regF[C], asmjit::x86::qword_ptr(tmp));
 		if (check) cc.jae(fail);
@@ -1231,7 +1233,7 @@ void JitCompiler::EmitMULVF2_RK()
 	auto tmp = newTempIntPtr();
 	cc.movsd(regF[A], regF[B]);
 	cc.movsd(regF[A + 1], regF[B + 1]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.mulsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 }
@@ -1250,7 +1252,7 @@ void JitCompiler::EmitDIVVF2_RK()
 	auto tmp = newTempIntPtr();
 	cc.movsd(regF[A], regF[B]);
 	cc.movsd(regF[A + 1], regF[B + 1]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.divsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 }
@@ -1390,7 +1392,7 @@ void JitCompiler::EmitMULVF3_RK()
 	cc.movsd(regF[A], regF[B]);
 	cc.movsd(regF[A + 1], regF[B + 1]);
 	cc.movsd(regF[A + 2], regF[B + 2]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.mulsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 	cc.mulsd(regF[A + 2], asmjit::x86::qword_ptr(tmp));
@@ -1413,7 +1415,7 @@ void JitCompiler::EmitDIVVF3_RK()
 	cc.movsd(regF[A], regF[B]);
 	cc.movsd(regF[A + 1], regF[B + 1]);
 	cc.movsd(regF[A + 2], regF[B + 2]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.divsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A + 2], asmjit::x86::qword_ptr(tmp));
@@ -1540,7 +1542,7 @@ void JitCompiler::EmitMULVF4_RK()
 	cc.movsd(regF[A + 1], regF[B + 1]);
 	cc.movsd(regF[A + 2], regF[B + 2]);
 	cc.movsd(regF[A + 3], regF[B + 3]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.mulsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.mulsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 	cc.mulsd(regF[A + 2], asmjit::x86::qword_ptr(tmp));
@@ -1567,7 +1569,7 @@ void JitCompiler::EmitDIVVF4_RK()
 	cc.movsd(regF[A + 1], regF[B + 1]);
 	cc.movsd(regF[A + 2], regF[B + 2]);
 	cc.movsd(regF[A + 3], regF[B + 3]);
-	cc.mov(tmp, asmjit::imm_ptr(&konstf[C]));
+	cc.mov(tmp, ImmPtr(&konstf[C]));
 	cc.divsd(regF[A], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A + 1], asmjit::x86::qword_ptr(tmp));
 	cc.divsd(regF[A + 2], asmjit::x86::qword_ptr(tmp));
@@ -1722,7 +1724,7 @@ void JitCompiler::EmitEQA_K()
 {
 	EmitComparisonOpcode([&](bool check, asmjit::Label& fail, asmjit::Label& success) {
 		auto tmp = newTempIntPtr();
-		cc.mov(tmp, asmjit::imm_ptr(konsta[C].v));
+		cc.mov(tmp, ImmPtr(konsta[C].v));
 		cc.cmp(regA[B], tmp);
 		if (check) cc.je(fail);
 		else       cc.jne(fail);
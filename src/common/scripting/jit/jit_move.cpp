@@ -252,7 +252,7 @@ void JitCompiler::EmitDYNCAST_K()
 {
 	auto result = newResultIntPtr();
 	auto c = newTempIntPtr();
-	cc.mov(c, asmjit::imm_ptr(konsta[C].o));
+	cc.mov(c, ImmPtr(konsta[C].o));
 	auto call = CreateCall<DObject*, DObject*, PClass*>(DynCast);
 	call->setRet(0, result);
 	call->setArg(0, regA[B]);
@@ -280,7 +280,7 @@ void JitCompiler::EmitDYNCASTC_K()
 	using namespace asmjit;
 	auto result = newResultIntPtr();
 	auto c = newTempIntPtr();
-	cc.mov(c, asmjit::imm_ptr(konsta[C].o));
+	cc.mov(c, ImmPtr(konsta[C].o));
 	typedef PClass*(*FuncPtr)(PClass*, PClass*);
 	auto call = CreateCall<PClass*, PClass*, PClass*>(DynCastC);
 	call->setRet(0, result);
@@ -23,7 +23,10 @@ struct JitFuncInfo
 	void *end;
 };
 
+std::recursive_mutex JitMutex;
+
 static TArray<JitFuncInfo> JitDebugInfo;
+static FMemArena JitCallSiteArena;
 static TArray<uint8_t*> JitBlocks;
 static TArray<uint8_t*> JitFrames;
 static size_t JitBlockPos = 0;
@@ -44,6 +47,11 @@ asmjit::CodeInfo GetHostCodeInfo()
 	return codeInfo;
 }
 
+JitCallSiteCache *AllocJitCallSiteCache()
+{
+	return (JitCallSiteCache *)JitCallSiteArena.Calloc(sizeof(JitCallSiteCache));
+}
+
 static void *AllocJitMemory(size_t size)
 {
 	using namespace asmjit;
@@ -259,13 +267,27 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	CCFunc *func = compiler->Codegen();
 
+	JitUnwindInfo unwind;
+#ifdef _WIN64
+	TArray<uint16_t> unwindCodes = CreateUnwindInfoWindows(func);
+	unwind.Data.Resize(unwindCodes.Size() * sizeof(uint16_t));
+	memcpy(unwind.Data.Data(), unwindCodes.Data(), unwind.Data.Size());
+#endif
+
+	void *p = InstallJitFunction(code, unwind, compiler->GetScriptFunction(), compiler->LineInfo);
+	if (p)
+		JitCacheStore(compiler, code, unwind);
+	return p;
+}
+
+void *InstallJitFunction(asmjit::CodeHolder *code, const JitUnwindInfo &unwind, VMScriptFunction *sfunc, const TArray<JitLineInfo> &lineInfo)
+{
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
 
 #ifdef _WIN64
-	TArray<uint16_t> unwindInfo = CreateUnwindInfoWindows(func);
-	size_t unwindInfoSize = unwindInfo.Size() * sizeof(uint16_t);
+	size_t unwindInfoSize = unwind.Data.Size();
 	size_t functionTableSize = sizeof(RUNTIME_FUNCTION);
 #else
 	size_t unwindInfoSize = 0;
@@ -291,7 +313,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	uint8_t *startaddr = p;
 	uint8_t *endaddr = p + relocSize;
 	uint8_t *unwindptr = p + unwindStart;
-	memcpy(unwindptr, &unwindInfo[0], unwindInfoSize);
+	memcpy(unwindptr, unwind.Data.Data(), unwindInfoSize);
 
 	RUNTIME_FUNCTION *table = (RUNTIME_FUNCTION*)(unwindptr + unwindInfoSize);
 	table[0].BeginAddress = (DWORD)(ptrdiff_t)(startaddr - baseaddr);
@@ -306,7 +328,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ FString(compiler->GetScriptFunction()->PrintableName), compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Copy the file name instead of sharing the buffer, as this may run on a worker thread.
+	JitDebugInfo.Push({ FString(sfunc->PrintableName), sfunc->SourceFileName.GetChars(), lineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -655,12 +678,23 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 	CCFunc *func = compiler->Codegen();
 
+	JitUnwindInfo unwind;
+	unwind.Data = CreateUnwindInfoUnix(func, unwind.FunctionStart);
+
+	void *p = InstallJitFunction(code, unwind, compiler->GetScriptFunction(), compiler->LineInfo);
+	if (p)
+		JitCacheStore(compiler, code, unwind);
+	return p;
+}
+
+void *InstallJitFunction(asmjit::CodeHolder *code, const JitUnwindInfo &unwind, VMScriptFunction *sfunc, const TArray<JitLineInfo> &lineInfo)
+{
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
 
-	unsigned int fdeFunctionStart = 0;
-	TArray<uint8_t> unwindInfo = CreateUnwindInfoUnix(func, fdeFunctionStart);
+	const TArray<uint8_t> &unwindInfo = unwind.Data;
+	unsigned int fdeFunctionStart = unwind.FunctionStart;
 	size_t unwindInfoSize = unwindInfo.Size();
 
 	codeSize = (codeSize + 15) / 16 * 16;
@@ -730,7 +764,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Copy the file name instead of sharing the buffer, as this may run on a worker thread.
+	JitDebugInfo.Push({ sfunc->PrintableName, sfunc->SourceFileName.GetChars(), lineInfo, startaddr, endaddr });
 
 	return p;
 }
@@ -738,6 +773,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
+	JitCacheSave();
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -754,6 +791,7 @@ void JitRelease()
 		asmjit::OSUtils::releaseVirtualMemory(p, 1024 * 1024);
 	}
 	JitDebugInfo.Clear();
+	JitCallSiteArena.FreeAllBlocks();
 	JitFrames.Clear();
 	JitBlocks.Clear();
 	JitBlockPos = 0;
@@ -975,6 +1013,7 @@ FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int max
 	if (includeNativeFrames)
 		nativeSymbols.reset(new NativeSymbolResolver());
 
+	std::lock_guard<std::recursive_mutex> lock(JitMutex);
 	int total = 0;
 	FString s;
 	for (int i = framesToSkip + 1; i < numframes; i++)
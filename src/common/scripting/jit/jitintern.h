@@ -11,6 +11,7 @@
 #include <asmjit/asmjit.h>
 #include <asmjit/x86.h>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 extern cycle_t VMCycles[10];
@@ -32,6 +33,29 @@ struct JitLineInfo
 	asmjit::Label Label;
 };
 
+// Inline cache of a virtual call site. Holds the last classes seen there and the functions they
+// resolved to, so a hit needs neither the vtable nor, for natives with a direct entry point, any VMValue packing.
+struct JitCallSiteCache
+{
+	enum
+	{
+		NumEntries = 4,
+		MaxMisses = 64,	// sites that keep missing are megamorphic and stop updating
+	};
+
+	struct Entry
+	{
+		PClass *Class;
+		VMFunction *Func;
+		void *DirectNativeCall;
+	};
+
+	Entry Entries[NumEntries];
+	unsigned int Misses;
+};
+
+JitCallSiteCache *AllocJitCallSiteCache();
+
 class JitCompiler
 {
 public:
@@ -41,6 +65,8 @@ public:
 	VMScriptFunction *GetScriptFunction() { return sfunc; }
 
 	TArray<JitLineInfo> LineInfo;
+	TArray<const void *> EmbeddedPointers;
+	TArray<JitCallSiteCache *> CallSites;
 
 private:
 	// Declare EmitXX functions for the opcodes:
@@ -61,8 +87,11 @@ private:
 	void EmitPopFrame();
 
 	void EmitNativeCall(VMNativeFunction *target);
+	void EmitDirectNativeCall(const asmjit::Operand &callee, const char *comment);
 	void EmitVMCall(asmjit::X86Gp ptr, VMFunction *target);
 	void EmitVtbl(const VMOP *op);
+	bool CanCacheVirtualCall();
+	void EmitCachedVirtualCall(const VMOP *op);
 
 	int StoreCallParams();
 	void LoadInOuts();
@@ -156,9 +185,11 @@ private:
 		}
 	}
 
-	static uint64_t ToMemAddress(const void *d)
+	// All pointers the generated code embeds must go through here so the JIT cache can find and patch them.
+	asmjit::Imm ImmPtr(const void *p)
 	{
-		return (uint64_t)(ptrdiff_t)d;
+		EmbeddedPointers.Push(p);
+		return asmjit::imm_ptr(p);
 	}
 
 	void CallSqrt(const asmjit::X86Xmm &a, const asmjit::X86Xmm &b);
@@ -353,5 +384,18 @@ public:
 	}
 };
 
+struct JitUnwindInfo
+{
+	TArray<uint8_t> Data;
+	unsigned int FunctionStart = 0;	// where the function's address goes in the unwind data
+};
+
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
+void *InstallJitFunction(asmjit::CodeHolder *code, const JitUnwindInfo &unwind, VMScriptFunction *sfunc, const TArray<JitLineInfo> &lineInfo);
 asmjit::CodeInfo GetHostCodeInfo();
+
+// Guards the JIT's code memory, debug info and cache, as functions may be compiled off the main thread.
+extern std::recursive_mutex JitMutex;
+
+JitFuncPtr JitCacheLoad(VMScriptFunction *sfunc);
+void JitCacheStore(JitCompiler *compiler, asmjit::CodeHolder *code, const JitUnwindInfo &unwind);
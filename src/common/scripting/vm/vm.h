@@ -57,6 +57,8 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void VMWaitForTieredJit();
+bool VMStopProfiling(const char *basename);
 
 extern void (*VM_CastSpriteIDToString)(FString* a, unsigned int b);
 
@@ -458,6 +460,7 @@ public:
 	TArray<uint32_t> ArgFlags;		// Should be the same length as Proto->ArgumentTypes
 
 	int(*ScriptCall)(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret) = nullptr;
+	int(*ProfiledCall)(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret) = nullptr;	// the real ScriptCall while the profiler is running
 
 	VMFunction(FName name = NAME_None) : ImplicitArgs(0), Name(name), Proto(NULL)
 	{
@@ -474,6 +477,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		VMStopProfiling(nullptr);
+		VMWaitForTieredJit();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
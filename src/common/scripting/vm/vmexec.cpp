@@ -39,6 +39,7 @@
 //#include "r_state.h"
 #include "stats.h"
 #include "vmintern.h"
+#include "vmprofiler.h"
 #include "types.h"
 #include "basics.h"
 #include "texturemanager.h"
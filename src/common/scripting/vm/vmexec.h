@@ -728,6 +728,11 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		}
 		NEXTOP;
 	OP(JMP):
+		if (JMPOFS(pc) < 0 && sfunc->TierLoops > 0 && --sfunc->TierLoops == 0)
+		{
+			// A loop keeps running in here. The compiled code will be used from the next call on.
+			sfunc->QueueTieredJit();
+		}
 		pc += JMPOFS(pc);
 		NEXTOP;
 	OP(IJMP):
@@ -888,6 +893,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 			{
 				try
 				{
+					FVMProfileScope scope(call, VMPF_Native);
 					VMCycles[0].Unclock();
 					numret1 = static_cast<VMNativeFunction *>(call)->NativeCall(VM_INVOKE(reg.param + f->NumParam - b, b, returns, C, call->RegTypes));
 					VMCycles[0].Clock();
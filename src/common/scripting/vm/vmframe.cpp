@@ -39,10 +39,15 @@
 #include "c_dispatch.h"
 
 #include "vmintern.h"
+#include "vmprofiler.h"
 #include "types.h"
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #ifdef HAVE_VM_JIT
 #ifdef __DragonFly__
@@ -59,16 +64,109 @@ CUSTOM_CVAR(Bool, vm_jit_aot, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+// Functions start in the interpreter and get compiled on a worker thread once they are hot. Overrides vm_jit_aot.
+CUSTOM_CVAR(Bool, vm_jit_tiered, false, CVAR_NOINITCALL)
+{
+	Printf("You must restart " GAMENAME " for this change to take effect.\n");
+	Printf("This cvar is currently not saved. You must specify it on the command line.");
+}
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 CVAR(Bool, vm_jit_aot, false, CVAR_NOINITCALL|CVAR_NOSET)
+CVAR(Bool, vm_jit_tiered, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames, int maxFrames) { return FString(); }
 void JitRelease() {}
 #endif
 
+CVAR(Int, vm_jit_tiercalls, 10, 0)		// calls after which a function gets compiled
+CVAR(Int, vm_jit_tierloops, 2000, 0)	// same for loop iterations within its calls
+
 cycle_t VMCycles[10];
 int VMCalls[10];
 
+#ifdef HAVE_VM_JIT
+//==========================================================================
+//
+// Tiered JIT compiles run on a thread of their own. Scheduler workers
+// must stay free for the drawer slices pinned to each of them, and the
+// main thread would pick up unpinned tasks while waiting on other groups.
+//
+//==========================================================================
+
+class FTieredJitThread
+{
+public:
+	~FTieredJitThread()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			StopFlag = true;
+		}
+		QueueCondition.notify_all();
+		if (Thread.joinable()) Thread.join();
+	}
+
+	void Queue(VMScriptFunction *func)
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			if (!Thread.joinable()) Thread = std::thread([this]() { ThreadMain(); });
+			Functions.push_back(func);
+			Pending++;
+		}
+		QueueCondition.notify_one();
+	}
+
+	void Wait()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		DoneCondition.wait(lock, [this]() { return Pending == 0; });
+	}
+
+	FString TakeErrors()
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		FString errors = Errors;
+		Errors = "";
+		return errors;
+	}
+
+private:
+	void ThreadMain()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (true)
+		{
+			QueueCondition.wait(lock, [this]() { return StopFlag || !Functions.empty(); });
+			if (StopFlag) break;
+
+			VMScriptFunction *func = Functions.front();
+			Functions.pop_front();
+			lock.unlock();
+
+			FString errors;
+			JitFuncPtr compiled = ::JitCompile(func, &errors);
+			func->TierEntry.store(compiled ? compiled : VMExec, std::memory_order_release);
+
+			lock.lock();
+			Errors += errors;
+			if (--Pending == 0) DoneCondition.notify_all();
+		}
+	}
+
+	std::thread Thread;
+	std::mutex Mutex;
+	std::condition_variable QueueCondition;
+	std::condition_variable DoneCondition;
+	std::deque<VMScriptFunction *> Functions;
+	int Pending = 0;
+	bool StopFlag = false;
+	FString Errors;
+};
+
+static FTieredJitThread TieredJitThread;
+#endif
+
 #if 0
 IMPLEMENT_CLASS(VMException, false, false)
 #endif
@@ -140,6 +238,9 @@ VMScriptFunction::VMScriptFunction(FName name)
 	NumKonstA = 0;
 	MaxParam = 0;
 	NumArgs = 0;
+	TierCalls = 0;
+	TierLoops = 0;
+	TierEntry = nullptr;
 	ScriptCall = &VMScriptFunction::FirstScriptCall;
 }
 
@@ -292,17 +393,28 @@ void VMScriptFunction::JitCompile()
 {
 	if(!(VarFlags & VARF_Abstract))
 	{
+		// While profiling, the profiler's wrapper has to stay in front of the compiled code.
+		auto &entry = ProfiledCall ? ProfiledCall : ScriptCall;
 	#ifdef HAVE_VM_JIT
 		if (vm_jit && CanJit(this))
 		{
-			ScriptCall = ::JitCompile(this);
-			if (!ScriptCall)
-				ScriptCall = VMExec;
+			if (vm_jit_tiered)
+			{
+				TierCalls = max<int>(vm_jit_tiercalls, 1);
+				TierLoops = max<int>(vm_jit_tierloops, 1);
+				entry = TieredScriptCall;
+			}
+			else
+			{
+				entry = ::JitCompile(this);
+				if (!entry)
+					entry = VMExec;
+			}
 		}
 		else
 	#endif // HAVE_VM_JIT
 		{
-			ScriptCall = VMExec;
+			entry = VMExec;
 		}
 	}
 }
@@ -319,7 +431,66 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 	
 	static_cast<VMScriptFunction*>(func)->JitCompile();
 
-	return func->ScriptCall(func, params, numparams, ret, numret);
+	// When called through the profiler, it already has a frame for this call.
+	auto entry = func->ProfiledCall ? func->ProfiledCall : func->ScriptCall;
+	return entry(func, params, numparams, ret, numret);
+}
+
+//==========================================================================
+//
+// Entry point of a function that still runs in the interpreter in tiered
+// mode. Counts the calls and swaps in the compiled code once it is ready.
+//
+//==========================================================================
+
+int VMScriptFunction::TieredScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	if (sfunc->TierCalls > 0)
+	{
+		if (--sfunc->TierCalls == 0)
+			sfunc->QueueTieredJit();
+	}
+	else if (auto compiled = sfunc->TierEntry.load(std::memory_order_acquire))
+	{
+#ifdef HAVE_VM_JIT
+		FString errors = TieredJitThread.TakeErrors();
+		if (errors.IsNotEmpty())
+		{
+			Printf("%s", errors.GetChars());
+		}
+#endif
+		auto &entry = sfunc->ProfiledCall ? sfunc->ProfiledCall : sfunc->ScriptCall;
+		entry = compiled;
+		return compiled(func, params, numparams, ret, numret);
+	}
+	return VMExec(func, params, numparams, ret, numret);
+}
+
+//==========================================================================
+//
+// Stops counting and hands the function to the tiered JIT thread.
+// If compiling fails, the interpreter gets swapped in instead.
+//
+//==========================================================================
+
+void VMScriptFunction::QueueTieredJit()
+{
+	TierCalls = 0;
+	TierLoops = 0;
+
+#ifdef HAVE_VM_JIT
+	TieredJitThread.Queue(this);
+#else
+	TierEntry.store(VMExec, std::memory_order_release);
+#endif
+}
+
+void VMWaitForTieredJit()
+{
+#ifdef HAVE_VM_JIT
+	TieredJitThread.Wait();
+#endif
 }
 
 int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *returns, int numret)
@@ -570,6 +741,7 @@ int VMCall(VMFunction *func, VMValue *params, int numparams, VMReturn *results,
 	{	
 		if (func->VarFlags & VARF_Native)
 		{
+			FVMProfileScope scope(func, VMPF_Native);
 			return static_cast<VMNativeFunction *>(func)->NativeCall(VM_INVOKE(params, numparams, results, numresults, func->RegTypes));
 		}
 		else
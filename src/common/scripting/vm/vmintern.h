@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vm.h"
+#include <atomic>
 #include <csetjmp>
 
 class VMScriptFunction;
@@ -474,13 +475,21 @@ public:
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
 
+	// Tiered JIT: calls and backward jumps left in the interpreter until the function gets compiled.
+	// Both are 0 when the function is not being counted.
+	int TierCalls;
+	int TierLoops;
+	std::atomic<JitFuncPtr> TierEntry;	// set by the compiling thread, swapped in by the next call
+
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
 	int AllocExtraStack(PType *type);
 	int PCToLine(const VMOP *pc);
+	void QueueTieredJit();
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	static int TieredScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 	void JitCompile();
 	friend class FFunctionBuildList;
 };
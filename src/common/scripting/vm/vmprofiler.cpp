@@ -0,0 +1,424 @@
+/*
+** vmprofiler.cpp
+** Call tree profiler for script code with flame graph and trace export
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The profile is a call tree. Each node is one distinct call path, so the
+** collapsed stacks for flame graphs fall out of it directly. Individual calls
+** are also kept, up to a limit, for the Chrome trace viewer (chrome://tracing
+** or Perfetto).
+**
+** Native functions the JIT calls directly are not seen. Their time is counted
+** for the calling script function.
+**
+*/
+
+#include <algorithm>
+#include <memory>
+#include "dobject.h"
+#include "c_dispatch.h"
+#include "c_cvars.h"
+#include "i_time.h"
+#include "printf.h"
+#include "v_text.h"
+#include "filesystem.h"
+#include "vmintern.h"
+#include "types.h"
+#include "vmprofiler.h"
+
+CVAR(Int, vm_profile_maxevents, 1000000, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+struct FVMProfileNode
+{
+	const void *Key;
+	EVMProfileFrame Kind;
+	int Parent;
+	int FirstChild;
+	int NextSibling;
+	uint64_t Time;		// including children, in nanoseconds
+	uint64_t Calls;
+};
+
+struct FVMProfileEvent
+{
+	int Node;
+	int Depth;
+	uint64_t Start;
+	uint64_t Duration;
+};
+
+struct FVMProfileEntry
+{
+	int Node;
+	uint64_t Start;
+};
+
+struct FVMProfile
+{
+	TArray<FVMProfileNode> Nodes;
+	TArray<FVMProfileEntry> Stack;
+	TArray<FVMProfileEvent> Events;
+	unsigned MaxEvents;
+	uint64_t StartTime;
+	int Current = 0;
+};
+
+thread_local FVMProfile *VMProfileActive;
+static FVMProfile *Profile;
+
+//==========================================================================
+//
+// Children are kept in a linked list with the most recently entered one first.
+// Call sites tend to repeat, so the search rarely goes past the head.
+//
+//==========================================================================
+
+void VMProfileEnter(const void *key, EVMProfileFrame kind)
+{
+	auto prof = VMProfileActive;
+	auto &nodes = prof->Nodes;
+	int parent = prof->Current;
+	int prev = -1;
+	int node = nodes[parent].FirstChild;
+
+	while (node >= 0 && nodes[node].Key != key)
+	{
+		prev = node;
+		node = nodes[node].NextSibling;
+	}
+	if (node < 0)
+	{
+		node = nodes.Push({ key, kind, parent, -1, nodes[parent].FirstChild, 0, 0 });
+		nodes[parent].FirstChild = node;
+	}
+	else if (prev >= 0)
+	{
+		nodes[prev].NextSibling = nodes[node].NextSibling;
+		nodes[node].NextSibling = nodes[parent].FirstChild;
+		nodes[parent].FirstChild = node;
+	}
+
+	nodes[node].Calls++;
+	prof->Current = node;
+	prof->Stack.Push({ node, I_nsTime() });
+}
+
+void VMProfileLeave()
+{
+	auto prof = VMProfileActive;
+	if (prof == nullptr || prof->Stack.Size() == 0) return;
+
+	uint64_t now = I_nsTime();
+	FVMProfileEntry entry;
+	prof->Stack.Pop(entry);
+
+	auto &node = prof->Nodes[entry.Node];
+	node.Time += now - entry.Start;
+	prof->Current = node.Parent;
+
+	if (prof->Events.Size() < prof->MaxEvents)
+	{
+		prof->Events.Push({ entry.Node, (int)prof->Stack.Size(), entry.Start - prof->StartTime, now - entry.Start });
+	}
+}
+
+//==========================================================================
+//
+// Stands in for ScriptCall while profiling. The real entry point is
+// kept in ProfiledCall.
+//
+//==========================================================================
+
+int VMProfiledCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto call = func->ProfiledCall;
+	FVMProfileScope scope(func, (func->VarFlags & VARF_Native) ? VMPF_Native : VMPF_Script);
+	return call(func, params, numparams, ret, numret);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool VMStartProfiling()
+{
+	if (Profile != nullptr) return false;
+
+	Profile = new FVMProfile;
+	Profile->Nodes.Push({ nullptr, VMPF_Label, -1, -1, -1, 0, 0 });
+	Profile->MaxEvents = std::max<int>(vm_profile_maxevents, 0);
+	Profile->StartTime = I_nsTime();
+
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->ScriptCall != nullptr)
+		{
+			func->ProfiledCall = func->ScriptCall;
+			func->ScriptCall = VMProfiledCall;
+		}
+	}
+	VMProfileActive = Profile;
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static FString FrameName(const FVMProfileNode &node)
+{
+	FString name;
+	switch (node.Kind)
+	{
+	case VMPF_Script:
+	{
+		auto func = (VMScriptFunction *)node.Key;
+		if (func->Code != nullptr && func->LineInfoCount > 0)
+			name.Format("%s (%s:%d)", func->PrintableName, func->SourceFileName.GetChars(), func->PCToLine(func->Code));
+		else
+			name = func->PrintableName;
+		break;
+	}
+
+	case VMPF_Native:
+		name.Format("%s [native]", ((VMFunction *)node.Key)->PrintableName);
+		break;
+
+	case VMPF_Thinker:
+		name.Format("%s [thinker]", ((PClass *)node.Key)->TypeName.GetChars());
+		break;
+
+	case VMPF_Label:
+		name = (const char *)node.Key;
+		break;
+	}
+	// ';' separates the frames of a collapsed stack.
+	name.Substitute(";", ":");
+	return name;
+}
+
+static FString JsonString(const FString &str)
+{
+	FString out = "\"";
+	for (const char *p = str.GetChars(); *p; p++)
+	{
+		if (*p == '"' || *p == '\\') out << '\\' << *p;
+		else if ((uint8_t)*p < 32) out.AppendFormat("\\u%04x", (uint8_t)*p);
+		else out << *p;
+	}
+	out << '"';
+	return out;
+}
+
+static bool WriteCollapsedStacks(FVMProfile *prof, const TArray<FString> &names, const char *filename)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(filename));
+	if (fw == nullptr) return false;
+
+	TArray<int> path;
+	for (unsigned i = 1; i < prof->Nodes.Size(); i++)
+	{
+		auto &node = prof->Nodes[i];
+		uint64_t self = node.Time;
+		for (int c = node.FirstChild; c >= 0; c = prof->Nodes[c].NextSibling)
+		{
+			self -= std::min(self, prof->Nodes[c].Time);
+		}
+		uint64_t us = self / 1000;
+		if (us == 0) continue;
+
+		path.Clear();
+		for (int n = i; n > 0; n = prof->Nodes[n].Parent) path.Push(n);
+
+		FString line;
+		for (int p = path.Size() - 1; p >= 0; p--)
+		{
+			line << names[path[p]];
+			if (p > 0) line << ';';
+		}
+		fw->Printf("%s %llu\n", line.GetChars(), (unsigned long long)us);
+	}
+	return true;
+}
+
+static bool WriteTrace(FVMProfile *prof, const TArray<FString> &names, const char *filename)
+{
+	std::unique_ptr<FileWriter> fw(FileWriter::Open(filename));
+	if (fw == nullptr) return false;
+
+	TArray<FString> jsonnames(names.Size(), true);
+	for (unsigned i = 0; i < names.Size(); i++) jsonnames[i] = JsonString(names[i]);
+
+	// Events are recorded when they end, so sort them by start time, parents before their children.
+	std::sort(prof->Events.begin(), prof->Events.end(), [](const FVMProfileEvent &a, const FVMProfileEvent &b)
+	{
+		return a.Start != b.Start ? a.Start < b.Start : a.Depth < b.Depth;
+	});
+
+	fw->Printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (unsigned i = 0; i < prof->Events.Size(); i++)
+	{
+		auto &ev = prof->Events[i];
+		fw->Printf("%s{\"name\":%s,\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n", i > 0 ? "," : "",
+			jsonnames[ev.Node].GetChars(), ev.Start / 1000., ev.Duration / 1000.);
+	}
+	fw->Printf("]}\n");
+	return true;
+}
+
+static void PrintSummary(FVMProfile *prof, const TArray<FString> &names, uint64_t elapsed)
+{
+	// Sum up the time per function over all the call paths it appears in.
+	TMap<const void *, unsigned> index;
+	struct Total { unsigned Node; uint64_t Self; uint64_t Calls; };
+	TArray<Total> totals;
+
+	for (unsigned i = 1; i < prof->Nodes.Size(); i++)
+	{
+		auto &node = prof->Nodes[i];
+		uint64_t self = node.Time;
+		for (int c = node.FirstChild; c >= 0; c = prof->Nodes[c].NextSibling)
+		{
+			self -= std::min(self, prof->Nodes[c].Time);
+		}
+		auto pos = index.CheckKey(node.Key);
+		if (pos == nullptr)
+		{
+			index[node.Key] = totals.Push({ i, self, node.Calls });
+		}
+		else
+		{
+			totals[*pos].Self += self;
+			totals[*pos].Calls += node.Calls;
+		}
+	}
+	std::sort(totals.begin(), totals.end(), [](const Total &a, const Total &b) { return a.Self > b.Self; });
+
+	Printf("Profiled %.1f ms\n", elapsed / 1000000.);
+	Printf("%9s %9s  %s\n", "self ms", "calls", "function");
+	for (unsigned i = 0; i < std::min(totals.Size(), 20u); i++)
+	{
+		Printf("%9.3f %9llu  %s\n", totals[i].Self / 1000000., (unsigned long long)totals[i].Calls, names[totals[i].Node].GetChars());
+	}
+}
+
+//==========================================================================
+//
+// Puts the original entry points back and writes <basename>.folded and
+// <basename>.json. With no basename the profile is discarded.
+//
+//==========================================================================
+
+bool VMStopProfiling(const char *basename)
+{
+	if (Profile == nullptr) return false;
+
+	for (auto func : VMFunction::AllFunctions)
+	{
+		if (func->ProfiledCall != nullptr)
+		{
+			func->ScriptCall = func->ProfiledCall;
+			func->ProfiledCall = nullptr;
+		}
+	}
+	VMProfileActive = nullptr;
+
+	std::unique_ptr<FVMProfile> prof(Profile);
+	Profile = nullptr;
+	if (basename == nullptr) return true;
+
+	uint64_t elapsed = I_nsTime() - prof->StartTime;
+
+	// Calls still in progress end now.
+	while (prof->Stack.Size() > 0)
+	{
+		FVMProfileEntry entry;
+		prof->Stack.Pop(entry);
+		prof->Nodes[entry.Node].Time += prof->StartTime + elapsed - entry.Start;
+	}
+
+	TArray<FString> names(prof->Nodes.Size(), true);
+	for (unsigned i = 1; i < prof->Nodes.Size(); i++) names[i] = FrameName(prof->Nodes[i]);
+
+	PrintSummary(prof.get(), names, elapsed);
+
+	FString folded = FStringf("%s.folded", basename);
+	FString trace = FStringf("%s.json", basename);
+	if (!WriteCollapsedStacks(prof.get(), names, folded.GetChars()))
+	{
+		Printf(TEXTCOLOR_RED "Unable to write %s\n", folded.GetChars());
+		return false;
+	}
+	if (!WriteTrace(prof.get(), names, trace.GetChars()))
+	{
+		Printf(TEXTCOLOR_RED "Unable to write %s\n", trace.GetChars());
+		return false;
+	}
+	Printf("Wrote %s and %s", folded.GetChars(), trace.GetChars());
+	if (prof->Events.Size() >= prof->MaxEvents) Printf(", the trace was cut off after %u calls", prof->MaxEvents);
+	Printf("\n");
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(vmprofile)
+{
+	if (argv.argc() >= 2 && stricmp(argv[1], "start") == 0)
+	{
+		if (VMStartProfiling()) Printf("VM profiling started\n");
+		else Printf("VM profiling is already running\n");
+		return;
+	}
+	else if (argv.argc() >= 2 && stricmp(argv[1], "stop") == 0)
+	{
+		if (Profile == nullptr) Printf("VM profiling is not running\n");
+		else VMStopProfiling(argv.argc() >= 3 ? argv[2] : "vmprofile");
+		return;
+	}
+	else if (argv.argc() >= 2 && stricmp(argv[1], "cancel") == 0)
+	{
+		VMStopProfiling(nullptr);
+		return;
+	}
+	Printf("Usage: vmprofile start\n"
+		"       vmprofile stop [basename]\n"
+		"       vmprofile cancel\n\n"
+		"Writes the call tree as collapsed stacks to <basename>.folded for flame graph tools\n"
+		"and the individual calls to <basename>.json for chrome://tracing or Perfetto.\n");
+}
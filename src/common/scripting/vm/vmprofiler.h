@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+class VMFunction;
+class PClass;
+
+// Call tree profiler for script code. While it runs, every VM function's ScriptCall
+// is routed through a wrapper that records the time spent in it, so JIT compiled
+// callers are seen as well. Thinker ticks are recorded as their own frames.
+
+enum EVMProfileFrame
+{
+	VMPF_Script,
+	VMPF_Native,
+	VMPF_Thinker,
+	VMPF_Label,
+};
+
+struct FVMProfile;
+extern thread_local FVMProfile *VMProfileActive;	// only set on the thread that started profiling
+
+void VMProfileEnter(const void *key, EVMProfileFrame kind);
+void VMProfileLeave();
+
+bool VMStartProfiling();
+bool VMStopProfiling(const char *basename);
+int VMProfiledCall(VMFunction *func, struct VMValue *params, int numparams, struct VMReturn *ret, int numret);
+
+class FVMProfileScope
+{
+	bool Entered;
+
+public:
+	FVMProfileScope(const void *key, EVMProfileFrame kind)
+	{
+		Entered = VMProfileActive != nullptr;
+		if (Entered) VMProfileEnter(key, kind);
+	}
+	~FVMProfileScope()
+	{
+		if (Entered) VMProfileLeave();
+	}
+};
@@ -25,45 +25,47 @@
 #ifndef PARALLEL_FOR_H_INCLUDED
 #define PARALLEL_FOR_H_INCLUDED
 
-#ifdef HAVE_PARALLEL_FOR
+#include <algorithm>
 
-#include <ppl.h>
+#include "tasks.h"
 
+// Runs on the engine's task scheduler. Iterations are split into a few batches per worker
+// and the calling thread helps executing them.
 template <typename Index, typename Function>
 inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
 {
-	concurrency::parallel_for(first, last, step, function);
-}
-
-#elif defined HAVE_DISPATCH_APPLY
-
-#include <dispatch/dispatch.h>
-
-template <typename Index, typename Function>
-inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
-{
-	const dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-
-	dispatch_apply((last - first) / step + 1, queue, ^(size_t slice)
+	if (first >= last)
 	{
-		function(slice * step);
-	});
-}
+		return;
+	}
 
-#else // Generic loop with optional OpenMP parallelization
+	const Index count = (last - first + step - 1) / step;
+	const Index numBatches = std::min<Index>(count, Index(FTaskScheduler::Get().NumWorkers() * 4));
+	if (numBatches <= 1)
+	{
+		for (Index i = first; i < last; i += step)
+		{
+			function(i);
+		}
+		return;
+	}
 
-template <typename Index, typename Function>
-inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
-{
-#pragma omp parallel for
-	for (Index i = first; i < last; i += step)
+	FTaskGroup group;
+	for (Index batch = 0; batch < numBatches; batch++)
 	{
-		function(i);
+		const Index begin = first + count * batch / numBatches * step;
+		const Index end = std::min<Index>(last, first + count * (batch + 1) / numBatches * step);
+		group.Run([=, &function]()
+		{
+			for (Index i = begin; i < end; i += step)
+			{
+				function(i);
+			}
+		});
 	}
+	group.Wait();
 }
 
-#endif // HAVE_PARALLEL_FOR
-
 template <typename Index, typename Function>
 inline void parallel_for(const Index count, const Function& function)
 {
@@ -0,0 +1,333 @@
+/*
+** tasks.cpp
+** Engine-wide work-stealing task scheduler
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see http://www.gnu.org/licenses/
+**
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "i_system.h"
+#include "tasks.h"
+
+// Set when sys_workerthreads changes; the main thread restarts the workers on its next Get while nothing is queued.
+static std::atomic<bool> WorkerCountChanged{ false };
+
+CUSTOM_CVAR(Int, sys_workerthreads, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
+{
+	if (self < 0) self = 0;
+	WorkerCountChanged.store(true, std::memory_order_release);
+}
+
+static thread_local int CurrentWorkerIndex = -1;
+
+//==========================================================================
+//
+// Task groups
+//
+//==========================================================================
+
+void FTaskGroup::Run(FTaskFunc func, int affinity)
+{
+	Pending.fetch_add(1, std::memory_order_relaxed);
+	FTaskScheduler::Get().Submit({ std::move(func), this }, affinity);
+}
+
+void FTaskGroup::Then(FTaskFunc func, int affinity)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	if (Pending.load(std::memory_order_acquire) == 0)
+	{
+		Pending.fetch_add(1, std::memory_order_relaxed);
+		FTaskScheduler::Get().Submit({ std::move(func), this }, affinity);
+	}
+	else
+	{
+		Continuations.push_back({ std::move(func), affinity });
+	}
+}
+
+void FTaskGroup::Finish()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	// Queue the continuations before the last task is retired so that Wait cannot return in between.
+	if (Pending.load(std::memory_order_relaxed) == 1 && Continuations.size() > 0)
+	{
+		auto continuations = std::move(Continuations);
+		Continuations.clear();
+		for (auto &c : continuations)
+		{
+			Pending.fetch_add(1, std::memory_order_relaxed);
+			FTaskScheduler::Get().Submit({ std::move(c.Func), this }, c.Affinity);
+		}
+	}
+
+	// Notify with the lock held. Waiters take the lock before returning, so the group stays alive until we are out.
+	if (Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		DoneCondition.notify_all();
+	}
+}
+
+void FTaskGroup::Wait()
+{
+	using namespace std::chrono_literals;
+
+	if (!IsDone())
+	{
+		auto &scheduler = FTaskScheduler::Get();
+		while (!IsDone())
+		{
+			if (!scheduler.RunPending())
+			{
+				// Nothing to help with. Sleep until the group is done, but look for new work now and then.
+				std::unique_lock<std::mutex> lock(Mutex);
+				DoneCondition.wait_for(lock, 1ms, [&]() { return IsDone(); });
+			}
+		}
+	}
+	std::unique_lock<std::mutex> lock(Mutex);
+}
+
+bool FTaskGroup::WaitFor(std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	return DoneCondition.wait_for(lock, timeout, [&]() { return IsDone(); });
+}
+
+//==========================================================================
+//
+// Scheduler
+//
+//==========================================================================
+
+FTaskScheduler &FTaskScheduler::Get()
+{
+	static FTaskScheduler scheduler;
+
+	if (WorkerCountChanged.load(std::memory_order_acquire) && std::this_thread::get_id() == scheduler.MainThreadId &&
+		scheduler.Outstanding.load(std::memory_order_acquire) == 0)
+	{
+		WorkerCountChanged.store(false, std::memory_order_relaxed);
+		scheduler.ApplyWorkerCount();
+	}
+	return scheduler;
+}
+
+void FTaskScheduler::Init()
+{
+	FTaskScheduler &scheduler = Get();
+	scheduler.MainThreadId = std::this_thread::get_id();
+	WorkerCountChanged.store(false, std::memory_order_relaxed);
+	scheduler.ApplyWorkerCount();
+}
+
+void FTaskScheduler::ApplyWorkerCount()
+{
+	int numWorkers = sys_workerthreads;
+	if (numWorkers == 0)
+	{
+		int numThreads = 0;
+		for (int i = 0; i < I_GetNumaNodeCount(); i++)
+			numThreads += I_GetNumaNodeThreadCount(i);
+		numWorkers = numThreads;
+	}
+	numWorkers = std::max(numWorkers, 1);
+
+	if (numWorkers != NumWorkers())
+	{
+		StopThreads();
+		StartThreads(numWorkers);
+	}
+}
+
+FTaskScheduler::~FTaskScheduler()
+{
+	StopThreads();
+}
+
+int FTaskScheduler::CurrentWorker()
+{
+	return CurrentWorkerIndex;
+}
+
+void FTaskScheduler::StartThreads(int numWorkers)
+{
+	// Spread the workers over the NUMA nodes in the same order the drawers used to
+	int numaNode = 0, numaThread = 0;
+	for (int i = 0; i < numWorkers; i++)
+	{
+		auto worker = std::make_unique<FWorker>();
+		worker->NumaNode = numaNode;
+		Workers.push_back(std::move(worker));
+
+		if (++numaThread >= I_GetNumaNodeThreadCount(numaNode))
+		{
+			numaThread = 0;
+			numaNode = (numaNode + 1) % I_GetNumaNodeCount();
+		}
+	}
+
+	// Start them only after the array is complete, as workers steal from each other.
+	for (int i = 0; i < numWorkers; i++)
+	{
+		Workers[i]->Thread = std::thread([this, i]() { WorkerMain(i); });
+		I_SetThreadNumaNode(Workers[i]->Thread, Workers[i]->NumaNode);
+	}
+}
+
+void FTaskScheduler::StopThreads()
+{
+	std::unique_lock<std::mutex> lock(SleepMutex);
+	ShutdownFlag = true;
+	lock.unlock();
+	SleepCondition.notify_all();
+	for (auto &worker : Workers)
+		worker->Thread.join();
+	Workers.clear();
+	lock.lock();
+	ShutdownFlag = false;
+}
+
+void FTaskScheduler::WorkerMain(int index)
+{
+	CurrentWorkerIndex = index;
+	FWorker &self = *Workers[index];
+
+	while (true)
+	{
+		FTask task;
+		if (TakeTask(index, task))
+		{
+			Execute(task);
+			continue;
+		}
+
+		// On shutdown, only leave once everything is done. Workers with nothing to do keep sleeping until then.
+		std::unique_lock<std::mutex> lock(SleepMutex);
+		SleepCondition.wait(lock, [&]() { return (ShutdownFlag && Outstanding.load() == 0) || Queued.load() > 0 || self.PinnedCount.load() > 0; });
+		if (ShutdownFlag && Outstanding.load() == 0)
+			break;
+	}
+	CurrentWorkerIndex = -1;
+}
+
+void FTaskScheduler::Submit(FTask &&task, int affinity)
+{
+	Outstanding.fetch_add(1, std::memory_order_relaxed);
+
+	bool pinned = affinity >= 0;
+	if (pinned)
+	{
+		FWorker &worker = *Workers[affinity % Workers.size()];
+		std::unique_lock<std::mutex> lock(worker.Mutex);
+		worker.Pinned.push_back(std::move(task));
+		worker.PinnedCount.fetch_add(1);
+	}
+	else
+	{
+		// Workers keep their own work local, everybody else spreads it around.
+		int index = CurrentWorkerIndex;
+		if (index < 0)
+			index = NextWorker.fetch_add(1, std::memory_order_relaxed) % Workers.size();
+
+		FWorker &worker = *Workers[index];
+		std::unique_lock<std::mutex> lock(worker.Mutex);
+		worker.Tasks.push_back(std::move(task));
+		Queued.fetch_add(1);
+	}
+
+	// Taking the lock makes sure no worker is between checking its wait condition and going to sleep.
+	{
+		std::unique_lock<std::mutex> lock(SleepMutex);
+	}
+	if (pinned)
+		SleepCondition.notify_all();
+	else
+		SleepCondition.notify_one();
+}
+
+bool FTaskScheduler::TakeTask(int index, FTask &task)
+{
+	FWorker &self = *Workers[index];
+	if (self.PinnedCount.load() > 0 || Queued.load() > 0)
+	{
+		std::unique_lock<std::mutex> lock(self.Mutex);
+		if (!self.Pinned.empty())
+		{
+			task = std::move(self.Pinned.front());
+			self.Pinned.pop_front();
+			self.PinnedCount.fetch_sub(1);
+			return true;
+		}
+		if (!self.Tasks.empty())
+		{
+			task = std::move(self.Tasks.back());
+			self.Tasks.pop_back();
+			Queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return StealTask(index + 1, task);
+}
+
+bool FTaskScheduler::StealTask(int first, FTask &task)
+{
+	int numWorkers = (int)Workers.size();
+	for (int i = 0; i < numWorkers && Queued.load() > 0; i++)
+	{
+		FWorker &victim = *Workers[(first + i) % numWorkers];
+		std::unique_lock<std::mutex> lock(victim.Mutex);
+		if (!victim.Tasks.empty())
+		{
+			task = std::move(victim.Tasks.front());
+			victim.Tasks.pop_front();
+			Queued.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool FTaskScheduler::RunPending()
+{
+	FTask task;
+	int index = CurrentWorkerIndex;
+	if (!StealTask(index >= 0 ? index : NextWorker.load(std::memory_order_relaxed), task))
+		return false;
+	Execute(task);
+	return true;
+}
+
+void FTaskScheduler::Execute(FTask &task)
+{
+	task.Func();
+	task.Func = nullptr;
+	task.Group->Finish();
+	if (Outstanding.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		// The last task is done. Wake the workers that are waiting for that to shut down.
+		std::unique_lock<std::mutex> lock(SleepMutex);
+		if (ShutdownFlag)
+		{
+			lock.unlock();
+			SleepCondition.notify_all();
+		}
+	}
+}
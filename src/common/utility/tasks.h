@@ -0,0 +1,157 @@
+/*
+** tasks.h
+** Engine-wide work-stealing task scheduler
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see http://www.gnu.org/licenses/
+**
+**---------------------------------------------------------------------------
+**
+** All subsystems that want to run work in parallel (drawer threads, the
+** hardware renderer's BSP worker, parallel_for users) share one set of
+** worker threads. Every worker owns a deque: it pushes and pops its own work
+** at the back while idle workers steal from the front of the others.
+** Tasks may be pinned to a worker, in which case only that worker will run
+** them, in submission order.
+**
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "c_cvars.h"
+
+// Number of worker threads (0 = one per hardware thread, as the drawer threads had)
+EXTERN_CVAR(Int, sys_workerthreads)
+
+using FTaskFunc = std::function<void()>;
+
+enum
+{
+	TASK_ANYWORKER = -1,	// affinity hint: the task may run on any worker
+};
+
+class FTaskGroup
+{
+public:
+	FTaskGroup() = default;
+	FTaskGroup(const FTaskGroup &) = delete;
+	FTaskGroup &operator=(const FTaskGroup &) = delete;
+	~FTaskGroup() { Wait(); }
+
+	// Queues a task. A worker index as affinity pins the task to that worker.
+	void Run(FTaskFunc func, int affinity = TASK_ANYWORKER);
+
+	// Queues func as soon as all tasks of the group queued so far have finished.
+	// The continuation belongs to the group, so Wait also waits for it.
+	void Then(FTaskFunc func, int affinity = TASK_ANYWORKER);
+
+	// Waits for all tasks of the group. The calling thread executes unpinned tasks in the meantime.
+	void Wait();
+
+	// Waits without helping. Returns false if the group did not finish in time.
+	bool WaitFor(std::chrono::milliseconds timeout);
+
+	bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	struct Continuation
+	{
+		FTaskFunc Func;
+		int Affinity;
+	};
+
+	void Finish();
+
+	std::atomic<int> Pending{ 0 };
+	std::mutex Mutex;
+	std::condition_variable DoneCondition;
+	std::vector<Continuation> Continuations;
+
+	friend class FTaskScheduler;
+};
+
+class FTaskScheduler
+{
+public:
+	// Must be called once by the main thread at startup, before any task is queued. Starts the workers.
+	static void Init();
+
+	// Returns the scheduler.
+	// Changes to sys_workerthreads are applied here when the main thread calls it while no tasks are queued.
+	static FTaskScheduler &Get();
+
+	int NumWorkers() const { return (int)Workers.size(); }
+	int GetWorkerNumaNode(int worker) const { return Workers[worker]->NumaNode; }
+
+	// Index of the worker executing the caller, or -1 if called from any other thread
+	static int CurrentWorker();
+
+	// Executes one queued unpinned task on the calling thread. Returns false if there was none.
+	bool RunPending();
+
+	void StopThreads();
+
+private:
+	struct FTask
+	{
+		FTaskFunc Func;
+		FTaskGroup *Group;
+	};
+
+	struct FWorker
+	{
+		std::thread Thread;
+		std::mutex Mutex;
+		std::deque<FTask> Tasks;
+		std::deque<FTask> Pinned;
+		std::atomic<int> PinnedCount{ 0 };
+		int NumaNode = 0;
+	};
+
+	FTaskScheduler() = default;
+	~FTaskScheduler();
+
+	void ApplyWorkerCount();
+	void StartThreads(int numWorkers);
+	void WorkerMain(int index);
+	void Submit(FTask &&task, int affinity);
+	bool TakeTask(int index, FTask &task);
+	bool StealTask(int first, FTask &task);
+	void Execute(FTask &task);
+
+	std::vector<std::unique_ptr<FWorker>> Workers;
+	std::thread::id MainThreadId;
+
+	std::mutex SleepMutex;
+	std::condition_variable SleepCondition;
+	bool ShutdownFlag = false;
+
+	std::atomic<int> Queued{ 0 };		// unpinned tasks waiting in any deque
+	std::atomic<int> Outstanding{ 0 };	// tasks queued or executing
+	std::atomic<unsigned> NextWorker{ 0 };
+
+	friend class FTaskGroup;
+};
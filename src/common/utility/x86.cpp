@@ -65,6 +65,17 @@ FString DumpCPUInfo(const CPUInfo *cpu, bool brief)
 #define __cpuid(output, func) __cpuidex(output, func, 0)
 #endif
 
+static uint64_t GetXCR0()
+{
+#ifdef __GNUC__
+	uint32_t lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+	return ((uint64_t)hi << 32) | lo;
+#else
+	return _xgetbv(0);
+#endif
+}
+
 void CheckCPUID(CPUInfo *cpu)
 {
 	int foo[4];
@@ -159,6 +170,14 @@ void CheckCPUID(CPUInfo *cpu)
 		__cpuidex(foo, 7, 1);
 		cpu->FeatureFlags[7] = foo[0];
 	}
+
+	// AVX instructions can only be used if the OS saves the YMM registers.
+	if (!cpu->bOSXSAVE || (GetXCR0() & 6) != 6)
+	{
+		cpu->bAVX = 0;
+		cpu->bAVX2 = 0;
+		cpu->bAVX512_F = 0;
+	}
 }
 
 FString DumpCPUInfo(const CPUInfo *cpu, bool brief)
@@ -101,6 +101,7 @@
 #include "s_music.h"
 #include "swrenderer/r_swcolormaps.h"
 #include "findfile.h"
+#include "i_specialpaths.h"
 #include "md5.h"
 #include "c_buttons.h"
 #include "d_buttons.h"
@@ -117,6 +118,7 @@
 #include "screenjob.h"
 #include "startscreen.h"
 #include "shiftstate.h"
+#include "tasks.h"
 
 #ifdef __unix__
 #include "i_system.h"  // for SHARE_DIR
@@ -306,6 +308,9 @@ CVAR(Bool, disableautoload, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALC
 CVAR(Bool, autoloadbrightmaps, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
 CVAR(Bool, autoloadlights, false, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
 CVAR(Bool, autoloadwidescreen, true, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)
+CVAR(Bool, fs_mapfiles, true, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)	// memory map resource files instead of reading lumps through stdio
+CVAR(Int, fs_prefetchsize, 128, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)	// MB of decompressed lumps to prefetch during startup, 0 disables it
+CVAR(Bool, fs_dircache, true, CVAR_ARCHIVE | CVAR_NOINITCALL | CVAR_GLOBALCONFIG)	// keep parsed archive directories in the cache folder
 CVAR(Bool, r_debug_disable_vis_filter, false, 0)
 CVAR(Int, vid_showpalette, 0, 0)
 
@@ -3277,6 +3282,75 @@ static int FileSystemPrintf(FSMessageLevel level, const char* fmt, ...)
 	}
 	return (int)text.Len();
 }
+//==========================================================================
+//
+// D_PrefetchStartupLumps
+//
+// Decompresses the definition lumps and the texture namespaces on the
+// worker threads so that the parsers and the texture manager do not have
+// to inflate them one by one when they get to them.
+//
+//==========================================================================
+
+static FTaskGroup PrefetchTasks;
+
+static void D_PrefetchStartupLumps()
+{
+	static const char* const definitionLumps[] =
+	{
+		"MAPINFO", "ZMAPINFO", "UMAPINFO", "SNDINFO", "SNDSEQ", "LANGUAGE", "TEXTURES", "ANIMDEFS",
+		"ZSCRIPT", "DECORATE", "GLDEFS", "DOOMDEFS", "HTICDEFS", "HEXNDEFS", "STRFDEFS", "DECALDEF",
+		"MENUDEF", "SBARINFO", "FONTDEFS", "TRNSLATE", "TERRAIN", "LOCKDEFS", "KEYCONF", "MUSINFO",
+	};
+
+	if (fs_prefetchsize <= 0) return;
+
+	std::vector<int> definitions, graphics;
+	int numlumps = fileSystem.GetNumEntries();
+	for (int i = 0; i < numlumps; i++)
+	{
+		switch (fileSystem.GetFileNamespace(i))
+		{
+		case ns_sprites:
+		case ns_flats:
+		case ns_patches:
+		case ns_graphics:
+		case ns_newtextures:
+			graphics.push_back(i);
+			break;
+
+		case ns_global:
+		{
+			// ZScript includes can have any name but usually use one of the script extensions.
+			auto ext = strrchr(fileSystem.GetFileFullName(i), '.');
+			if (ext != nullptr && (!stricmp(ext, ".zs") || !stricmp(ext, ".zsc") || !stricmp(ext, ".zc")))
+			{
+				definitions.push_back(i);
+				break;
+			}
+			auto name = fileSystem.GetFileShortName(i);
+			for (auto deflump : definitionLumps)
+			{
+				if (!stricmp(name, deflump))
+				{
+					definitions.push_back(i);
+					break;
+				}
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	// The definitions are small and mostly needed first.
+	definitions.insert(definitions.end(), graphics.begin(), graphics.end());
+	if (definitions.size() == 0) return;
+	fileSystem.PrefetchFiles(definitions, [](std::function<void()> func) { PrefetchTasks.Run(std::move(func)); }, (size_t)*fs_prefetchsize << 20);
+}
+
 //==========================================================================
 //
 // D_InitGame
@@ -3388,6 +3462,16 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 
 	bool allowduplicates = Args->CheckParm("-allowduplicates");
 	auto hashfile = D_GetHashFile();
+	fileSystem.SetMapFiles(fs_mapfiles && !Args->CheckParm("-nomapfiles"));
+	if (fs_dircache && !Args->CheckParm("-nodircache"))
+	{
+		FString cachepath = M_GetCachePath(true);
+		CreatePath(cachepath.GetChars());
+		cachepath << "/dircache.fsdc";
+		FStringf tag("%s %s", GetVersionString(), GetGitHash());
+		fileSystem.SetDirectoryCache(cachepath.GetChars(), tag.GetChars());
+	}
+	else fileSystem.SetDirectoryCache(nullptr, nullptr);
 	if (!fileSystem.InitMultipleFiles(allwads, &lfi, FileSystemPrintf, allowduplicates, hashfile))
 	{
 		I_FatalError("FileSystem: no files found");
@@ -3395,6 +3479,7 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 	allwads.clear();
 	allwads.shrink_to_fit();
 	SetMapxxFlag();
+	D_PrefetchStartupLumps();
 
 	D_GrabCVarDefaults(); //parse DEFCVARS
 	InitPalette();
@@ -3569,6 +3654,9 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 	if (!batchrun) Printf ("DecalLibrary: Load decals.\n");
 	DecalLibrary.ReadAllDecals ();
 
+	// Everything the prefetcher was meant for has been parsed by now.
+	fileSystem.EndPrefetch();
+
 	auto numbasesounds = soundEngine->GetNumSounds();
 
 	// Load embedded Dehacked patches
@@ -3743,6 +3831,11 @@ static int D_InitGame(const FIWADInfo* iwad_info, std::vector<std::string>& allw
 		else
 		{
 			v = Args->CheckValue("-timedemo");
+#if HAVE_RT
+			// -rtbench <demo>: same as -timedemo, but also reports the RT frontend's per-frame CPU cost.
+			// Add -rtheadless to leave the GPU out; that still needs the Win32 window, as RTGL1 is built with RG_USE_SURFACE_WIN32.
+			if (!v) v = Args->CheckValue("-rtbench");
+#endif
 			if (v)
 			{
 				G_TimeDemo(v);
@@ -4038,6 +4131,7 @@ int GameMain()
 	C_InitCVars(0);
 	C_InstallHandlers(&cb);
 	SetConsoleNotifyBuffer();
+	FTaskScheduler::Init();
 
 	try
 	{
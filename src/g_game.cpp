@@ -92,6 +92,10 @@
 #include "i_interface.h"
 #include "fs_findfile.h"
 
+#if HAVE_RT
+#include "rt/rt_headless.h"
+#endif
+
 
 static FRandom pr_dmspawn ("DMSpawn");
 static FRandom pr_pspawn ("PlayerSpawn");
@@ -116,6 +120,7 @@ void STAT_Serialize(FSerializer &file);
 
 CVARD_NAMED(Int, gameskill, skill, 2, CVAR_SERVERINFO|CVAR_LATCH, "sets the skill for the next newly started game")
 CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_binary, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)		// use the binary format for saves and hub snapshots (much faster, but not human readable). Ignored if save_formatted is on.
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
@@ -2395,7 +2400,8 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	FSerializer savegameglobals;	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	if (save_binary && !save_formatted) savegameglobals.OpenBinaryWriter();
+	else savegameglobals.OpenWriter(save_formatted);
 
 	SaveVersion = SAVEVER;
 	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
@@ -3030,6 +3036,9 @@ bool G_CheckDemoStatus (void)
 		{
 			if (timingdemo)
 			{
+#if HAVE_RT
+				RT_BenchPrintReport();
+#endif
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
@@ -667,11 +667,13 @@ public:
 	DSeqNode *SequenceListHead;
 
 	// [RH] particle globals
-	uint32_t			OldestParticle; // [MC] Oldest particle for replacing with SPF_REPLACE
-	uint32_t			ActiveParticles;
-	uint32_t			InactiveParticles;
 	TArray<particle_t>	Particles;
-	TArray<uint16_t>	ParticlesInSubsec;
+	FParticleMotion		ParticleMotion;
+	TArray<uint32_t>	FreeParticles;
+	TArray<uint32_t>	NewParticles;		// spawned since the last P_ThinkParticles
+	uint32_t			OldestParticle;		// [MC] Oldest particle for replacing with SPF_REPLACE, index into ParticleMotion
+	uint32_t			OldestNewParticle;	// the same for NewParticles, once all of ParticleMotion has been replaced
+	TArray<uint32_t>	ParticlesInSubsec;
 	FThinkerCollection Thinkers;
 
 	TArray<DVector2>	Scrolls;		// NULL if no DScrollers in this level
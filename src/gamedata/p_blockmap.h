@@ -41,6 +41,17 @@ struct FBlockmap
 	double				bmaporgy;		// origin of block map
 	FBlockNode**		blocklinks; 	// for thing chains
 
+	// Structure-of-arrays copy of the block line lists for the path traverser.
+	// Built on first use. Entries for lines that can move store the line number
+	// complemented and must be checked against the line itself.
+	struct FLineCache
+	{
+		TArray<int>		Start;			// first entry of each block, plus the end of the last one
+		TArray<int>		Line;
+		TArray<double>	X1, Y1, X2, Y2;
+	};
+	FLineCache			linecache;
+
 	// mapblocks are used to check movement
 	// against lines and things
 	static constexpr int MAPBLOCKUNITS = 128;
@@ -84,6 +95,12 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = nullptr;
 		}
+		linecache.Start.Reset();
+		linecache.Line.Reset();
+		linecache.X1.Reset();
+		linecache.Y1.Reset();
+		linecache.X2.Reset();
+		linecache.Y2.Reset();
 	}
 
 	~FBlockmap()
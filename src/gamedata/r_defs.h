@@ -623,6 +623,10 @@ FSerializer &Serialize(FSerializer &arc, const char *key, secspecial_t &spec, se
 
 enum class EMoveResult { ok, crushed, pastdest };
 
+#if HAVE_RT
+void RT_MarkSectorPlanesChanged(const sector_t *sector);
+#endif
+
 struct sector_t
 {
 
@@ -1115,6 +1119,9 @@ public:
 
 	void SetAllVerticesDirty()
 	{
+#if HAVE_RT
+		RT_MarkSectorPlanesChanged(this);
+#endif
 		SetVerticesDirty();
 		for (unsigned i = 0; i < e->FakeFloor.Sectors.Size(); i++) e->FakeFloor.Sectors[i]->SetVerticesDirty();
 		for (unsigned i = 0; i < e->XFloor.attached.Size(); i++) e->XFloor.attached[i]->SetVerticesDirty();
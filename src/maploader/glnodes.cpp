@@ -998,7 +998,7 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 typedef TArray<uint8_t> MemFile;
 
 
-static FString CreateCacheName(MapData *map, bool create)
+static FString CreateCacheName(MapData *map, bool create, const char *ext = ".gzc")
 {
 	FString path = M_GetCachePath(create);
 	FString lumpname = fileSystem.GetFileFullPath(map->lumpnum).c_str();
@@ -1008,7 +1008,7 @@ static FString CreateCacheName(MapData *map, bool create)
 
 	lumpname.ReplaceChars('/', '%');
 	lumpname.ReplaceChars(':', '$');
-	path << '/' << lumpname.Right((ptrdiff_t)lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right((ptrdiff_t)lumpname.Len() - separator - 1) << ext;
 	return path;
 }
 
@@ -1197,6 +1197,298 @@ bool MapLoader::CheckCachedNodes(MapData *map)
 	return true;
 }
 
+//==========================================================================
+//
+// Blockmap caching
+//
+// Generated blockmaps are stored in a .gzb file next to the cached nodes.
+// Since node building and compatibility fixes can alter the vertices the
+// blockmap was made from, the final layout is checked along with the
+// map's MD5.
+//
+// Only the blockmap and the generated reject table are cached. The other
+// derived data (line groups, zones, sections, portal groups) is made by
+// linear passes over the loaded level and is not worth a file of its own.
+//
+//==========================================================================
+
+enum
+{
+	BLOCKMAP_CACHE_VERSION = 1,
+	BLOCKMAP_CACHE_HEADER = 40
+};
+
+// Checksums a stream of 32 bit values, the same as writing them out with
+// WriteLong would, without keeping the whole stream in memory.
+class FLayoutChecksum
+{
+	uint32_t Buffer[1024];
+	unsigned Count = 0;
+	uLong CRC;
+
+	void Flush()
+	{
+		CRC = crc32(CRC, (const Bytef *)Buffer, Count * sizeof(uint32_t));
+		Count = 0;
+	}
+
+public:
+	FLayoutChecksum(uint32_t start = 0) : CRC(start) {}
+
+	void Add(uint32_t value)
+	{
+		Buffer[Count++] = LittleLong(value);
+		if (Count == countof(Buffer)) Flush();
+	}
+
+	uint32_t Finish()
+	{
+		Flush();
+		return (uint32_t)CRC;
+	}
+};
+
+uint32_t MapLoader::BlockMapLayoutChecksum()
+{
+	FLayoutChecksum layout;
+
+	for (auto &vert : Level->vertexes)
+	{
+		layout.Add(vert.fixX());
+		layout.Add(vert.fixY());
+	}
+	for (auto &line : Level->lines)
+	{
+		layout.Add(Index(line.v1));
+		layout.Add(Index(line.v2));
+	}
+	return layout.Finish();
+}
+
+void MapLoader::CreateCachedBlockMap(MapData *map, unsigned count)
+{
+	MemFile data;
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		WriteLong(data, Level->blockmap.blockmaplump[i]);
+	}
+
+	uLongf outlen = compressBound(data.Size());
+	TArray<Bytef> compressed(outlen + BLOCKMAP_CACHE_HEADER, true);
+	if (compress(compressed.Data() + BLOCKMAP_CACHE_HEADER, &outlen, data.Data(), data.Size()) != Z_OK)
+	{
+		return;
+	}
+
+	uint32_t header[5] =
+	{
+		LittleLong(uint32_t(BLOCKMAP_CACHE_VERSION)),
+		LittleLong(Level->vertexes.Size()),
+		LittleLong(Level->lines.Size()),
+		LittleLong(BlockMapLayoutChecksum()),
+		LittleLong(count)
+	};
+	memcpy(compressed.Data(), "BMAP", 4);
+	map->GetChecksum(&compressed[4]);
+	memcpy(&compressed[20], header, sizeof(header));
+
+	FString path = CreateCacheName(map, true, ".gzb");
+	FileWriter *fw = FileWriter::Open(path.GetChars());
+
+	if (fw != nullptr)
+	{
+		const size_t length = outlen + BLOCKMAP_CACHE_HEADER;
+		if (fw->Write(compressed.Data(), length) != length)
+		{
+			Printf("Error saving blockmap to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open blockmap file %s for writing\n", path.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// Deflate cannot expand data by more than about 1032:1, so a cache file
+// claiming more than that is corrupt and must not get its size allocated.
+//
+//==========================================================================
+
+static bool CheckCacheSize(uint64_t size, size_t compressed)
+{
+	return size <= INT_MAX && size <= (uint64_t)compressed * 1032;
+}
+
+bool MapLoader::CheckCachedBlockMap(MapData *map)
+{
+	uint8_t header[BLOCKMAP_CACHE_HEADER];
+	uint8_t md5map[16];
+	uint32_t values[5];
+
+	FString path = CreateCacheName(map, false, ".gzb");
+	FileReader fr;
+
+	if (!fr.OpenFile(path.GetChars())) return false;
+	if (fr.Read(header, BLOCKMAP_CACHE_HEADER) != BLOCKMAP_CACHE_HEADER) return false;
+	if (memcmp(header, "BMAP", 4)) return false;
+
+	map->GetChecksum(md5map);
+	if (memcmp(&header[4], md5map, 16)) return false;
+
+	memcpy(values, &header[20], sizeof(values));
+	for (auto &v : values) v = LittleLong(v);
+	if (values[0] != BLOCKMAP_CACHE_VERSION) return false;
+	if (values[1] != Level->vertexes.Size() || values[2] != Level->lines.Size()) return false;
+	if (values[3] != BlockMapLayoutChecksum()) return false;
+
+	const uint32_t count = values[4];
+	if (count < 4) return false;
+
+	auto compressed = fr.Read(fr.GetLength() - BLOCKMAP_CACHE_HEADER);
+	if (!CheckCacheSize((uint64_t)count * sizeof(uint32_t), compressed.size())) return false;
+	TArray<uint32_t> data(count, true);
+	uLongf outlen = count * sizeof(uint32_t);
+	if (uncompress((Bytef *)data.Data(), &outlen, (const Bytef *)compressed.data(), (uLong)compressed.size()) != Z_OK ||
+		outlen != count * sizeof(uint32_t))
+	{
+		return false;
+	}
+
+	int *blockmap = new int[count];
+	for (unsigned i = 0; i < count; i++)
+	{
+		blockmap[i] = LittleLong(data[i]);
+	}
+	Level->blockmap.blockmaplump = blockmap;
+	if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
+	{
+		delete[] blockmap;
+		Level->blockmap.blockmaplump = nullptr;
+		return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Reject caching
+//
+// Generated reject tables are stored in a .gzr file. Apart from the
+// blockmap's layout they also depend on the BSP the map ended up with,
+// so the segs are part of the check, too.
+//
+//==========================================================================
+
+enum
+{
+	REJECT_CACHE_VERSION = 1,
+	REJECT_CACHE_HEADER = 40
+};
+
+uint32_t MapLoader::RejectLayoutChecksum()
+{
+	FLayoutChecksum layout(BlockMapLayoutChecksum());
+
+	for (auto &seg : Level->segs)
+	{
+		layout.Add(Index(seg.v1));
+		layout.Add(Index(seg.v2));
+		layout.Add(seg.linedef != nullptr ? Index(seg.linedef) : -1);
+		layout.Add(seg.PartnerSeg != nullptr ? Index(seg.PartnerSeg) : -1);
+		layout.Add(seg.Subsector != nullptr ? Index(seg.Subsector) : -1);
+	}
+	for (auto &sub : Level->subsectors)
+	{
+		layout.Add(Index(sub.sector));
+	}
+	return layout.Finish();
+}
+
+void MapLoader::CreateCachedReject(MapData *map)
+{
+	auto &reject = Level->rejectmatrix;
+
+	uLongf outlen = compressBound(reject.Size());
+	TArray<Bytef> compressed(outlen + REJECT_CACHE_HEADER, true);
+	if (compress(compressed.Data() + REJECT_CACHE_HEADER, &outlen, reject.Data(), reject.Size()) != Z_OK)
+	{
+		return;
+	}
+
+	uint32_t header[5] =
+	{
+		LittleLong(uint32_t(REJECT_CACHE_VERSION)),
+		LittleLong(Level->sectors.Size()),
+		LittleLong(Level->segs.Size()),
+		LittleLong(RejectLayoutChecksum()),
+		LittleLong(reject.Size())
+	};
+	memcpy(compressed.Data(), "RJCT", 4);
+	map->GetChecksum(&compressed[4]);
+	memcpy(&compressed[20], header, sizeof(header));
+
+	FString path = CreateCacheName(map, true, ".gzr");
+	FileWriter *fw = FileWriter::Open(path.GetChars());
+
+	if (fw != nullptr)
+	{
+		const size_t length = outlen + REJECT_CACHE_HEADER;
+		if (fw->Write(compressed.Data(), length) != length)
+		{
+			Printf("Error saving reject to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open reject file %s for writing\n", path.GetChars());
+	}
+}
+
+bool MapLoader::CheckCachedReject(MapData *map)
+{
+	uint8_t header[REJECT_CACHE_HEADER];
+	uint8_t md5map[16];
+	uint32_t values[5];
+
+	FString path = CreateCacheName(map, false, ".gzr");
+	FileReader fr;
+
+	if (!fr.OpenFile(path.GetChars())) return false;
+	if (fr.Read(header, REJECT_CACHE_HEADER) != REJECT_CACHE_HEADER) return false;
+	if (memcmp(header, "RJCT", 4)) return false;
+
+	map->GetChecksum(md5map);
+	if (memcmp(&header[4], md5map, 16)) return false;
+
+	memcpy(values, &header[20], sizeof(values));
+	for (auto &v : values) v = LittleLong(v);
+	if (values[0] != REJECT_CACHE_VERSION) return false;
+	if (values[1] != Level->sectors.Size() || values[2] != Level->segs.Size()) return false;
+	if (values[3] != RejectLayoutChecksum()) return false;
+
+	// An empty table is cached as well, it means that nothing could be rejected.
+	const uint32_t count = values[4];
+	const uint64_t numsectors = Level->sectors.Size();
+	if (count != 0 && count != (numsectors * numsectors + 7) / 8) return false;
+
+	auto compressed = fr.Read(fr.GetLength() - REJECT_CACHE_HEADER);
+	if (!CheckCacheSize(count, compressed.size())) return false;
+	TArray<uint8_t> data(count, true);
+	uLongf outlen = count;
+	if (count > 0 && (uncompress(data.Data(), &outlen, (const Bytef *)compressed.data(), (uLong)compressed.size()) != Z_OK ||
+		outlen != count))
+	{
+		return false;
+	}
+	Level->rejectmatrix = std::move(data);
+	return true;
+}
+
 UNSAFE_CCMD(clearnodecache)
 {
 	FileSys::FileList list;
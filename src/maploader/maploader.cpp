@@ -93,6 +93,7 @@ enum
 
 CVAR (Bool, genblockmap, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
+EXTERN_CVAR (Bool, gl_cacheblockmap)
 
 inline bool P_LoadBuildMap(uint8_t *mapdata, size_t len, FMapThing **things, int *numthings)
 {
@@ -2330,7 +2331,7 @@ static void CreatePackedBlockmap (TArray<int> &BlockMap, TArray<int> *blocks, in
 }
 
 
-void MapLoader::CreateBlockMap ()
+unsigned MapLoader::CreateBlockMap ()
 {
 	enum
 	{
@@ -2347,7 +2348,7 @@ void MapLoader::CreateBlockMap ()
 	int line;
 
 	if (Level->vertexes.Size() == 0)
-		return;
+		return 0;
 
 	// Find map extents for the blockmap
 	dminx = dmaxx = Level->vertexes[0].fX();
@@ -2502,6 +2503,31 @@ void MapLoader::CreateBlockMap ()
 	{
 		Level->blockmap.blockmaplump[ii] = BlockMap[ii];
 	}
+	return BlockMap.Size();
+}
+
+//===========================================================================
+//
+// Gets a generated blockmap from the cache if possible and creates it
+// otherwise.
+//
+//===========================================================================
+
+void MapLoader::GenerateBlockMap (MapData *map)
+{
+	const bool usecache = gl_cacheblockmap && Level->maptype != MAPTYPE_BUILD;
+
+	if (usecache && CheckCachedBlockMap(map))
+	{
+		DPrintf (DMSG_SPAMMY, "Using cached BLOCKMAP\n");
+		return;
+	}
+	DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
+	unsigned count = CreateBlockMap ();
+	if (usecache && count > 0)
+	{
+		CreateCachedBlockMap(map, count);
+	}
 }
 
 
@@ -2609,8 +2635,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 		Args->CheckParm("-blockmap")
 		)
 	{
-		DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-		CreateBlockMap ();
+		GenerateBlockMap (map);
 	}
 	else
 	{
@@ -2639,8 +2664,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 		if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
 		{
-			DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-			CreateBlockMap();
+			GenerateBlockMap (map);
 		}
 
 	}
@@ -3198,6 +3222,9 @@ void MapLoader::LoadLevel(MapData *map, const char *lumpname, int position)
 	// Create the item indices, after the last function which may change the data has run.
 	CalcIndices();
 
+	// Needs the final BSP, so this can only be done after the map data is complete.
+	GenerateReject(map);
+
 	Level->bodyqueslot = 0;
 	// phares 8/10/98: Clear body queue so the corpses from previous games are
 	// not assumed to be from this one.
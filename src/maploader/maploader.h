@@ -166,6 +166,12 @@ private:
 	bool LoadNodes(FileReader &lump);
 	bool DoLoadGLNodes(FileReader * lumps);
 	void CreateCachedNodes(MapData *map);
+	uint32_t BlockMapLayoutChecksum();
+	void CreateCachedBlockMap(MapData *map, unsigned count);
+	bool CheckCachedBlockMap(MapData *map);
+	uint32_t RejectLayoutChecksum();
+	void CreateCachedReject(MapData *map);
+	bool CheckCachedReject(MapData *map);
 
 	// Render info
 	void PrepareSectorData();
@@ -232,7 +238,9 @@ private:
 	void AllocateSideDefs(MapData *map, int count);
 	void ProcessSideTextures(bool checktranmap, side_t *sd, sector_t *sec, intmapsidedef_t *msd, int special, int tag, short *alpha, FMissingTextureTracker &missingtex);
 	void SetMapThingUserData(AActor *actor, unsigned udi);
-	void CreateBlockMap();
+	unsigned CreateBlockMap();
+	void GenerateBlockMap(MapData *map);
+	void GenerateReject(MapData *map);
 	void PO_Init(void);
 
 	// During map init the items' own Index functions should not be used.
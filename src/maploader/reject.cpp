@@ -0,0 +1,532 @@
+/*
+** reject.cpp
+** Generates a reject table for maps that do not come with one
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** A line of sight can only get from one subsector into the next through a
+** seg that is not part of a one-sided line, and all segs it passes must be
+** hit by one straight line. Like a vis tool, the builder follows these segs
+** from every sector and clips each further seg to the area that can be seen
+** through the first and the last seg passed. This may find too much but
+** never too little, so the resulting table only rejects what P_CheckSight
+** could never see anyway.
+**
+** Floor and ceiling heights are ignored, so moving sectors cannot reveal
+** anything the table rejects. Polyobject segs never block anything, since
+** the polyobject may have moved away from them. Maps with linked portals
+** discard the table in InitPortalGroups, like they do with a REJECT lump.
+*/
+
+#include "p_local.h"
+#include "p_lnspec.h"
+#include "p_setup.h"
+#include "g_levellocals.h"
+#include "i_time.h"
+#include "parallel_for.h"
+#include "maploader.h"
+
+CVAR (Bool, genreject, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
+
+constexpr int REJECT_MAX_SECTORS = 8192;		// the table needs sectors² bits
+constexpr int REJECT_MAX_STEPS = 1 << 18;		// segs to clip for one source subsector before giving up on it
+constexpr int REJECT_MAX_DEPTH = 1024;
+constexpr int REJECT_GRID = 128;				// steps along a seg that the windows a seg was passed with are widened to (at most 255)
+
+// Clipping tolerance in map units. Everything within this distance is considered visible.
+static const double REJECT_EPSILON = 0.5;
+
+struct FRejectPortal
+{
+	DVector2 v1, v2;	// as seen when leaving the subsector
+	int dest;			// subsector on the other side
+	int partner;		// the same seg seen from the other side
+};
+
+//==========================================================================
+//
+// Keeps the part of c1-c2 on the given side of the line through a and b.
+//
+//==========================================================================
+
+static inline double PointSide(const DVector2 &a, const DVector2 &b, const DVector2 &p)
+{
+	return (b.X - a.X) * (p.Y - a.Y) - (b.Y - a.Y) * (p.X - a.X);
+}
+
+static bool ClipToLine(DVector2 &c1, DVector2 &c2, const DVector2 &a, const DVector2 &b, double side)
+{
+	double len = (b - a).Length();
+	if (len < REJECT_EPSILON)
+	{
+		// Too short to give a reliable direction.
+		return true;
+	}
+	double d1 = PointSide(a, b, c1) * side / len + REJECT_EPSILON;
+	double d2 = PointSide(a, b, c2) * side / len + REJECT_EPSILON;
+
+	if (d1 < 0 && d2 < 0) return false;
+	if (d1 < 0) c1 += (c2 - c1) * (d1 / (d1 - d2));
+	else if (d2 < 0) c2 += (c1 - c2) * (d2 / (d2 - d1));
+	return true;
+}
+
+//==========================================================================
+//
+// Clips target to the lines that pass through one end each of source and
+// pass and have the other ends on opposite sides. Every straight line
+// through source and pass stays on the same side of these as the rest of
+// pass.
+//
+//==========================================================================
+
+static bool ClipToSeparators(const DVector2 *source, const DVector2 *pass, DVector2 *target)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			const DVector2 &a = source[i];
+			const DVector2 &b = pass[j];
+			double s = PointSide(a, b, source[i ^ 1]);
+			double p = PointSide(a, b, pass[j ^ 1]);
+
+			if (s * p >= 0) continue;
+			if (!ClipToLine(target[0], target[1], a, b, p > 0 ? 1. : -1.)) return false;
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Follows the open segs from one sector. Each sector is handled by a
+// separate instance, so sectors can be processed in parallel.
+//
+// Where the flow can go on from a seg only depends on the part of the
+// source seg it started from and the part of this seg it passed, so each
+// seg remembers the widest pair of windows it has been passed with and
+// anything inside them is not followed again. Windows are widened to a
+// fixed grid, which limits how often a seg can be passed with a wider pair.
+//
+//==========================================================================
+
+class FRejectFlow
+{
+	struct Window
+	{
+		int Stamp;
+		uint8_t Source[2];
+		uint8_t Pass[2];
+	};
+
+	const TArray<FRejectPortal> &Portals;
+	const TArray<int> &FirstPortal;
+	const TArray<int> &SubsectorSector;
+	TArray<Window> Windows;
+	const FRejectPortal *Source;
+	uint8_t *Row;
+	int Stamp;
+	int Steps;
+
+	void Mark(int sector)
+	{
+		if (sector >= 0) Row[sector >> 3] |= 1 << (sector & 7);
+	}
+
+	bool Widen(int portal, DVector2 *target, DVector2 *source);
+	bool Flow(const DVector2 *source, const DVector2 *pass, int from, int depth);
+
+public:
+	FRejectFlow(const TArray<FRejectPortal> &portals, const TArray<int> &first, const TArray<int> &sectors, uint8_t *row)
+		: Portals(portals), FirstPortal(first), SubsectorSector(sectors), Windows(portals.Size(), true), Source(nullptr), Row(row), Stamp(0), Steps(0)
+	{
+		for (auto &w : Windows) w.Stamp = 0;
+	}
+
+	bool FlowSubsector(int sub);
+};
+
+//==========================================================================
+//
+// Converts a part of a seg to grid positions along it, rounding outwards.
+//
+//==========================================================================
+
+static void ToGrid(const DVector2 &v1, const DVector2 &v2, const DVector2 *window, uint8_t *grid)
+{
+	DVector2 delta = v2 - v1;
+	double len = delta.X * delta.X + delta.Y * delta.Y;
+	if (len <= 0)
+	{
+		grid[0] = 0;
+		grid[1] = REJECT_GRID;
+		return;
+	}
+	double t1 = ((window[0].X - v1.X) * delta.X + (window[0].Y - v1.Y) * delta.Y) / len;
+	double t2 = ((window[1].X - v1.X) * delta.X + (window[1].Y - v1.Y) * delta.Y) / len;
+	if (t1 > t2) std::swap(t1, t2);
+	grid[0] = (uint8_t)clamp<double>(floor(t1 * REJECT_GRID), 0, REJECT_GRID);
+	grid[1] = (uint8_t)clamp<double>(ceil(t2 * REJECT_GRID), 0, REJECT_GRID);
+}
+
+static void FromGrid(const DVector2 &v1, const DVector2 &v2, const uint8_t *grid, DVector2 *window)
+{
+	DVector2 delta = v2 - v1;
+	window[0] = v1 + delta * (grid[0] * (1. / REJECT_GRID));
+	window[1] = v1 + delta * (grid[1] * (1. / REJECT_GRID));
+}
+
+//==========================================================================
+//
+// Merges the windows a seg is passed with into the ones it already had.
+// Returns false if they were covered already. Otherwise the windows are
+// replaced by the merged ones, which is what the flow goes on with.
+//
+//==========================================================================
+
+bool FRejectFlow::Widen(int portal, DVector2 *target, DVector2 *source)
+{
+	auto &p = Portals[portal];
+	auto &w = Windows[portal];
+	uint8_t src[2], pass[2];
+
+	ToGrid(Source->v1, Source->v2, source, src);
+	ToGrid(p.v1, p.v2, target, pass);
+	if (w.Stamp == Stamp)
+	{
+		if (src[0] >= w.Source[0] && src[1] <= w.Source[1] && pass[0] >= w.Pass[0] && pass[1] <= w.Pass[1]) return false;
+		src[0] = min(src[0], w.Source[0]);
+		src[1] = max(src[1], w.Source[1]);
+		pass[0] = min(pass[0], w.Pass[0]);
+		pass[1] = max(pass[1], w.Pass[1]);
+	}
+	w.Stamp = Stamp;
+	w.Source[0] = src[0];
+	w.Source[1] = src[1];
+	w.Pass[0] = pass[0];
+	w.Pass[1] = pass[1];
+
+	FromGrid(Source->v1, Source->v2, src, source);
+	FromGrid(p.v1, p.v2, pass, target);
+	return true;
+}
+
+bool FRejectFlow::Flow(const DVector2 *source, const DVector2 *pass, int from, int depth)
+{
+	if (depth >= REJECT_MAX_DEPTH) return false;
+
+	int sub = Portals[from].dest;
+	for (int i = FirstPortal[sub]; i < FirstPortal[sub + 1]; i++)
+	{
+		auto &portal = Portals[i];
+		if (i == Portals[from].partner) continue;
+		if (++Steps > REJECT_MAX_STEPS) return false;
+
+		DVector2 target[2] = { portal.v1, portal.v2 };
+		DVector2 newsource[2] = { source[0], source[1] };
+
+		// Sight can never get back behind the source seg.
+		if (!ClipToLine(target[0], target[1], Source->v1, Source->v2, 1.)) continue;
+		if (depth > 0)
+		{
+			if (!ClipToSeparators(source, pass, target)) continue;
+			if (!ClipToSeparators(target, pass, newsource)) continue;
+		}
+		if (!Widen(i, target, newsource)) continue;
+
+		Mark(SubsectorSector[portal.dest]);
+		if (!Flow(newsource, target, i, depth + 1)) return false;
+	}
+	return true;
+}
+
+bool FRejectFlow::FlowSubsector(int sub)
+{
+	int sector = SubsectorSector[sub];
+
+	Mark(sector);
+	Steps = 0;
+	for (int i = FirstPortal[sub]; i < FirstPortal[sub + 1]; i++)
+	{
+		auto &portal = Portals[i];
+
+		// Sight that leaves the sector at all leaves it through one of these first,
+		// so segs that lead into the same sector need not be followed from.
+		if (SubsectorSector[portal.dest] == sector) continue;
+
+		DVector2 source[2] = { portal.v1, portal.v2 };
+
+		Source = &portal;
+		Stamp++;
+		Mark(SubsectorSector[portal.dest]);
+		if (!Flow(source, source, i, 0)) return false;
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Polyobject lines are part of the BSP where they were drawn, but they can
+// move away from there. They are found the same way SpawnPolyobj does,
+// which only runs later, and numbered by polyobject.
+//
+//==========================================================================
+
+static int FindPolyobjectLines(FLevelLocals *Level, TArray<int> &linepoly)
+{
+	TMap<int, int> groups;
+	int numgroups = 0;
+
+	auto group = [&](int tag)
+	{
+		int *g = groups.CheckKey(tag);
+		if (g != nullptr) return *g;
+		groups[tag] = numgroups;
+		return numgroups++;
+	};
+
+	linepoly.Resize(Level->lines.Size());
+	for (auto &l : linepoly) l = -1;
+
+	TArray<int> firstside(Level->vertexes.Size(), true);
+	TArray<int> nextside(Level->sides.Size(), true);
+	for (auto &f : firstside) f = -1;
+	for (int i = Level->sides.Size() - 1; i >= 0; i--)
+	{
+		int v = Level->sides[i].V1()->Index();
+		nextside[i] = firstside[v];
+		firstside[v] = i;
+	}
+
+	TArray<uint8_t> seen(Level->vertexes.Size(), true);
+	TArray<int> vnum;
+	memset(seen.Data(), 0, seen.Size());
+
+	for (auto &line : Level->lines)
+	{
+		if (line.special == Polyobj_ExplicitLine)
+		{
+			linepoly[line.Index()] = group(line.args[0]);
+		}
+		else if (line.special == Polyobj_StartLine && line.sidedef[0] != nullptr)
+		{
+			int g = group(line.args[0]);
+
+			vnum.Clear();
+			vnum.Push(line.sidedef[0]->V1()->Index());
+			seen[vnum[0]] = true;
+			for (unsigned i = 0; i < vnum.Size(); i++)
+			{
+				for (int sd = firstside[vnum[i]]; sd != -1; sd = nextside[sd])
+				{
+					auto &side = Level->sides[sd];
+					if (linepoly[side.linedef->Index()] == -1) linepoly[side.linedef->Index()] = g;
+
+					int v = side.V2()->Index();
+					if (!seen[v])
+					{
+						seen[v] = true;
+						vnum.Push(v);
+					}
+				}
+			}
+			for (int v : vnum) seen[v] = false;
+		}
+	}
+	return numgroups;
+}
+
+//==========================================================================
+//
+// Collects the open segs of every subsector. Fails if the BSP has segs
+// without a partner, because sight could leak through them.
+//
+// Once a polyobject has moved, sight can pass any of its segs and get out
+// through any other, so each polyobject gets a subsector of its own after
+// the real ones, which all of its segs lead into. Returns the number of
+// subsectors, including these, or -1 on failure.
+//
+//==========================================================================
+
+static int BuildRejectPortals(FLevelLocals *Level, TArray<FRejectPortal> &portals, TArray<int> &first)
+{
+	TArray<int> linepoly;
+	const int numgroups = FindPolyobjectLines(Level, linepoly);
+	const int numsubs = Level->subsectors.Size();
+
+	TArray<int> segportal(Level->segs.Size(), true);
+	TArray<int> polyportal(Level->segs.Size(), true);
+	TArray<TArray<int>> groupsegs(numgroups, true);
+	for (auto &p : segportal) p = -1;
+	for (auto &p : polyportal) p = -1;
+
+	first.Resize(numsubs + numgroups + 1);
+	for (int i = 0; i < numsubs; i++)
+	{
+		auto &sub = Level->subsectors[i];
+
+		first[i] = portals.Size();
+		for (unsigned j = 0; j < sub.numlines; j++)
+		{
+			seg_t *seg = sub.firstline + j;
+			int poly = seg->linedef != nullptr ? linepoly[seg->linedef->Index()] : -1;
+			if (poly >= 0)
+			{
+				polyportal[seg->Index()] = portals.Size();
+				groupsegs[poly].Push(seg->Index());
+				portals.Push({ seg->v1->fPos(), seg->v2->fPos(), numsubs + poly, -1 });
+			}
+
+			if (seg->linedef != nullptr && seg->linedef->backsector == nullptr) continue;
+			if (seg->PartnerSeg == nullptr || seg->PartnerSeg->Subsector == nullptr) return -1;
+
+			segportal[seg->Index()] = portals.Size();
+			portals.Push({ seg->v1->fPos(), seg->v2->fPos(), seg->PartnerSeg->Subsector->Index(), -1 });
+		}
+	}
+	for (int g = 0; g < numgroups; g++)
+	{
+		first[numsubs + g] = portals.Size();
+		for (int segnum : groupsegs[g])
+		{
+			auto &seg = Level->segs[segnum];
+			int p = polyportal[segnum];
+
+			portals[p].partner = portals.Size();
+			portals.Push({ seg.v2->fPos(), seg.v1->fPos(), seg.Subsector->Index(), p });
+		}
+	}
+	first.Last() = portals.Size();
+
+	for (auto &seg : Level->segs)
+	{
+		int p = segportal[seg.Index()];
+		if (p < 0) continue;
+
+		int partner = segportal[seg.PartnerSeg->Index()];
+		if (partner < 0) return -1;
+		portals[p].partner = partner;
+	}
+	return numsubs + numgroups;
+}
+
+//==========================================================================
+//
+// Fills the reject matrix from the BSP if the map has none. This is done
+// during level load and not in the background, because the table affects
+// the random number sequence of P_CheckSight and must be identical on
+// every machine from the first tic.
+//
+//==========================================================================
+
+void MapLoader::GenerateReject(MapData *map)
+{
+	if (!genreject || Level->rejectmatrix.Size() > 0 || Level->maptype == MAPTYPE_BUILD) return;
+	if (Level->gamenodes.Size() > 0 || Level->subsectors.Size() == 0) return;
+
+	const unsigned numsectors = Level->sectors.Size();
+	if (numsectors > REJECT_MAX_SECTORS) return;
+
+	if (CheckCachedReject(map))
+	{
+		DPrintf(DMSG_SPAMMY, "Using cached REJECT\n");
+		return;
+	}
+
+	uint64_t startTime = I_msTime();
+	TArray<FRejectPortal> portals;
+	TArray<int> first;
+
+	const int numsubs = BuildRejectPortals(Level, portals, first);
+	if (numsubs < 0)
+	{
+		DPrintf(DMSG_NOTIFY, "Cannot generate REJECT because the BSP is not closed\n");
+		return;
+	}
+
+	// Polyobjects' subsectors do not belong to any sector.
+	TArray<int> subsectorsector(numsubs, true);
+	TArray<TArray<int>> sectorsubsectors(numsectors, true);
+	for (auto &s : subsectorsector) s = -1;
+	for (auto &sub : Level->subsectors)
+	{
+		subsectorsector[sub.Index()] = sub.sector->Index();
+		sectorsubsectors[sub.sector->Index()].Push(sub.Index());
+	}
+
+	// One byte aligned row per sector so that the rows can be filled in parallel.
+	const unsigned rowsize = (numsectors + 7) / 8;
+	TArray<uint8_t> visible(rowsize * numsectors, true);
+	memset(visible.Data(), 0, visible.Size());
+
+	parallel_for((int)numsectors, [&](int sector)
+	{
+		uint8_t *row = &visible[sector * rowsize];
+		FRejectFlow flow(portals, first, subsectorsector, row);
+
+		for (int sub : sectorsubsectors[sector])
+		{
+			if (!flow.FlowSubsector(sub))
+			{
+				// Too complex to trace, so this sector has to be able to see everything.
+				memset(row, 0xff, rowsize);
+				break;
+			}
+		}
+	});
+
+	auto &reject = Level->rejectmatrix;
+	bool rejected = false;
+
+	reject.Resize((numsectors * numsectors + 7) / 8);
+	memset(reject.Data(), 0, reject.Size());
+	for (unsigned s1 = 0; s1 < numsectors; s1++)
+	{
+		const uint8_t *row1 = &visible[s1 * rowsize];
+		for (unsigned s2 = 0; s2 < numsectors; s2++)
+		{
+			const uint8_t *row2 = &visible[s2 * rowsize];
+			if (!(row1[s2 >> 3] & (1 << (s2 & 7))) && !(row2[s1 >> 3] & (1 << (s1 & 7))))
+			{
+				unsigned pnum = s1 * numsectors + s2;
+				reject[pnum >> 3] |= 1 << (pnum & 7);
+				rejected = true;
+			}
+		}
+	}
+	if (!rejected)
+	{
+		reject.Reset();
+	}
+
+	uint64_t endTime = I_msTime();
+	DPrintf(DMSG_NOTIFY, "REJECT generation took %.3f sec (%u open segs)\n", (endTime - startTime) * 0.001, portals.Size());
+	CreateCachedReject(map);
+}
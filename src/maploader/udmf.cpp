@@ -204,7 +204,7 @@ void UDMFParserBase::Skip()
 FName UDMFParserBase::ParseKey(bool checkblock, bool *isblock)
 {
 	sc.MustGetString();
-	FName key = sc.String;
+	FName key = sc.GetName();
 	if (checkblock)
 	{
 		if (sc.CheckToken('{'))
@@ -2468,8 +2468,9 @@ public:
 		isExtended = false;
 		floordrop = false;
 
-		sc.OpenMem(fileSystem.GetFileFullName(map->lumpnum), map->Read(ML_TEXTMAP));
-		sc.SetCMode(true);
+		// The scanner works on the lump in place, so this must live until parsing is done.
+		auto textmap = map->View(ML_TEXTMAP);
+		sc.OpenMem(fileSystem.GetFileFullName(map->lumpnum), textmap);
 		if (sc.CheckString("namespace"))
 		{
 			sc.MustGetStringName("=");
@@ -3,11 +3,79 @@
 
 #include "sc_man.h"
 #include "m_fixed.h"
+#include "files.h"
+#include "vectors.h"
+
+//===========================================================================
+//
+// Scanner for the UDMF and USDF text formats
+//
+// It only knows the tokens these formats use, works directly on the lump's
+// data and reuses its buffers, so parsing allocates nothing per token.
+// Keys go through a small hash table that maps their text to names,
+// because a map repeats the same few dozen keys over and over.
+// The interface is the subset of FScanner the parsers use.
+//
+//===========================================================================
+
+class FUDMFScanner
+{
+public:
+	// Scans the buffer where it is, so it must stay valid until scanning is done.
+	void OpenMem(const char *name, const FileSys::FileData &buffer);
+
+	bool GetString();
+	void MustGetString();
+	void MustGetStringName(const char *name);
+	bool CheckString(const char *name);
+	bool GetToken();
+	void MustGetAnyToken();
+	void MustGetToken(int token);
+	bool CheckToken(int token);
+	void UnGet();
+	bool Compare(const char *text) const { return stricmp(text, String) == 0; }
+	FName GetName();
+
+	void ScriptError(const char *message, ...) GCCPRINTF(2,3);
+	void ScriptMessage(const char *message, ...) GCCPRINTF(2,3);
+
+	const char *String = "";
+	int StringLen = 0;
+	int TokenType = 0;
+	int Number = 0;
+	double Float = 0;
+	int Line = 1;
+
+private:
+	struct FNameSlot
+	{
+		uint32_t Hash;
+		int Length;		// -1 for empty slots
+		unsigned Offset;
+		FName Name;
+	};
+
+	bool Scan(bool tokens);
+	void ScanNumber(const char *p);
+	void SetString(const char *start, size_t len);
+	void GrowNames();
+
+	FString ScriptName;
+	const char *ScriptPtr = nullptr;
+	const char *ScriptEndPtr = nullptr;
+	const char *LastGotPtr = nullptr;
+	int LastGotLine = 1;
+	bool AlreadyGot = false;
+	TArray<char> StringBuffer;
+	TArray<FNameSlot> NameSlots;
+	TArray<char> NameText;
+	unsigned NumNames = 0;
+};
 
 class UDMFParserBase
 {
 protected:
-	FScanner sc;
+	FUDMFScanner sc;
 	FName namespc = NAME_None;
 	int namespace_bits;
 	FString parsedString;
@@ -0,0 +1,503 @@
+/*
+** udmfscanner.cpp
+** Tokenizer for UDMF and USDF lumps
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 GZDoom Development Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The scanner follows the rules of FScanner in C mode for everything that
+** can appear in a valid UDMF or USDF lump, so both produce the same values.
+*/
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <charconv>
+#include "udmf.h"
+#include "cmdlib.h"
+#include "printf.h"
+#include "engineerrors.h"
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline bool IsHexDigit(char c)
+{
+	return IsDigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+}
+
+static inline bool IsIdentChar(char c)
+{
+	return IsDigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+}
+
+// Characters that always form a token of their own when scanning strings.
+static inline bool IsStopChar(char c)
+{
+	return strchr("{}|=/`~!@#$%^&*()[]\\?-+;:<>,.\"", c) != nullptr;
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: OpenMem
+//
+//===========================================================================
+
+void FUDMFScanner::OpenMem(const char *name, const FileSys::FileData &buffer)
+{
+	ScriptName = name;
+	ScriptPtr = buffer.string();
+	ScriptEndPtr = ScriptPtr + buffer.size();
+
+	// Skip a UTF-8 byte order mark.
+	auto bytes = buffer.bytes();
+	if (buffer.size() >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+	{
+		ScriptPtr += 3;
+	}
+	LastGotPtr = ScriptPtr;
+	LastGotLine = Line = 1;
+	AlreadyGot = false;
+	String = "";
+	StringLen = 0;
+	TokenType = 0;
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: SetString
+//
+// Copies the token's text to the string buffer, which is only reallocated
+// when a token is longer than every one before it.
+//
+//===========================================================================
+
+void FUDMFScanner::SetString(const char *start, size_t len)
+{
+	if (StringBuffer.Size() <= len)
+	{
+		StringBuffer.Resize(unsigned(len + 1 < 256 ? 256 : len + 1));
+	}
+	memcpy(StringBuffer.Data(), start, len);
+	StringBuffer[len] = 0;
+	String = StringBuffer.Data();
+	StringLen = int(len);
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: Scan
+//
+// With tokens set this returns identifiers, numbers and strings as tokens.
+// Otherwise a string is any run of characters up to whitespace or one of
+// the stop characters, as with FScanner::GetString.
+//
+//===========================================================================
+
+bool FUDMFScanner::Scan(bool tokens)
+{
+	if (AlreadyGot)
+	{
+		AlreadyGot = false;
+		ScriptPtr = LastGotPtr;
+		Line = LastGotLine;
+	}
+
+	const char *p = ScriptPtr;
+	const char *end = ScriptEndPtr;
+
+	for (;;)
+	{
+		if (p >= end)
+		{
+			ScriptPtr = end;
+			return false;
+		}
+		if (*p == '\n')
+		{
+			Line++;
+			p++;
+		}
+		else if ((unsigned char)*p <= ' ')
+		{
+			p++;
+		}
+		else if (*p == '/' && p + 1 < end && p[1] == '/')
+		{
+			while (p < end && *p != '\n') p++;
+		}
+		else if (*p == '/' && p + 1 < end && p[1] == '*')
+		{
+			for (p += 2; p < end && !(p[0] == '*' && p + 1 < end && p[1] == '/'); p++)
+			{
+				if (*p == '\n') Line++;
+			}
+			p = p + 2 < end ? p + 2 : end;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	LastGotPtr = p;
+	LastGotLine = Line;
+	const char *tok = p;
+
+	if (*p == '"')
+	{
+		for (p++; p < end && *p != '"'; p++)
+		{
+			if (*p == '\\' && p + 1 < end && p[1] == '"') p++;
+			else if (*p == '\n') Line++;
+		}
+		if (p >= end)
+		{
+			ScriptError("Unterminated string constant");
+			ScriptPtr = end;
+			return false;
+		}
+		ScriptPtr = p + 1;
+		SetString(tok + 1, p - tok - 1);
+		if (tokens)
+		{
+			StringLen = strbin(StringBuffer.Data());
+		}
+		else
+		{
+			// Only escaped quotes are processed when scanning strings.
+			char *out = StringBuffer.Data();
+			for (const char *in = String; *in; in++)
+			{
+				if (in[0] == '\\' && in[1] == '"') in++;
+				*out++ = *in;
+			}
+			*out = 0;
+			StringLen = int(out - String);
+		}
+		TokenType = TK_StringConst;
+		return true;
+	}
+
+	if (!tokens)
+	{
+		if (IsStopChar(*p))
+		{
+			p++;
+		}
+		else
+		{
+			while (p < end && (unsigned char)*p > ' ' && !IsStopChar(*p)) p++;
+		}
+		ScriptPtr = p;
+		SetString(tok, p - tok);
+		return true;
+	}
+
+	if (IsIdentChar(*p) && !IsDigit(*p))
+	{
+		while (p < end && IsIdentChar(*p)) p++;
+		ScriptPtr = p;
+		SetString(tok, p - tok);
+		TokenType = !stricmp(String, "true") ? TK_True : !stricmp(String, "false") ? TK_False : TK_Identifier;
+		return true;
+	}
+
+	if (IsDigit(*p) || (*p == '.' && p + 1 < end && IsDigit(p[1])))
+	{
+		ScanNumber(p);
+		return true;
+	}
+
+	ScriptPtr = p + 1;
+	SetString(tok, 1);
+	TokenType = (unsigned char)*tok;
+	return true;
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: ScanNumber
+//
+// Integers may be decimal, octal or hexadecimal with up to two u/l suffixes,
+// just like in the C mode of FScanner.
+//
+//===========================================================================
+
+void FUDMFScanner::ScanNumber(const char *p)
+{
+	const char *start = p;
+	const char *end = ScriptEndPtr;
+	const char *digits = p;
+	int base = 10;
+	bool isfloat = false;
+
+	if (p[0] == '0' && p + 2 < end && (p[1] | 0x20) == 'x' && IsHexDigit(p[2]))
+	{
+		base = 16;
+		digits = p += 2;
+		while (p < end && IsHexDigit(*p)) p++;
+	}
+	else
+	{
+		while (p < end && IsDigit(*p)) p++;
+		if (p < end && *p == '.')
+		{
+			isfloat = true;
+			for (p++; p < end && IsDigit(*p); p++) {}
+		}
+		if (p < end && (*p | 0x20) == 'e')
+		{
+			const char *exp = p + 1;
+			if (exp < end && (*exp == '+' || *exp == '-')) exp++;
+			if (exp < end && IsDigit(*exp))
+			{
+				isfloat = true;
+				for (p = exp; p < end && IsDigit(*p); p++) {}
+			}
+		}
+		if (!isfloat && *start == '0' && p - start > 1)
+		{
+			base = 8;
+		}
+	}
+	const char *digitsend = p;
+
+	if (isfloat)
+	{
+		if (p < end && (*p | 0x20) == 'f') p++;
+		ScriptPtr = p;
+		SetString(start, p - start);
+		TokenType = TK_FloatConst;
+		Float = strtod(String, nullptr);
+		return;
+	}
+
+	bool isunsigned = false;
+	for (int i = 0; i < 2 && p < end && ((*p | 0x20) == 'u' || (*p | 0x20) == 'l'); i++, p++)
+	{
+		if ((*p | 0x20) == 'u') isunsigned = true;
+	}
+	ScriptPtr = p;
+	SetString(start, p - start);
+
+	if (isunsigned)
+	{
+		uint64_t value = 0;
+		if (std::from_chars(digits, digitsend, value, base).ec == std::errc::result_out_of_range) value = UINT64_MAX;
+		TokenType = TK_UIntConst;
+		Number = (int)value;
+		Float = (unsigned)Number;
+	}
+	else
+	{
+		int64_t value = 0;
+		if (std::from_chars(digits, digitsend, value, base).ec == std::errc::result_out_of_range) value = INT64_MAX;
+		TokenType = TK_IntConst;
+		Number = (int)value;
+		Float = Number;
+	}
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: GetName
+//
+// Returns the current string as a name.
+//
+//===========================================================================
+
+FName FUDMFScanner::GetName()
+{
+	uint32_t hash = 2166136261u;
+	for (int i = 0; i < StringLen; i++)
+	{
+		hash = (hash ^ (uint8_t)String[i]) * 16777619u;
+	}
+
+	if (NumNames * 2 >= NameSlots.Size())
+	{
+		GrowNames();
+	}
+
+	const unsigned mask = NameSlots.Size() - 1;
+	for (unsigned i = hash & mask; ; i = (i + 1) & mask)
+	{
+		FNameSlot &slot = NameSlots[i];
+		if (slot.Length < 0)
+		{
+			slot.Hash = hash;
+			slot.Length = StringLen;
+			slot.Offset = NameText.Reserve(StringLen);
+			memcpy(NameText.Data() + slot.Offset, String, StringLen);
+			slot.Name = FName(String);
+			NumNames++;
+			return slot.Name;
+		}
+		if (slot.Hash == hash && slot.Length == StringLen && !memcmp(NameText.Data() + slot.Offset, String, StringLen))
+		{
+			return slot.Name;
+		}
+	}
+}
+
+void FUDMFScanner::GrowNames()
+{
+	TArray<FNameSlot> old = std::move(NameSlots);
+	NameSlots.Resize(old.Size() == 0 ? 256 : old.Size() * 2);
+	for (auto &slot : NameSlots)
+	{
+		slot.Length = -1;
+	}
+
+	const unsigned mask = NameSlots.Size() - 1;
+	for (auto &slot : old)
+	{
+		if (slot.Length < 0) continue;
+		unsigned i = slot.Hash & mask;
+		while (NameSlots[i].Length >= 0)
+		{
+			i = (i + 1) & mask;
+		}
+		NameSlots[i] = slot;
+	}
+}
+
+//===========================================================================
+//
+// FScanner compatible interface
+//
+//===========================================================================
+
+bool FUDMFScanner::GetString()
+{
+	return Scan(false);
+}
+
+void FUDMFScanner::MustGetString()
+{
+	if (!Scan(false))
+	{
+		ScriptError("Missing string (unexpected end of file).");
+	}
+}
+
+void FUDMFScanner::MustGetStringName(const char *name)
+{
+	MustGetString();
+	if (!Compare(name))
+	{
+		ScriptError("Expected '%s', got '%s'.", name, String);
+	}
+}
+
+bool FUDMFScanner::CheckString(const char *name)
+{
+	if (Scan(false))
+	{
+		if (Compare(name))
+		{
+			return true;
+		}
+		UnGet();
+	}
+	return false;
+}
+
+bool FUDMFScanner::GetToken()
+{
+	return Scan(true);
+}
+
+void FUDMFScanner::MustGetAnyToken()
+{
+	if (!Scan(true))
+	{
+		ScriptError("Missing token (unexpected end of file).");
+	}
+}
+
+void FUDMFScanner::MustGetToken(int token)
+{
+	MustGetAnyToken();
+	if (TokenType != token)
+	{
+		FString tok1 = FScanner::TokenName(token);
+		FString tok2 = FScanner::TokenName(TokenType, String);
+		ScriptError("Expected %s but got %s instead.", tok1.GetChars(), tok2.GetChars());
+	}
+}
+
+bool FUDMFScanner::CheckToken(int token)
+{
+	if (Scan(true))
+	{
+		if (TokenType == token)
+		{
+			return true;
+		}
+		UnGet();
+	}
+	return false;
+}
+
+void FUDMFScanner::UnGet()
+{
+	AlreadyGot = true;
+}
+
+//===========================================================================
+//
+// FUDMFScanner :: ScriptError / ScriptMessage
+//
+//===========================================================================
+
+void FUDMFScanner::ScriptError(const char *message, ...)
+{
+	FString composed;
+	va_list arglist;
+	va_start(arglist, message);
+	composed.VFormat(message, arglist);
+	va_end(arglist);
+
+	I_Error("Script error, \"%s\" line %d:\n%s\n", ScriptName.GetChars(), AlreadyGot ? LastGotLine : Line, composed.GetChars());
+}
+
+void FUDMFScanner::ScriptMessage(const char *message, ...)
+{
+	FString composed;
+	va_list arglist;
+	va_start(arglist, message);
+	composed.VFormat(message, arglist);
+	va_end(arglist);
+
+	Printf(TEXTCOLOR_RED "Script error, \"%s\"" TEXTCOLOR_RED " line %d:\n" TEXTCOLOR_RED "%s\n", ScriptName.GetChars(),
+		AlreadyGot ? LastGotLine : Line, composed.GetChars());
+}
@@ -562,8 +562,8 @@ public:
 	bool Parse(MapLoader *loader,int lumpnum, FileReader &lump, int lumplen)
 	{
 		Level = loader->Level;
-		sc.OpenMem(fileSystem.GetFileFullName(lumpnum), lump.Read(lumplen));
-		sc.SetCMode(true);
+		auto data = lump.Read(lumplen);
+		sc.OpenMem(fileSystem.GetFileFullName(lumpnum), data);
 		// Namespace must be the first field because everything else depends on it.
 		if (sc.CheckString("namespace"))
 		{
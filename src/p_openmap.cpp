@@ -156,6 +156,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 				// The following lump is from a different file so whatever this is,
 				// it is not a multi-lump Doom level so let's assume it is a Build map.
 				map->MapLumps[0].Reader = fileSystem.ReopenFileReader(lump_name);
+				map->MapLumps[0].Lump = lump_name;
 				if (!P_IsBuildMap(map))
 				{
 					delete map;
@@ -167,6 +168,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 			// This case can only happen if the lump is inside a real WAD file.
 			// As such any special handling for other types of lumps is skipped.
 			map->MapLumps[0].Reader = fileSystem.ReopenFileReader(lump_name);
+			map->MapLumps[0].Lump = lump_name;
 			strncpy(map->MapLumps[0].Name, fileSystem.GetFileFullName(lump_name), 8);
 			map->InWad = true;
 
@@ -199,6 +201,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 					if (index < 0) break;
 
 					map->MapLumps[index].Reader = fileSystem.ReopenFileReader(lump_name + i);
+					map->MapLumps[index].Lump = lump_name + i;
 					strncpy(map->MapLumps[index].Name, lumpname, 8);
 				}
 			}
@@ -206,6 +209,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 			{
 				map->isText = true;
 				map->MapLumps[1].Reader = fileSystem.ReopenFileReader(lump_name + 1);
+				map->MapLumps[1].Lump = lump_name + 1;
 				for(int i = 2;; i++)
 				{
 					const char * lumpname = fileSystem.GetFileFullName(lump_name + i);
@@ -246,6 +250,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 					}
 					else continue;
 					map->MapLumps[index].Reader = fileSystem.ReopenFileReader(lump_name + i);
+					map->MapLumps[index].Lump = lump_name + i;
 					strncpy(map->MapLumps[index].Name, lumpname, 8);
 				}
 			}
@@ -281,6 +286,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 		int index=0;
 
 		map->MapLumps[0].Reader = map->resource->GetEntryReader(0, FileSys::READER_SHARED);
+		map->MapLumps[0].Entry = 0;
 		uppercopy(map->MapLumps[0].Name, map->resource->getName(0));
 
 		for(uint32_t i = 1; i < map->resource->EntryCount(); i++)
@@ -291,6 +297,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 			{
 				map->isText = true;
 				map->MapLumps[ML_TEXTMAP].Reader = map->resource->GetEntryReader(i, FileSys::READER_SHARED);
+				map->MapLumps[ML_TEXTMAP].Entry = i;
 				strncpy(map->MapLumps[ML_TEXTMAP].Name, lumpname, 8);
 				for(int i = 2;; i++)
 				{
@@ -327,6 +334,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 					}
 					else continue;
 					map->MapLumps[index].Reader = map->resource->GetEntryReader(i, FileSys::READER_SHARED);
+					map->MapLumps[index].Entry = i;
 					strncpy(map->MapLumps[index].Name, lumpname, 8);
 				}
 			}
@@ -359,6 +367,7 @@ MapData *P_OpenMapData(const char * mapname, bool justcheck)
 			}
 
 			map->MapLumps[index].Reader = map->resource->GetEntryReader(i, FileSys::READER_SHARED);
+			map->MapLumps[index].Entry = i;
 			strncpy(map->MapLumps[index].Name, lumpname, 8);
 		}
 	}
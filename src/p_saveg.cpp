@@ -62,8 +62,12 @@
 #include "fragglescript/t_script.h"
 #include "s_music.h"
 #include "model.h"
+#if HAVE_RT
+#include "rt/rt_helpers.h"
+#endif
 
 EXTERN_CVAR(Bool, save_formatted)
+EXTERN_CVAR(Bool, save_binary)
 
 //==========================================================================
 //
@@ -1072,6 +1076,9 @@ void FLevelLocals::Serialize(FSerializer &arc, bool hubload)
 
 		automap->UpdateShowAllLines();
 
+#if HAVE_RT
+		RT_InvalidateSectorLights();
+#endif
 	}
 	// clean up the static data we allocated
 	StaticClearSerializeTranslationsData();
@@ -1092,7 +1099,7 @@ void FLevelLocals::SnapshotLevel()
 	{
 		FDoomSerializer arc(this);
 
-		if (arc.OpenWriter(save_formatted))
+		if (save_binary && !save_formatted ? arc.OpenBinaryWriter() : arc.OpenWriter(save_formatted))
 		{
 			SaveVersion = SAVEVER;
 			Serialize(arc, false);
@@ -61,6 +61,8 @@ private:
 	{
 		char Name[8] = { 0 };
 		FileReader Reader;
+		int Lump = -1;		// in the file system, if the map is in a real WAD file
+		int Entry = -1;		// in resource otherwise
 	} MapLumps[ML_MAX];
 	FileReader nofile;
 public:
@@ -112,6 +114,24 @@ public:
 		return buffer;
 	}
 
+	// Returns the lump's data. If its file is held in memory and the lump is not
+	// compressed, this references the data where it is instead of copying it.
+	FileSys::FileData View(unsigned lumpindex)
+	{
+		if (lumpindex < countof(MapLumps))
+		{
+			auto &lump = MapLumps[lumpindex];
+			if (lump.Entry >= 0 && resource != nullptr) return resource->Read(lump.Entry);
+			if (lump.Lump >= 0) return fileSystem.ReadFile(lump.Lump);
+			if (lump.Reader.isOpen())
+			{
+				lump.Reader.Seek(0, FileReader::SeekSet);
+				return lump.Reader.Read();
+			}
+		}
+		return FileSys::FileData();
+	}
+
 	uint32_t Size(unsigned int lumpindex)
 	{
 		if (lumpindex<countof(MapLumps) && MapLumps[lumpindex].Reader.isOpen())
@@ -58,6 +58,7 @@
 #include "c_dispatch.h"
 #include "thingdef.h"
 #include "r_utility.h"
+#include "tasks.h"
 #include "doomstat.h"
 #include "serializer.h"
 #include "g_levellocals.h"
@@ -69,6 +70,11 @@ static FMemArena DynLightArena(sizeof(FDynamicLight) * 200);
 static TArray<FDynamicLight*> FreeList;
 static FRandom randLight;
 
+// How far a light may move, relative to its radius, before it needs to be linked again.
+// Links are collected this much beyond the radius, so nothing the light can reach in
+// the meantime is missing from them.
+static const double LinkSlack = 0.25;
+
 extern TArray<FLightDefaults *> StateLights;
 
 
@@ -244,7 +250,7 @@ void FDynamicLight::Activate()
 // [TS]
 //
 //==========================================================================
-void FDynamicLight::Tick()
+void FDynamicLight::Tick(TArray<FDynamicLight *> *relink)
 {
 	if (!target)
 	{
@@ -354,7 +360,7 @@ void FDynamicLight::Tick()
 		break;
 	}
 	if (m_currentRadius <= 0) m_currentRadius = 1;
-	UpdateLocation();
+	UpdateLocation(relink);
 }
 
 
@@ -365,7 +371,7 @@ void FDynamicLight::Tick()
 //
 //
 //==========================================================================
-void FDynamicLight::UpdateLocation()
+void FDynamicLight::UpdateLocation(TArray<FDynamicLight *> *relink)
 {
 	double oldx= X();
 	double oldy= Y();
@@ -406,8 +412,14 @@ void FDynamicLight::UpdateLocation()
 
 		if (X() != oldx || Y() != oldy || radius != oldradius)
 		{
-			//Update the light lists
-			LinkLight();
+			// The links cover LinkSlack beyond the radius, so a small move can keep them.
+			double slack = radius * LinkSlack;
+			if (radius != linkradius || (Pos.XY() - linkpos).LengthSquared() > slack * slack)
+			{
+				//Update the light lists
+				if (relink) relink->Push(this);
+				else LinkLight();
+			}
 		}
 	}
 }
@@ -525,20 +537,66 @@ double FDynamicLight::DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *
 // Collect all touched sidedefs and subsectors
 // to sidedefs and sector parts.
 //
+// This only reads the level so that it can run for several lights at once.
+// Instead of the validcount fields every thread keeps its own marks. Like
+// before, sections are compared against two different marks per light.
+//
 //==========================================================================
 struct LightLinkEntry
 {
 	FSection *sect;
 	DVector3 pos;
 };
-static TArray<LightLinkEntry> collected_ss;
 
-void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius)
+struct FLightLinkContext
+{
+	TArray<LightLinkEntry> collected_ss;
+	TArray<int> SectionMarks;
+	TArray<int> LineMarks;
+	int Mark = 0;
+
+	void Begin(FLevelLocals *Level)
+	{
+		if (Mark >= INT_MAX - 2)
+		{
+			memset(SectionMarks.Data(), 0, SectionMarks.Size() * sizeof(int));
+			memset(LineMarks.Data(), 0, LineMarks.Size() * sizeof(int));
+			Mark = 0;
+		}
+		Mark += 2;
+		// Older marks are always lower, so growing is all that's needed when switching levels.
+		unsigned numsections = Level->sections.allSections.Size();
+		unsigned numlines = Level->lines.Size();
+		if (SectionMarks.Size() < numsections) SectionMarks.AppendFill(0, numsections - SectionMarks.Size());
+		if (LineMarks.Size() < numlines) LineMarks.AppendFill(0, numlines - LineMarks.Size());
+	}
+};
+
+static thread_local FLightLinkContext LinkContext;
+
+void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section, float radius, FLightLinks &links)
 {
 	if (!section) return;
+
+	auto &ctx = LinkContext;
+	ctx.Begin(Level);
+	const int dl_mark = ctx.Mark;		// formerly dl_validcount
+	const int mark = ctx.Mark + 1;		// formerly validcount
+	auto &sectionmarks = ctx.SectionMarks;
+	auto &linemarks = ctx.LineMarks;
+	auto &collected_ss = ctx.collected_ss;
+
 	collected_ss.Clear();
 	collected_ss.Push({ section, opos });
-	section->validcount = dl_validcount;
+	sectionmarks[Level->sections.SectionIndex(section)] = dl_mark;
+
+	// Segs whose bounding box is farther away than this cannot be in range. This is a bit larger than needed so that it never rejects anything DistToSeg would accept.
+	const double boxdist = sqrt(double(radius)) + 1;
+	auto outOfRange = [&](const DVector3 &pos, const vertex_t *v1, const vertex_t *v2)
+	{
+		return (v1->fX() < pos.X - boxdist && v2->fX() < pos.X - boxdist) || (v1->fX() > pos.X + boxdist && v2->fX() > pos.X + boxdist) ||
+			(v1->fY() < pos.Y - boxdist && v2->fY() < pos.Y - boxdist) || (v1->fY() > pos.Y + boxdist && v2->fY() > pos.Y + boxdist);
+	};
 
 	bool hitonesidedback = false;
 	for (unsigned i = 0; i < collected_ss.Size(); i++)
@@ -546,19 +604,19 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 		auto pos = collected_ss[i].pos;
 		section = collected_ss[i].sect;
 
-		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
+		links.Sections.Push(section);
 
 
 		auto processSide = [&](side_t *sidedef, const vertex_t *v1, const vertex_t *v2)
 		{
 			auto linedef = sidedef->linedef;
-			if (linedef && linedef->validcount != ::validcount)
+			if (linedef && linemarks[linedef->Index()] != mark)
 			{
 				// light is in front of the seg
 				if ((pos.Y - v1->fY()) * (v2->fX() - v1->fX()) + (v1->fX() - pos.X) * (v2->fY() - v1->fY()) <= 0)
 				{
-					linedef->validcount = ::validcount;
-					touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+					linemarks[linedef->Index()] = mark;
+					links.Sides.Push(sidedef);
 				}
 				else if (linedef->sidedef[0] == sidedef && linedef->sidedef[1] == nullptr)
 				{
@@ -571,13 +629,14 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (port && port->mType == PORTT_LINKED)
 				{
 					line_t *other = port->mDestination;
-					if (other->validcount != ::validcount)
+					if (linemarks[other->Index()] != mark)
 					{
 						subsector_t *othersub = Level->PointInRenderSubsector(other->v1->fPos() + other->Delta() / 2);
 						FSection *othersect = othersub->section;
-						if (othersect->validcount != ::validcount)
+						int &othermark = sectionmarks[Level->sections.SectionIndex(othersect)];
+						if (othermark != mark)
 						{
-							othersect->validcount = ::validcount;
+							othermark = mark;
 							collected_ss.Push({ othersect, PosRelative(other->frontsector->PortalGroup) });
 						}
 					}
@@ -589,7 +648,7 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 		{
 			// check distance from x/y to seg and if within radius add this seg and, if present the opposing subsector (lather/rinse/repeat)
 			// If out of range we do not need to bother with this seg.
-			if (DistToSeg(pos, segment.start, segment.end) <= radius)
+			if (!outOfRange(pos, segment.start, segment.end) && DistToSeg(pos, segment.start, segment.end) <= radius)
 			{
 				auto sidedef = segment.sidedef;
 				if (sidedef)
@@ -601,9 +660,9 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				if (partner)
 				{
 					FSection *sect = partner->section;
-					if (sect != nullptr && sect->validcount != dl_validcount)
+					if (sect != nullptr && sectionmarks[Level->sections.SectionIndex(sect)] != dl_mark)
 					{
-						sect->validcount = dl_validcount;
+						sectionmarks[Level->sections.SectionIndex(sect)] = dl_mark;
 						collected_ss.Push({ sect, pos });
 					}
 				}
@@ -612,7 +671,7 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 		for (auto side : section->sides)
 		{
 			auto v1 = side->V1(), v2 = side->V2();
-			if (DistToSeg(pos, v1, v2) <= radius)
+			if (!outOfRange(pos, v1, v2) && DistToSeg(pos, v1, v2) <= radius)
 			{
 				processSide(side, v1, v2);
 			}
@@ -626,9 +685,10 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::ceiling);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				int &othermark = sectionmarks[Level->sections.SectionIndex(othersect)];
+				if (othermark != dl_mark)
 				{
-					othersect->validcount = dl_validcount;
+					othermark = dl_mark;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
@@ -641,24 +701,50 @@ void FDynamicLight::CollectWithinRadius(const DVector3 &opos, FSection *section,
 				DVector2 refpos = other->v1->fPos() + other->Delta() / 2 + sec->GetPortalDisplacement(sector_t::floor);
 				subsector_t *othersub = Level->PointInRenderSubsector(refpos);
 				FSection *othersect = othersub->section;
-				if (othersect->validcount != dl_validcount)
+				int &othermark = sectionmarks[Level->sections.SectionIndex(othersect)];
+				if (othermark != dl_mark)
 				{
-					othersect->validcount = dl_validcount;
+					othermark = dl_mark;
 					collected_ss.Push({ othersect, PosRelative(othersub->sector->PortalGroup) });
 				}
 			}
 		}
 	}
-	shadowmapped = hitonesidedback && !DontShadowmap();
+	links.Collected = true;
+	links.ShadowMapped = hitonesidedback && !DontShadowmap();
 }
 
 //==========================================================================
 //
-// Link the light into the world
+// Finds everything the light touches without changing anything
 //
 //==========================================================================
 
-void FDynamicLight::LinkLight()
+void FDynamicLight::CollectLinks(FLightLinks &links)
+{
+	links.Sections.Clear();
+	links.Sides.Clear();
+	links.Collected = false;
+
+	linkpos = Pos.XY();
+	linkradius = radius;
+
+	if (radius>0)
+	{
+		// passing in radius*radius allows us to do a distance check without any calls to sqrt
+		double linkdist = radius * (1 + LinkSlack);
+		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
+		CollectWithinRadius(Pos, sect, float(linkdist*linkdist), links);
+	}
+}
+
+//==========================================================================
+//
+// Replaces the light's node lists with the collected ones
+//
+//==========================================================================
+
+void FDynamicLight::ApplyLinks(const FLightLinks &links)
 {
 	// mark the old light nodes
 	FLightNode * node;
@@ -676,16 +762,15 @@ void FDynamicLight::LinkLight()
 		node = node->nextTarget;
 	}
 
-	if (radius>0)
+	for (auto section : links.Sections)
 	{
-		// passing in radius*radius allows us to do a distance check without any calls to sqrt
-		FSection *sect = Level->PointInRenderSubsector(Pos)->section;
-
-		dl_validcount++;
-		::validcount++;
-		CollectWithinRadius(Pos, sect, float(radius*radius));
-
+		touching_sector = AddLightNode(&section->lighthead, section, this, touching_sector);
 	}
+	for (auto sidedef : links.Sides)
+	{
+		touching_sides = AddLightNode(&sidedef->lighthead, sidedef, this, touching_sides);
+	}
+	if (links.Collected) shadowmapped = links.ShadowMapped;
 		
 	// Now delete any nodes that won't be used. These are the ones where
 	// m_thing is still nullptr.
@@ -713,6 +798,77 @@ void FDynamicLight::LinkLight()
 	}
 }
 
+//==========================================================================
+//
+// Link the light into the world
+//
+//==========================================================================
+
+void FDynamicLight::LinkLight()
+{
+	static FLightLinks links;
+
+	CollectLinks(links);
+	ApplyLinks(links);
+}
+
+//==========================================================================
+//
+// Ticks all lights of a level. The lights that have moved are collected
+// and get their new links computed on the worker threads. Only changing
+// the node lists is left for this thread.
+//
+//==========================================================================
+
+int P_TickDynamicLights(FLevelLocals *Level)
+{
+	static TArray<FDynamicLight *> relink;
+	static TArray<FLightLinks> links;
+	int count = 0;
+
+	relink.Clear();
+	for (auto light = Level->lights; light;)
+	{
+		auto next = light->next;
+		light->Tick(&relink);
+		light = next;
+		count++;
+	}
+
+	// Not worth it for only a few lights.
+	const unsigned LightsPerTask = 16;
+	if (relink.Size() < LightsPerTask * 2)
+	{
+		for (auto light : relink) light->LinkLight();
+		return count;
+	}
+
+	if (links.Size() < relink.Size()) links.Resize(relink.Size());
+
+	unsigned numtasks = min<unsigned>(relink.Size() / LightsPerTask, FTaskScheduler::Get().NumWorkers() + 1);
+	FTaskGroup group;
+	for (unsigned t = 0; t < numtasks; t++)
+	{
+		unsigned first = relink.Size() * t / numtasks;
+		unsigned last = relink.Size() * (t + 1) / numtasks;
+		group.Run([=]()
+		{
+			for (unsigned i = first; i < last; i++)
+			{
+				relink[i]->CollectLinks(links[i]);
+			}
+		});
+	}
+	group.Wait();
+
+	// Splice in the same order as before so that the node lists come out the same.
+	for (unsigned i = 0; i < relink.Size(); i++)
+	{
+		relink[i]->ApplyLinks(links[i]);
+	}
+	return count;
+}
+
 
 //==========================================================================
 //
@@ -724,6 +880,7 @@ void FDynamicLight::UnlinkLight ()
 	while (touching_sides) touching_sides = DeleteLightNode(touching_sides);
 	while (touching_sector) touching_sector = DeleteLightNode(touching_sector);
 	shadowmapped = false;
+	linkradius = -1;
 }
 
 //==========================================================================
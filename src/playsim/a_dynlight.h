@@ -195,6 +195,15 @@ struct FLightNode
 	};
 };
 
+// Everything a light touches, in the order the node lists get it.
+struct FLightLinks
+{
+	TArray<FSection *> Sections;
+	TArray<side_t *> Sides;
+	bool Collected;
+	bool ShadowMapped;
+};
+
 struct FDynamicLight
 {
 	friend class FLightDefaults;
@@ -243,15 +252,18 @@ struct FDynamicLight
 	double Y() const { return Pos.Y; }
 	double Z() const { return Pos.Z; }
 
-	void Tick();
-	void UpdateLocation();
+	// With relink the light is added there if it needs to be linked again, instead of linking it right away.
+	void Tick(TArray<FDynamicLight *> *relink = nullptr);
+	void UpdateLocation(TArray<FDynamicLight *> *relink = nullptr);
 	void LinkLight();
+	void CollectLinks(FLightLinks &links);
+	void ApplyLinks(const FLightLinks &links);
 	void UnlinkLight();
 	void ReleaseLight();
 
 private:
 	double DistToSeg(const DVector3 &pos, vertex_t *start, vertex_t *end);
-	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius);
+	void CollectWithinRadius(const DVector3 &pos, FSection *section, float radius, FLightLinks &links);
 
 public:
 	FCycler m_cycler;
@@ -275,6 +287,8 @@ public:
 	FLightNode * touching_sector;
 	float radius;			// The maximum size the light can be with its current settings.
 	float m_currentRadius;	// The current light size.
+	DVector2 linkpos;		// Where the light was last linked, and with which radius.
+	float linkradius;
 	int m_tickCount;
 	int m_lastUpdate;
 	int mShadowmapIndex;
@@ -288,4 +302,5 @@ public:
 
 };
 
-
+// Ticks all dynamic lights of the level. Returns the number of lights.
+int P_TickDynamicLights(FLevelLocals *Level);
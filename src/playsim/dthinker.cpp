@@ -38,6 +38,7 @@
 #include "serializer_doom.h"
 #include "d_player.h"
 #include "vm.h"
+#include "vmprofiler.h"
 #include "c_dispatch.h"
 #include "v_text.h"
 #include "g_levellocals.h"
@@ -160,12 +161,8 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		recreateLights();
 		if (dolights)
 		{
-			for (auto light = Level->lights; light;)
-			{
-				auto next = light->next;
-				light->Tick();
-				light = next;
-			}
+			FVMProfileScope scope("InternalDynamicLight", VMPF_Label);
+			P_TickDynamicLights(Level);
 		}
 	}
 	else
@@ -192,14 +189,9 @@ void FThinkerCollection::RunThinkers(FLevelLocals *Level)
 		{
 			// Also profile the internal dynamic lights, even though they are not implemented as thinkers.
 			auto &prof = Profiles[NAME_InternalDynamicLight];
+			FVMProfileScope scope("InternalDynamicLight", VMPF_Label);
 			prof.timer.Clock();
-			for (auto light = Level->lights; light;)
-			{
-				prof.numcalls++;
-				auto next = light->next;
-				light->Tick();
-				light = next;
-			}
+			prof.numcalls += P_TickDynamicLights(Level);
 			prof.timer.Unclock();
 		}
 
@@ -615,6 +607,7 @@ int FThinkerList::TickThinkers(FThinkerList *dest)
 		if (!(node->ObjectFlags & OF_EuthanizeMe))
 		{ // Only tick thinkers not scheduled for destruction
 			ThinkCount++;
+			FVMProfileScope scope(node->GetClass(), VMPF_Thinker);
 			node->CallTick();
 			node->ObjectFlags &= ~OF_JustSpawned;
 		}
@@ -663,6 +656,7 @@ int FThinkerList::ProfileThinkers(FThinkerList *dest)
 
 			auto &prof = Profiles[node->GetClass()->TypeName];
 			prof.numcalls++;
+			FVMProfileScope scope(node->GetClass(), VMPF_Thinker);
 			prof.timer.Clock();
 			node->CallTick();
 			prof.timer.Unclock();
@@ -106,63 +106,40 @@ static const struct ColorList {
 
 inline particle_t *NewParticle (FLevelLocals *Level, bool replace = false)
 {
-	particle_t *result = nullptr;
-	// [MC] Thanks to RaveYard and randi for helping me with this addition.
-	// Array's filled up
-	if (Level->InactiveParticles == NO_PARTICLE)
-	{
-		if (replace)
-		{
-			result = &Level->Particles[Level->OldestParticle];
+	uint32_t index;
 
-			// There should be NO_PARTICLE for the oldest's tnext
-			if (result->tprev != NO_PARTICLE)
-			{
-				// tnext: youngest to oldest
-				// tprev: oldest to youngest
-				
-				// 2nd oldest -> oldest
-				particle_t *nbottom = &Level->Particles[result->tprev];
-				nbottom->tnext = NO_PARTICLE;
-
-				// now oldest becomes youngest
-				Level->OldestParticle = result->tprev;
-				result->tnext = Level->ActiveParticles;
-				result->tprev = NO_PARTICLE;
-				Level->ActiveParticles = uint32_t(result - Level->Particles.Data());
-
-				// youngest -> 2nd youngest
-				particle_t* ntop = &Level->Particles[result->tnext];
-				ntop->tprev = Level->ActiveParticles;
-			}
-			// [MC] Future proof this by resetting everything when replacing a particle.
-			auto tnext = result->tnext;
-			auto tprev = result->tprev;
-			*result = {};
-			result->tnext = tnext;
-			result->tprev = tprev;
-		}
-		return result;
+	if (Level->FreeParticles.Size() > 0)
+	{
+		Level->FreeParticles.Pop(index);
 	}
-	
-	// Array isn't full.
-	uint32_t current = Level->ActiveParticles;
-	result = &Level->Particles[Level->InactiveParticles];
-	Level->InactiveParticles = result->tnext;
-	result->tnext = current;
-	result->tprev = NO_PARTICLE;
-	Level->ActiveParticles = uint32_t(result - Level->Particles.Data());
-
-	if (current != NO_PARTICLE) // More than one active particles
+	else if (replace)
 	{
-		particle_t* next = &Level->Particles[current];
-		next->tprev = Level->ActiveParticles;
+		// [MC] Thanks to RaveYard and randi for helping me with this addition.
+		// Array's filled up, so take the oldest particle. Particles that have not been thought yet are the youngest.
+		auto &motion = Level->ParticleMotion;
+		if (Level->OldestParticle < motion.Count())
+		{
+			index = motion.Slot[Level->OldestParticle];
+			motion.Slot[Level->OldestParticle++] = NO_PARTICLE;
+		}
+		else if (Level->OldestNewParticle < Level->NewParticles.Size())
+		{
+			index = Level->NewParticles[Level->OldestNewParticle++];
+		}
+		else
+		{
+			return nullptr;
+		}
+		// [MC] Future proof this by resetting everything when replacing a particle.
+		Level->Particles[index] = {};
 	}
-	else // Just one active particle
+	else
 	{
-		Level->OldestParticle = Level->ActiveParticles;
+		return nullptr;
 	}
-	return result;
+
+	Level->NewParticles.Push(index);
+	return &Level->Particles[index];
 }
 
 //
@@ -182,7 +159,7 @@ void P_InitParticles (FLevelLocals *Level)
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Level->Particles.Resize(NumParticles);
 	P_ClearParticles (Level);
@@ -190,18 +167,20 @@ void P_InitParticles (FLevelLocals *Level)
 
 void P_ClearParticles (FLevelLocals *Level)
 {
-	int i = 0;
-	Level->OldestParticle = NO_PARTICLE;
-	Level->ActiveParticles = NO_PARTICLE;
-	Level->InactiveParticles = 0;
-	for (auto &p : Level->Particles)
+	unsigned count = Level->Particles.Size();
+
+	Level->ParticleMotion.Resize(0);
+	Level->NewParticles.Clear();
+	Level->OldestParticle = 0;
+	Level->OldestNewParticle = 0;
+
+	// Hand out the lowest indices first.
+	Level->FreeParticles.Resize(count);
+	for (unsigned i = 0; i < count; i++)
 	{
-		p = {};
-		p.tprev = i - 1;
-		p.tnext = ++i;
+		Level->Particles[i] = {};
+		Level->FreeParticles[i] = count - 1 - i;
 	}
-	Level->Particles.Last().tnext = NO_PARTICLE;
-	Level->Particles.Data()->tprev = NO_PARTICLE;
 }
 
 // Group particles by subsectors. Because particles are always
@@ -209,6 +188,15 @@ void P_ClearParticles (FLevelLocals *Level)
 // from one frame to the next.
 // [MC] VisualThinkers hitches a ride here
 
+static void LinkParticleToSubsector(FLevelLocals *Level, uint32_t i)
+{
+	 // Try to reuse the subsector from the last portal check, if still valid.
+	if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
+	int ssnum = Level->Particles[i].subsector->Index();
+	Level->Particles[i].snext = Level->ParticlesInSubsec[ssnum];
+	Level->ParticlesInSubsec[ssnum] = i;
+}
+
 void P_FindParticleSubsectors (FLevelLocals *Level)
 {
 	// [MC] Hitch a ride on particle subsectors since VisualThinkers are effectively using the same kind of system.
@@ -233,19 +221,24 @@ void P_FindParticleSubsectors (FLevelLocals *Level)
 		Level->ParticlesInSubsec.Reserve (Level->subsectors.Size() - Level->ParticlesInSubsec.Size());
 	}
 
-	fillshort (&Level->ParticlesInSubsec[0], Level->subsectors.Size(), NO_PARTICLE);
+	for (unsigned i = 0; i < Level->subsectors.Size(); i++)
+	{
+		Level->ParticlesInSubsec[i] = NO_PARTICLE;
+	}
 
 	if (!r_particles)
 	{
 		return;
 	}
-	for (uint16_t i = Level->ActiveParticles; i != NO_PARTICLE; i = Level->Particles[i].tnext)
+	// Youngest to oldest, so each subsector's list starts with its oldest particle, as it always did.
+	auto &motion = Level->ParticleMotion;
+	for (unsigned i = Level->NewParticles.Size(); i-- > Level->OldestNewParticle; )
 	{
-		 // Try to reuse the subsector from the last portal check, if still valid.
-		if (Level->Particles[i].subsector == nullptr) Level->Particles[i].subsector = Level->PointInRenderSubsector(Level->Particles[i].Pos);
-		int ssnum = Level->Particles[i].subsector->Index();
-		Level->Particles[i].snext = Level->ParticlesInSubsec[ssnum];
-		Level->ParticlesInSubsec[ssnum] = i;
+		LinkParticleToSubsector(Level, Level->NewParticles[i]);
+	}
+	for (unsigned i = motion.Count(); i-- > Level->OldestParticle; )
+	{
+		if (motion.Slot[i] != NO_PARTICLE) LinkParticleToSubsector(Level, motion.Slot[i]);
 	}
 }
 
@@ -286,54 +279,266 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
-void P_ThinkParticles (FLevelLocals *Level)
+//==========================================================================
+//
+// FParticleMotion
+//
+//==========================================================================
+
+void FParticleMotion::Resize(unsigned count)
+{
+	Slot.Resize(count);
+	PosX.Resize(count);
+	PosY.Resize(count);
+	PosZ.Resize(count);
+	VelX.Resize(count);
+	VelY.Resize(count);
+	VelZ.Resize(count);
+	AccX.Resize(count);
+	AccY.Resize(count);
+	AccZ.Resize(count);
+	Size.Resize(count);
+	SizeStep.Resize(count);
+	Roll.Resize(count);
+	RollVel.Resize(count);
+	RollAcc.Resize(count);
+	Alpha.Resize(count);
+	FadeStep.Resize(count);
+	TTL.Resize(count);
+	Expired.Resize(count);
+}
+
+void FParticleMotion::Load(unsigned index, uint32_t slot, const particle_t &p)
+{
+	Slot[index] = slot;
+	PosX[index] = p.Pos.X;
+	PosY[index] = p.Pos.Y;
+	PosZ[index] = p.Pos.Z;
+	VelX[index] = p.Vel.X;
+	VelY[index] = p.Vel.Y;
+	VelZ[index] = p.Vel.Z;
+	AccX[index] = p.Acc.X;
+	AccY[index] = p.Acc.Y;
+	AccZ[index] = p.Acc.Z;
+	Size[index] = p.size;
+	SizeStep[index] = p.sizestep;
+	Alpha[index] = p.alpha;
+	FadeStep[index] = p.fadestep;
+	TTL[index] = p.ttl;
+
+	// Rolling can be applied to all particles then.
+	bool roll = !!(p.flags & SPF_ROLL);
+	Roll[index] = p.Roll;
+	RollVel[index] = roll ? p.RollVel : 0;
+	RollAcc[index] = roll ? p.RollAcc : 0;
+}
+
+void FParticleMotion::Store(unsigned index, particle_t &p) const
 {
-	int i = Level->ActiveParticles;
-	particle_t *particle = nullptr, *prev = nullptr;
-	while (i != NO_PARTICLE)
+	p.Pos = { PosX[index], PosY[index], PosZ[index] };
+	p.Vel = { VelX[index], VelY[index], VelZ[index] };
+	p.size = Size[index];
+	p.alpha = Alpha[index];
+	p.ttl = TTL[index];
+
+	// The others had their roll velocity zeroed only for the motion arrays.
+	if (p.flags & SPF_ROLL)
 	{
-		particle = &Level->Particles[i];
-		i = particle->tnext;
-		if (Level->isFrozen() && !(particle->flags &SPF_NOTIMEFREEZE))
+		p.Roll = Roll[index];
+		p.RollVel = RollVel[index];
+	}
+}
+
+void FParticleMotion::Move(unsigned from, unsigned to)
+{
+	Slot[to] = Slot[from];
+	PosX[to] = PosX[from];
+	PosY[to] = PosY[from];
+	PosZ[to] = PosZ[from];
+	VelX[to] = VelX[from];
+	VelY[to] = VelY[from];
+	VelZ[to] = VelZ[from];
+	AccX[to] = AccX[from];
+	AccY[to] = AccY[from];
+	AccZ[to] = AccZ[from];
+	Size[to] = Size[from];
+	SizeStep[to] = SizeStep[from];
+	Roll[to] = Roll[from];
+	RollVel[to] = RollVel[from];
+	RollAcc[to] = RollAcc[from];
+	Alpha[to] = Alpha[from];
+	FadeStep[to] = FadeStep[from];
+	TTL[to] = TTL[from];
+	Expired[to] = Expired[from];
+}
+
+//==========================================================================
+//
+// MoveParticles
+//
+// Fades, grows and moves the particles in the given range and flags
+// the ones that have expired. The horizontal movement is left out if it
+// needs to check for line portals.
+//
+//==========================================================================
+
+static void MoveParticlesScalar(FParticleMotion &m, unsigned first, unsigned last, bool movexy)
+{
+	for (unsigned i = first; i < last; i++)
+	{
+		float oldtrans = m.Alpha[i];
+		m.Alpha[i] -= m.FadeStep[i];
+		m.Size[i] += m.SizeStep[i];
+		m.Expired[i] = m.Alpha[i] <= 0 || oldtrans < m.Alpha[i] || --m.TTL[i] <= 0 || m.Size[i] <= 0;
+
+		if (movexy)
 		{
-			prev = particle;
-			continue;
+			m.PosX[i] += m.VelX[i];
+			m.PosY[i] += m.VelY[i];
+			m.VelX[i] += m.AccX[i];
+			m.VelY[i] += m.AccY[i];
+		}
+		m.PosZ[i] += m.VelZ[i];
+		m.VelZ[i] += m.AccZ[i];
+		m.Roll[i] += m.RollVel[i];
+		m.RollVel[i] += m.RollAcc[i];
+	}
+}
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__i386__) || defined(__amd64__)
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+
+static inline void AddVelocity_SSE2(double *pos, double *vel, const double *acc)
+{
+	__m128d v = _mm_loadu_pd(vel);
+	_mm_storeu_pd(pos, _mm_add_pd(_mm_loadu_pd(pos), v));
+	_mm_storeu_pd(vel, _mm_add_pd(v, _mm_loadu_pd(acc)));
+}
+
+static void MoveParticles(FParticleMotion &m, unsigned first, unsigned last, bool movexy)
+{
+	const __m128 fzero = _mm_setzero_ps();
+	const __m128d dzero = _mm_setzero_pd();
+	const __m128i ione = _mm_set1_epi32(1);
+	unsigned i;
+
+	for (i = first; i + 4 <= last; i += 4)
+	{
+		__m128 oldtrans = _mm_loadu_ps(&m.Alpha[i]);
+		__m128 alpha = _mm_sub_ps(oldtrans, _mm_loadu_ps(&m.FadeStep[i]));
+		_mm_storeu_ps(&m.Alpha[i], alpha);
+		int expired = _mm_movemask_ps(_mm_or_ps(_mm_cmple_ps(alpha, fzero), _mm_cmplt_ps(oldtrans, alpha)));
+
+		// The ttl of particles that have faded out is not counted down but these are gone anyway.
+		__m128i ttl = _mm_sub_epi32(_mm_loadu_si128((__m128i*)&m.TTL[i]), ione);
+		_mm_storeu_si128((__m128i*)&m.TTL[i], ttl);
+		expired |= _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(ttl, ione)));
+
+		__m128d size0 = _mm_add_pd(_mm_loadu_pd(&m.Size[i]), _mm_loadu_pd(&m.SizeStep[i]));
+		__m128d size1 = _mm_add_pd(_mm_loadu_pd(&m.Size[i + 2]), _mm_loadu_pd(&m.SizeStep[i + 2]));
+		_mm_storeu_pd(&m.Size[i], size0);
+		_mm_storeu_pd(&m.Size[i + 2], size1);
+		expired |= _mm_movemask_pd(_mm_cmple_pd(size0, dzero)) | (_mm_movemask_pd(_mm_cmple_pd(size1, dzero)) << 2);
+
+		for (int j = 0; j < 4; j++)
+		{
+			m.Expired[i + j] = (expired >> j) & 1;
 		}
-		
-		auto oldtrans = particle->alpha;
-		particle->alpha -= particle->fadestep;
-		particle->size += particle->sizestep;
-		if (particle->alpha <= 0 || oldtrans < particle->alpha || --particle->ttl <= 0 || (particle->size <= 0))
-		{ // The particle has expired, so free it
-			*particle = {};
-			if (prev)
-				prev->tnext = i;
-			else
-				Level->ActiveParticles = i;
 
-			if (i != NO_PARTICLE)
+		for (int j = 0; j < 4; j += 2)
+		{
+			if (movexy)
 			{
-				particle_t *next = &Level->Particles[i];
-				next->tprev = particle->tprev;
+				AddVelocity_SSE2(&m.PosX[i + j], &m.VelX[i + j], &m.AccX[i + j]);
+				AddVelocity_SSE2(&m.PosY[i + j], &m.VelY[i + j], &m.AccY[i + j]);
 			}
-			particle->tnext = Level->InactiveParticles;
-			Level->InactiveParticles = (int)(particle - Level->Particles.Data());
-			continue;
+			AddVelocity_SSE2(&m.PosZ[i + j], &m.VelZ[i + j], &m.AccZ[i + j]);
+			AddVelocity_SSE2(&m.Roll[i + j], &m.RollVel[i + j], &m.RollAcc[i + j]);
 		}
+	}
+	MoveParticlesScalar(m, i, last, movexy);
+}
 
-		// Handle crossing a line portal
-		DVector2 newxy = Level->GetPortalOffsetPosition(particle->Pos.X, particle->Pos.Y, particle->Vel.X, particle->Vel.Y);
-		particle->Pos.X = newxy.X;
-		particle->Pos.Y = newxy.Y;
-		particle->Pos.Z += particle->Vel.Z;
-		particle->Vel += particle->Acc;
+#else
+
+static void MoveParticles(FParticleMotion &m, unsigned first, unsigned last, bool movexy)
+{
+	MoveParticlesScalar(m, first, last, movexy);
+}
 
-		if(particle->flags & SPF_ROLL)
+#endif
+
+//==========================================================================
+//
+// P_ThinkParticles
+//
+//==========================================================================
+
+void P_ThinkParticles (FLevelLocals *Level)
+{
+	auto &motion = Level->ParticleMotion;
+
+	// Take in the particles spawned since the last tic, after the older ones.
+	unsigned count = motion.Count();
+	motion.Resize(count + Level->NewParticles.Size() - Level->OldestNewParticle);
+	for (unsigned i = Level->OldestNewParticle; i < Level->NewParticles.Size(); i++)
+	{
+		uint32_t slot = Level->NewParticles[i];
+		motion.Load(count++, slot, Level->Particles[slot]);
+	}
+	Level->NewParticles.Clear();
+	Level->OldestNewParticle = 0;
+
+	// Crossing line portals has to be checked one particle at a time.
+	bool movexy = !Level->PortalBlockmap.containsLines;
+	bool frozen = Level->isFrozen();
+
+	if (!frozen)
+	{
+		MoveParticles(motion, 0, count, movexy);
+	}
+
+	unsigned live = 0;
+	for (unsigned i = 0; i < count; i++)
+	{
+		uint32_t slot = motion.Slot[i];
+		if (slot == NO_PARTICLE) continue;	// was replaced by a new one.
+
+		particle_t *particle = &Level->Particles[slot];
+		if (live != i) motion.Move(i, live);
+
+		if (frozen)
+		{
+			if (!(particle->flags & SPF_NOTIMEFREEZE))
+			{
+				live++;
+				continue;
+			}
+			MoveParticles(motion, live, live + 1, movexy);
+		}
+
+		if (motion.Expired[live])
+		{ // The particle has expired, so free it
+			*particle = {};
+			Level->FreeParticles.Push(slot);
+			continue;
+		}
+
+		if (!movexy)
 		{
-			particle->Roll += particle->RollVel;
-			particle->RollVel += particle->RollAcc;
+			// Handle crossing a line portal
+			DVector2 newxy = Level->GetPortalOffsetPosition(motion.PosX[live], motion.PosY[live], motion.VelX[live], motion.VelY[live]);
+			motion.PosX[live] = newxy.X;
+			motion.PosY[live] = newxy.Y;
+			motion.VelX[live] += motion.AccX[live];
+			motion.VelY[live] += motion.AccY[live];
 		}
-		
+		motion.Store(live, *particle);
+
 		particle->subsector = Level->PointInRenderSubsector(particle->Pos);
 		sector_t *s = particle->subsector->sector;
 		// Handle crossing a sector portal.
@@ -353,8 +558,15 @@ void P_ThinkParticles (FLevelLocals *Level)
 				particle->subsector = NULL;
 			}
 		}
-		prev = particle;
+		if (particle->subsector == NULL)
+		{
+			motion.PosX[live] = particle->Pos.X;
+			motion.PosY[live] = particle->Pos.Y;
+		}
+		live++;
 	}
+	motion.Resize(live);
+	Level->OldestParticle = 0;
 }
 
 void P_SpawnParticle(FLevelLocals *Level, const DVector3 &pos, const DVector3 &vel, const DVector3 &accel, PalEntry color, double startalpha, int lifetime, double size,
@@ -78,13 +78,37 @@ struct particle_t
     FTextureID texture;
     ERenderStyle style;
     double Roll, RollVel, RollAcc;
-    uint16_t    tnext, snext, tprev;
+    uint32_t    snext;
     bool    bright;
 	uint16_t flags;
 	DVisualThinker *sprite;
 };
 
-const uint16_t NO_PARTICLE = 0xffff;
+const uint32_t NO_PARTICLE = 0xffffffff;
+const int MAX_PARTICLES = 1 << 20;
+
+// The moving parts of the active particles, in spawn order. P_ThinkParticles
+// updates these several particles at a time and copies the results back to
+// the particle_t, which is what gets rendered. Newly spawned particles are only
+// added here on the next tic, until then the particle_t is all there is.
+struct FParticleMotion
+{
+	TArray<uint32_t> Slot;	// index into Level->Particles, NO_PARTICLE if the particle has been replaced
+	TArray<double> PosX, PosY, PosZ;
+	TArray<double> VelX, VelY, VelZ;
+	TArray<double> AccX, AccY, AccZ;
+	TArray<double> Size, SizeStep;
+	TArray<double> Roll, RollVel, RollAcc;
+	TArray<float> Alpha, FadeStep;
+	TArray<int32_t> TTL;
+	TArray<uint8_t> Expired;
+
+	unsigned Count() const { return Slot.Size(); }
+	void Resize(unsigned count);
+	void Load(unsigned index, uint32_t slot, const particle_t &p);
+	void Store(unsigned index, particle_t &p) const;
+	void Move(unsigned from, unsigned to);
+};
 
 void P_InitParticles(FLevelLocals *);
 void P_ClearParticles (FLevelLocals *Level);
@@ -1165,6 +1165,205 @@ void FMultiBlockThingsIterator::Reset()
 TArray<intercept_t> FPathTraverse::intercepts(128);
 
 
+//===========================================================================
+//
+// BuildBlockLineCache
+//
+// Copies the line lists of all blocks into one structure-of-arrays so that
+// the traverser can test several lines at once. Polyobject lines move and
+// lines whose precalculated delta does not exactly match their vertices
+// would not produce the same results, so these are marked to be checked
+// the regular way.
+//
+//===========================================================================
+
+static void BuildBlockLineCache(FLevelLocals *Level)
+{
+	auto &blockmap = Level->blockmap;
+	auto &cache = blockmap.linecache;
+	int numblocks = blockmap.bmapwidth * blockmap.bmapheight;
+
+	cache.Start.Resize(numblocks + 1);
+	for (int y = 0; y < blockmap.bmapheight; y++)
+	{
+		for (int x = 0; x < blockmap.bmapwidth; x++)
+		{
+			cache.Start[y * blockmap.bmapwidth + x] = cache.Line.Size();
+			for (int *list = blockmap.GetLines(x, y); *list != -1; list++)
+			{
+				line_t *ld = &Level->lines[*list];
+				bool fixed = !(ld->sidedef[0] != nullptr && (ld->sidedef[0]->Flags & WALLF_POLYOBJ)) &&
+					ld->Delta().X == ld->v2->fX() - ld->v1->fX() && ld->Delta().Y == ld->v2->fY() - ld->v1->fY();
+
+				cache.Line.Push(fixed ? *list : ~*list);
+				cache.X1.Push(ld->v1->fX());
+				cache.Y1.Push(ld->v1->fY());
+				cache.X2.Push(ld->v2->fX());
+				cache.Y2.Push(ld->v2->fY());
+			}
+		}
+	}
+	cache.Start[numblocks] = cache.Line.Size();
+
+	// Padding so that the last block can be read in full groups of 4.
+	for (int i = 0; i < 4; i++)
+	{
+		cache.X1.Push(0);
+		cache.Y1.Push(0);
+		cache.X2.Push(0);
+		cache.Y2.Push(0);
+	}
+}
+
+//===========================================================================
+//
+// InterceptLines4
+//
+// Tests 4 cached lines against the trace. Returns a bit mask of the lines
+// whose vertices are on opposite sides of the trace and their intercepts.
+//
+// This has to produce exactly the same results as P_PointOnDivlineSide and
+// P_InterceptVector, so all operations are done in the same order and with
+// the same precision. Fused multiply-add must not be used here.
+//
+//===========================================================================
+
+// 32 bit x86 is left out because its scalar code may not run on SSE.
+#if defined(_M_X64) || defined(__amd64__)
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+
+static inline int InterceptLines4(const FBlockmap::FLineCache &cache, int first, const divline_t &trace, double *frac)
+{
+	const __m128d tx = _mm_set1_pd(trace.x);
+	const __m128d ty = _mm_set1_pd(trace.y);
+	const __m128d tdx = _mm_set1_pd(trace.dx);
+	const __m128d tdy = _mm_set1_pd(trace.dy);
+	const __m128d epsilon = _mm_set1_pd(EQUAL_EPSILON);
+	const __m128d zero = _mm_setzero_pd();
+	int mask = 0;
+
+	for (int i = 0; i < 4; i += 2)
+	{
+		__m128d x1 = _mm_loadu_pd(&cache.X1[first + i]);
+		__m128d y1 = _mm_loadu_pd(&cache.Y1[first + i]);
+		__m128d x2 = _mm_loadu_pd(&cache.X2[first + i]);
+		__m128d y2 = _mm_loadu_pd(&cache.Y2[first + i]);
+		__m128d dx = _mm_sub_pd(x2, x1);
+		__m128d dy = _mm_sub_pd(y2, y1);
+
+		__m128d s1 = _mm_cmpgt_pd(_mm_add_pd(_mm_mul_pd(_mm_sub_pd(y1, ty), tdx), _mm_mul_pd(_mm_sub_pd(tx, x1), tdy)), epsilon);
+		__m128d s2 = _mm_cmpgt_pd(_mm_add_pd(_mm_mul_pd(_mm_sub_pd(y2, ty), tdx), _mm_mul_pd(_mm_sub_pd(tx, x2), tdy)), epsilon);
+		mask |= _mm_movemask_pd(_mm_xor_pd(s1, s2)) << i;
+
+		__m128d den = _mm_sub_pd(_mm_mul_pd(dy, tdx), _mm_mul_pd(dx, tdy));
+		__m128d num = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(x1, tx), dy), _mm_mul_pd(_mm_sub_pd(ty, y1), dx));
+		__m128d f = _mm_andnot_pd(_mm_cmpeq_pd(den, zero), _mm_div_pd(num, den));	// parallel lines return 0
+		_mm_storeu_pd(&frac[i], f);
+	}
+	return mask;
+}
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+static inline int InterceptLines4(const FBlockmap::FLineCache &cache, int first, const divline_t &trace, double *frac)
+{
+	const float64x2_t tx = vdupq_n_f64(trace.x);
+	const float64x2_t ty = vdupq_n_f64(trace.y);
+	const float64x2_t tdx = vdupq_n_f64(trace.dx);
+	const float64x2_t tdy = vdupq_n_f64(trace.dy);
+	const float64x2_t epsilon = vdupq_n_f64(EQUAL_EPSILON);
+	const float64x2_t zero = vdupq_n_f64(0);
+	int mask = 0;
+
+	for (int i = 0; i < 4; i += 2)
+	{
+		float64x2_t x1 = vld1q_f64(&cache.X1[first + i]);
+		float64x2_t y1 = vld1q_f64(&cache.Y1[first + i]);
+		float64x2_t x2 = vld1q_f64(&cache.X2[first + i]);
+		float64x2_t y2 = vld1q_f64(&cache.Y2[first + i]);
+		float64x2_t dx = vsubq_f64(x2, x1);
+		float64x2_t dy = vsubq_f64(y2, y1);
+
+		uint64x2_t s1 = vcgtq_f64(vaddq_f64(vmulq_f64(vsubq_f64(y1, ty), tdx), vmulq_f64(vsubq_f64(tx, x1), tdy)), epsilon);
+		uint64x2_t s2 = vcgtq_f64(vaddq_f64(vmulq_f64(vsubq_f64(y2, ty), tdx), vmulq_f64(vsubq_f64(tx, x2), tdy)), epsilon);
+		uint64x2_t crossed = veorq_u64(s1, s2);
+		mask |= int(vgetq_lane_u64(crossed, 0) & 1) << i;
+		mask |= int(vgetq_lane_u64(crossed, 1) & 1) << (i + 1);
+
+		float64x2_t den = vsubq_f64(vmulq_f64(dy, tdx), vmulq_f64(dx, tdy));
+		float64x2_t num = vaddq_f64(vmulq_f64(vsubq_f64(x1, tx), dy), vmulq_f64(vsubq_f64(ty, y1), dx));
+		uint64x2_t parallel = vceqq_f64(den, zero);
+		float64x2_t f = vreinterpretq_f64_u64(vbicq_u64(vreinterpretq_u64_f64(vdivq_f64(num, den)), parallel));	// parallel lines return 0
+		vst1q_f64(&frac[i], f);
+	}
+	return mask;
+}
+
+#else
+
+static inline int InterceptLines4(const FBlockmap::FLineCache &cache, int first, const divline_t &trace, double *frac)
+{
+	int mask = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		divline_t dl = { cache.X1[first + i], cache.Y1[first + i], cache.X2[first + i] - cache.X1[first + i], cache.Y2[first + i] - cache.Y1[first + i] };
+		int s1 = P_PointOnDivlineSide(dl.x, dl.y, &trace);
+		int s2 = P_PointOnDivlineSide(cache.X2[first + i], cache.Y2[first + i], &trace);
+		mask |= (s1 != s2) << i;
+		frac[i] = P_InterceptVector(&trace, &dl);
+	}
+	return mask;
+}
+
+#endif
+
+//===========================================================================
+//
+// FPathTraverse :: AddLineIntercept
+//
+// A line is crossed if its endpoints
+// are on opposite sides of the trace.
+//
+//===========================================================================
+
+void FPathTraverse::AddLineIntercept(line_t *ld)
+{
+	int 				s1;
+	int 				s2;
+	double 				frac;
+	divline_t			dl;
+
+	s1 = P_PointOnDivlineSide (ld->v1->fX(), ld->v1->fY(), &trace);
+	s2 = P_PointOnDivlineSide (ld->v2->fX(), ld->v2->fY(), &trace);
+	
+	if (s1 == s2) return;	// line isn't crossed
+	
+	// hit the line
+	P_MakeDivline (ld, &dl);
+	frac = P_InterceptVector (&trace, &dl);
+
+	AddLineIntercept(ld, frac);
+}
+
+void FPathTraverse::AddLineIntercept(line_t *ld, double frac)
+{
+	if (frac < Startfrac || frac > 1.) return;	// behind source or beyond end point
+		
+	intercept_t newintercept;
+
+	newintercept.frac = frac;
+	newintercept.isaline = true;
+	newintercept.done = false;
+	newintercept.d.line = ld;
+	intercepts.Push (newintercept);
+}
+
 //===========================================================================
 //
 // FPathTraverse :: AddLineIntercepts.
@@ -1172,41 +1371,52 @@ TArray<intercept_t> FPathTraverse::intercepts(128);
 // that intercept the given trace
 // to add to the intercepts list.
 //
-// A line is crossed if its endpoints
-// are on opposite sides of the trace.
+// This visits the lines in the same order as FBlockLinesIterator
+// so that the intercepts come out in the same order, too.
 //
 //===========================================================================
 
 void FPathTraverse::AddLineIntercepts(int bx, int by)
 {
-	FBlockLinesIterator it(Level, bx, by, bx, by, true);
-	line_t *ld;
+	auto &blockmap = Level->blockmap;
+	if (!blockmap.isValidBlock(bx, by)) return;
 
-	while ((ld = it.Next()))
+	unsigned offset = by * blockmap.bmapwidth + bx;
+	for (polyblock_t *link = Level->PolyBlockMap.Size() > offset ? Level->PolyBlockMap[offset] : nullptr; link != nullptr; link = link->next)
 	{
-		int 				s1;
-		int 				s2;
-		double 				frac;
-		divline_t			dl;
+		FPolyObj *po = link->polyobj;
+		if (po == nullptr || po->validcount == validcount) continue;
+		po->validcount = validcount;
 
-		s1 = P_PointOnDivlineSide (ld->v1->fX(), ld->v1->fY(), &trace);
-		s2 = P_PointOnDivlineSide (ld->v2->fX(), ld->v2->fY(), &trace);
-		
-		if (s1 == s2) continue;	// line isn't crossed
-		
-		// hit the line
-		P_MakeDivline (ld, &dl);
-		frac = P_InterceptVector (&trace, &dl);
+		for (line_t *ld : po->Linedefs)
+		{
+			if (ld->validcount == validcount) continue;
+			ld->validcount = validcount;
+			AddLineIntercept(ld);
+		}
+	}
 
-		if (frac < Startfrac || frac > 1.) continue;	// behind source or beyond end point
-			
-		intercept_t newintercept;
+	auto &cache = blockmap.linecache;
+	if (cache.Start.Size() == 0) BuildBlockLineCache(Level);
 
-		newintercept.frac = frac;
-		newintercept.isaline = true;
-		newintercept.done = false;
-		newintercept.d.line = ld;
-		intercepts.Push (newintercept);
+	int first = cache.Start[offset];
+	int last = cache.Start[offset + 1];
+	for (; first < last; first += 4)
+	{
+		double frac[4];
+		int crossed = InterceptLines4(cache, first, trace, frac);
+		int num = std::min(last - first, 4);
+
+		for (int i = 0; i < num; i++)
+		{
+			int linenum = cache.Line[first + i];
+			line_t *ld = &Level->lines[linenum < 0 ? ~linenum : linenum];
+			if (ld->validcount == validcount) continue;
+			ld->validcount = validcount;
+
+			if (linenum < 0) AddLineIntercept(ld);
+			else if (crossed & (1 << i)) AddLineIntercept(ld, frac[i]);
+		}
 	}
 }
 
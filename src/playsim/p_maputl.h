@@ -376,6 +376,8 @@ protected:
 	unsigned int intercept_count;
 	unsigned int count;
 
+	void AddLineIntercept(line_t *ld);
+	void AddLineIntercept(line_t *ld, double frac);
 	virtual void AddLineIntercepts(int bx, int by);
 	virtual void AddThingIntercepts(int bx, int by, FBlockThingsIterator &it, bool compatible);
 	FPathTraverse(FLevelLocals *l) 
@@ -32,7 +32,7 @@
 #include "p_effect.h"
 #include "po_man.h"
 #include "m_fixed.h"
-#include "ctpl.h"
+#include "tasks.h"
 #include "texturemanager.h"
 #include "hwrenderer/scene/hw_fakeflat.h"
 #include "hwrenderer/scene/hw_clipper.h"
@@ -61,7 +61,7 @@ static std::vector< bool > rt_segdrawn = {};
 #endif
 
 thread_local bool isWorkerThread;
-ctpl::thread_pool renderPool(1);
+thread_local bool isFlatWorkerThread;
 bool inited = false;
 
 struct RenderJob
@@ -109,15 +109,27 @@ public:
 	}
 };
 
-static RenderJobQueue jobQueue;	// One static queue is sufficient here. This code will never be called recursively.
+// The BSP traversal feeds two workers. Flats do not depend on anything the other jobs modify,
+// so they get their own worker and draw lists. Walls, sprites and portals share the portal
+// state and the actors moved by ProcessActorsInPortal, so they must stay on one thread.
+enum
+{
+	BSPWorker_Main,
+	BSPWorker_Flats,
+	NumBSPWorkers
+};
+
+static RenderJobQueue jobQueues[NumBSPWorkers];	// One static set is sufficient here. This code will never be called recursively.
 
-void HWDrawInfo::WorkerThread()
+void HWDrawInfo::WorkerThread(int worker)
 {
 	sector_t *front, *back;
 	HWWallDispatcher disp(this);
+	auto &jobQueue = jobQueues[worker];
 
-	WTTotal.Clock();
+	if (worker == BSPWorker_Main) WTTotal.Clock();
 	isWorkerThread = true;	// for adding asserts in GL API code. The worker thread may never call any GL API.
+	isFlatWorkerThread = worker == BSPWorker_Flats;
 	while (true)
 	{
 		auto job = jobQueue.GetJob();
@@ -143,7 +155,9 @@ void HWDrawInfo::WorkerThread()
 		else switch (job->type)
 		{
 		case RenderJob::TerminateJob:
-			WTTotal.Unclock();
+			isWorkerThread = false;
+			isFlatWorkerThread = false;
+			if (worker == BSPWorker_Main) WTTotal.Unclock();
 			return;
 
 		case RenderJob::WallJob:
@@ -414,7 +428,7 @@ void HWDrawInfo::AddLine (seg_t *seg, bool portalclip)
 #endif
 			if (multithread)
 			{
-				jobQueue.AddJob(RenderJob::WallJob, seg->Subsector, seg);
+				jobQueues[BSPWorker_Main].AddJob(RenderJob::WallJob, seg->Subsector, seg);
 			}
 			else
 			{
@@ -699,7 +713,7 @@ void HWDrawInfo::RenderParticles(subsector_t *sub, sector_t *front)
 		
 		sp->spr->ProcessParticle(this, &sp->PT, front);
 	}
-	for (int i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
+	for (uint32_t i = Level->ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Level->Particles[i].snext)
 	{
 		if (mClipPortal)
 		{
@@ -778,7 +792,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 	{
 		if (multithread)
 		{
-			jobQueue.AddJob(RenderJob::ParticleJob, sub, nullptr);
+			jobQueues[BSPWorker_Main].AddJob(RenderJob::ParticleJob, sub, nullptr);
 		}
 		else
 		{
@@ -804,7 +818,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 		{
 			if (multithread)
 			{
-				jobQueue.AddJob(RenderJob::SpriteJob, sub, nullptr);
+				jobQueues[BSPWorker_Main].AddJob(RenderJob::SpriteJob, sub, nullptr);
 			}
 			else
 			{
@@ -855,7 +869,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 #endif
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::FlatJob, sub);
+						jobQueues[BSPWorker_Flats].AddJob(RenderJob::FlatJob, sub);
 					}
 					else
 					{
@@ -887,7 +901,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 				{
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
+						jobQueues[BSPWorker_Main].AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
 					}
 					else
 					{
@@ -900,7 +914,7 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 				{
 					if (multithread)
 					{
-						jobQueue.AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
+						jobQueues[BSPWorker_Main].AddJob(RenderJob::PortalJob, sub, (seg_t *)portal);
 					}
 					else
 					{
@@ -1155,10 +1169,15 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 	multithread = gl_multithread;
 	if (multithread)
 	{
-		jobQueue.ReleaseAll();
-		auto future = renderPool.push([&](int id) {
-			WorkerThread();
-		});
+		// If no worker picks these up before the traversal is done, the wait below runs them on this thread.
+		FTaskGroup workers;
+		for (int i = 0; i < NumBSPWorkers; i++)
+		{
+			jobQueues[i].ReleaseAll();
+			workers.Run([this, i]() {
+				WorkerThread(i);
+			});
+		}
 #if !HAVE_RT
 		RenderBSPNode(node);
 #else
@@ -1174,11 +1193,20 @@ void HWDrawInfo::RenderBSP(void *node, bool drawpsprites)
 		}
 #endif
 
-		jobQueue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		for (auto &queue : jobQueues)
+		{
+			queue.AddJob(RenderJob::TerminateJob, nullptr, nullptr);
+		}
 		Bsp.Unclock();
 		MTWait.Clock();
-		future.wait();
+		workers.Wait();
 		MTWait.Unclock();
+
+		// Always append in the same place so that the lists do not depend on thread timing.
+		for (int i = 0; i < GLDL_TYPES; i++)
+		{
+			drawlists[i].Append(flatdrawlists[i]);
+		}
 	}
 	else
 	{
@@ -172,7 +172,12 @@ void HWDrawInfo::StartScene(FRenderViewpoint &parentvp, HWViewpointUniforms *uni
 
 	ClearBuffers();
 
-	for (int i = 0; i < GLDL_TYPES; i++) drawlists[i].Reset();
+	for (int i = 0; i < GLDL_TYPES; i++)
+	{
+		drawlists[i].Reset();
+		flatdrawlists[i].Reset();
+		flatdrawlists[i].Allocator = &FlatDataAllocator;
+	}
 	hudsprites.Clear();
 //	Coronas.Clear();
 	vpIndex = 0;
@@ -135,6 +135,7 @@ struct HWDrawInfo
 	bool isStealthVision() const { return !!(FullbrightFlags & StealthVision); }
     
 	HWDrawList drawlists[GLDL_TYPES];
+	HWDrawList flatdrawlists[GLDL_TYPES];	// filled by the flat worker, appended to drawlists when the BSP is done.
 	int vpIndex;
 	ELightMode lightmode;
 
@@ -191,7 +192,7 @@ private:
 	subsector_t *currentsubsector;	// used by the line processing code.
 	sector_t *currentsector;
 
-	void WorkerThread();
+	void WorkerThread(int worker);
 
 	void UnclipSubsector(subsector_t *sub);
 	
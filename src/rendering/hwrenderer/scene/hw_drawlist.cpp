@@ -40,10 +40,12 @@
 #include "hw_walldispatcher.h"
 
 FMemArena RenderDataAllocator(1024*1024);	// Use large blocks to reduce allocation time.
+FMemArena FlatDataAllocator(1024*1024);		// Used by the flat worker thread so that it does not need to synchronize with the main worker.
 
 void ResetRenderDataAllocator()
 {
 	RenderDataAllocator.FreeAll();
+	FlatDataAllocator.FreeAll();
 }
 
 //==========================================================================
@@ -763,7 +765,7 @@ void HWDrawList::SortFlats()
 
 HWWall *HWDrawList::NewWall()
 {
-	auto wall = (HWWall*)RenderDataAllocator.Alloc(sizeof(HWWall));
+	auto wall = (HWWall*)Allocator->Alloc(sizeof(HWWall));
 	drawitems.Push(HWDrawItem(DrawType_WALL, walls.Push(wall)));
 	return wall;
 }
@@ -775,7 +777,7 @@ HWWall *HWDrawList::NewWall()
 //==========================================================================
 HWFlat *HWDrawList::NewFlat()
 {
-	auto flat = (HWFlat*)RenderDataAllocator.Alloc(sizeof(HWFlat));
+	auto flat = (HWFlat*)Allocator->Alloc(sizeof(HWFlat));
 	drawitems.Push(HWDrawItem(DrawType_FLAT,flats.Push(flat)));
 	return flat;
 }
@@ -787,11 +789,37 @@ HWFlat *HWDrawList::NewFlat()
 //==========================================================================
 HWSprite *HWDrawList::NewSprite()
 {	
-	auto sprite = (HWSprite*)RenderDataAllocator.Alloc(sizeof(HWSprite));
+	auto sprite = (HWSprite*)Allocator->Alloc(sizeof(HWSprite));
 	drawitems.Push(HWDrawItem(DrawType_SPRITE, sprites.Push(sprite)));
 	return sprite;
 }
 
+//==========================================================================
+//
+// Moves all items of another list to the end of this one.
+// The items themselves stay where they were allocated.
+//
+//==========================================================================
+
+void HWDrawList::Append(HWDrawList &other)
+{
+	int wallbase = walls.Size();
+	int flatbase = flats.Size();
+	int spritebase = sprites.Size();
+
+	walls.Append(other.walls);
+	flats.Append(other.flats);
+	sprites.Append(other.sprites);
+
+	drawitems.Grow(other.drawitems.Size());
+	for (auto &item : other.drawitems)
+	{
+		int base = item.rendertype == DrawType_WALL ? wallbase : item.rendertype == DrawType_FLAT ? flatbase : spritebase;
+		drawitems.Push(HWDrawItem(item.rendertype, base + item.index));
+	}
+	other.Reset();
+}
+
 //==========================================================================
 //
 //
@@ -3,6 +3,7 @@
 #include "memarena.h"
 
 extern FMemArena RenderDataAllocator;
+extern FMemArena FlatDataAllocator;
 void ResetRenderDataAllocator();
 struct HWDrawInfo;
 class HWWall;
@@ -69,6 +70,7 @@ struct HWDrawList
     float SortZ;
 	SortNode * sorted;
 	bool reverseSort;
+	FMemArena *Allocator = &RenderDataAllocator;
 	
 public:
 	HWDrawList()
@@ -91,6 +93,7 @@ public:
 	HWWall *NewWall();
 	HWFlat *NewFlat();
 	HWSprite *NewSprite();
+	void Append(HWDrawList &other);
 	void Reset();
 	void SortWalls();
 	void SortFlats();
@@ -35,6 +35,8 @@
 
 EXTERN_CVAR(Bool, gl_seamless)
 
+extern thread_local bool isFlatWorkerThread;
+
 //==========================================================================
 //
 // 
@@ -160,7 +162,7 @@ void HWDrawInfo::AddFlat(HWFlat *flat, bool fog)
 		bool masked = flat->texture->isMasked() && ((flat->renderflags&SSRF_RENDER3DPLANES) || flat->stack);
 		list = masked ? GLDL_MASKEDFLATS : GLDL_PLAINFLATS;
 	}
-	auto newflat = drawlists[list].NewFlat();
+	auto newflat = (isFlatWorkerThread ? flatdrawlists : drawlists)[list].NewFlat();
 	*newflat = *flat;
 }
 
@@ -43,11 +43,15 @@
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "parallel_for.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Candidates times segs in the set before splitter scoring is spread over the worker threads.
+const unsigned ParallelScoreWork = 1 << 16;
+
 #if 0
 #define D(x) x
 #else
@@ -428,7 +432,7 @@ bool FNodeBuilder::ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uin
 		node.dx = -node.dx;
 		node.dy = -node.dy;
 	}
-	return Heuristic (node, set, false) > 0;
+	return Heuristic (node, set, false, Touched, Colinear) > 0;
 }
 
 // Splitters are chosen to coincide with segs in the given set. To reduce the
@@ -438,12 +442,17 @@ bool FNodeBuilder::ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uin
 // each unique plane needs to be considered as a splitter. A result of 0 means
 // this set is a convex region. A result of -1 means that there were possible
 // splitters, but they all split segs we want to keep intact.
+//
+// Scoring a candidate does not change any state, so for big sets all candidates
+// are scored in parallel. They are still compared in set order, so the choice is
+// the same as with serial scoring.
 int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit)
 {
 	int stepleft;
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int setsize;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -451,8 +460,10 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	seg = set;
 	stepleft = 0;
+	setsize = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+	SplitCandidates.Clear();
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
@@ -473,30 +484,60 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
+				SplitCandidates.Push (seg);
+			}
+		}
 
-				int value = Heuristic (node, set, nosplit);
+		seg = pseg->next;
+		setsize++;
+	}
 
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
+	SplitScores.Resize (SplitCandidates.Size());
+	if (SplitCandidates.Size() > 1 && setsize * SplitCandidates.Size() >= ParallelScoreWork)
+	{
+		parallel_for ((int)SplitCandidates.Size(), [&](int i)
+		{
+			node_t candidate;
+			TArray<int> touched, colinear;
 
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
-			}
+			SetNodeFromSeg (candidate, &Segs[SplitCandidates[i]]);
+			SplitScores[i] = Heuristic (candidate, set, nosplit, touched, colinear);
+		});
+	}
+	else
+	{
+		for (unsigned int i = 0; i < SplitCandidates.Size(); ++i)
+		{
+			SetNodeFromSeg (node, &Segs[SplitCandidates[i]]);
+			SplitScores[i] = Heuristic (node, set, nosplit, Touched, Colinear);
 		}
+	}
 
-		seg = pseg->next;
+	for (unsigned int i = 0; i < SplitCandidates.Size(); ++i)
+	{
+		int value = SplitScores[i];
+
+		seg = SplitCandidates[i];
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", seg, Segs[seg].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = seg;
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
 	}
 
 	if (bestseg == UINT_MAX)
 	{
+		// Leave the node as the last candidate, as scoring them one by one would.
+		if (SplitCandidates.Size() > 0)
+		{
+			SetNodeFromSeg (node, &Segs[SplitCandidates.Last()]);
+		}
 		// No lines split any others into two sets, so this is a convex region.
 		D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
 		return nosplitters ? -1 : 0;
@@ -515,7 +556,7 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -524,18 +565,33 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	int realSegs[2] = { 0, 0 };
 	int specialSegs[2] = { 0, 0 };
 	uint32_t i = set;
-	int sidev[2];
+	uint32_t batch[CLASSIFY_BATCH];
+	int sides[CLASSIFY_BATCH];
+	int sidevs[CLASSIFY_BATCH][2];
+	int batchsize = 0, batchpos = 0;
 	int side;
 	bool splitter = false;
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != UINT_MAX)
 	{
+		if (batchpos == batchsize)
+		{ // Classify the next run of segs in one go.
+			batchsize = 0;
+			for (uint32_t j = i; j != UINT_MAX && batchsize < CLASSIFY_BATCH; j = Segs[j].next)
+			{
+				batch[batchsize++] = j;
+			}
+			ClassifyLines (node, batch, batchsize, sides, sidevs);
+			batchpos = 0;
+		}
+
 		const FPrivSeg *test = &Segs[i];
+		const int *sidev = sidevs[batchpos];
 
 		if (HackSeg == i)
 		{
@@ -543,8 +599,9 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 		}
 		else
 		{
-			side = ClassifyLine (node, &Vertices[test->v1], &Vertices[test->v2], sidev);
+			side = sides[batchpos];
 		}
+		batchpos++;
 		switch (side)
 		{
 		case 0:	// Seg is on only one side of the partition
@@ -557,32 +614,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -699,8 +756,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -713,10 +770,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
@@ -267,6 +267,8 @@ private:
 
 	TArray<int> Touched;	// Loops a splitter touches on a vertex
 	TArray<int> Colinear;	// Loops with edges colinear to a splitter
+	TArray<uint32_t> SplitCandidates;	// Segs SelectSplitter wants scored
+	TArray<int> SplitScores;
 	FEventTree Events;		// Vertices intersected by the current splitter
 
 	TArray<uint32_t> UnsetSegs;			// Segs with no definitive side in current splitter
@@ -300,7 +302,7 @@ private:
 	void DoGLSegSplit (uint32_t set, node_t &node, uint32_t splitseg, uint32_t &outset0, uint32_t &outset1, int side, int sidev0, int sidev1, bool hack);
 	void SplitSegs (uint32_t set, node_t &node, uint32_t splitseg, uint32_t &outset0, uint32_t &outset1, unsigned int &count0, unsigned int &count1);
 	uint32_t SplitSeg (uint32_t segnum, int splitvert, int v1InFront);
-	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit);
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear);
 
 	// Returns:
 	//	0 = seg is in front
@@ -308,6 +310,12 @@ private:
 	// -1 = seg cuts the node
 
 	int ClassifyLine (node_t &node, const FPrivVert *v1, const FPrivVert *v2, int sidev[2]);
+	inline int ClassifySides (const node_t &node, const FPrivVert *v1, const FPrivVert *v2, double s_num1, double s_num2, int sidev[2]);
+
+	// Classifies count segs against the same splitter, with the same results ClassifyLine
+	// would give for each of them. Uses the AVX2 kernel if the CPU supports it.
+	void ClassifyLines (node_t &node, const uint32_t *segs, int count, int *sides, int (*sidevs)[2]);
+	void ClassifyLinesAVX2 (node_t &node, const uint32_t *segs, int count, int *sides, int (*sidevs)[2]);
 
 	void FixSplitSharers (const node_t &node);
 	double AddIntersection (const node_t &node, int vertex);
@@ -337,9 +345,14 @@ private:
 // Units are in fixed_ts.
 const double SIDE_EPSILON = 6.5536;
 
+#define FAR_ENOUGH 17179869184.f		// 4<<32
+
 // Vertices within this distance of each other will be considered as the same vertex.
 #define VERTEX_EPSILON	6		// This is a fixed_t value
 
+// Segs are classified in runs of this many by Heuristic.
+enum { CLASSIFY_BATCH = 64 };
+
 inline int FNodeBuilder::PointOnSide (int x, int y, int x1, int y1, int dx, int dy)
 {
 	// For most cases, a simple dot product is enough.
@@ -366,3 +379,128 @@ inline int FNodeBuilder::PointOnSide (int x, int y, int x1, int y1, int dx, int
 	}
 	return s_num > 0.0 ? -1 : 1;
 }
+
+// Decides which side of the splitter a seg is on, given the (unnormalized)
+// distances of its vertices from it.
+
+inline int FNodeBuilder::ClassifySides (const node_t &node, const FPrivVert *v1, const FPrivVert *v2, double s_num1, double s_num2, int sidev[2])
+{
+	double d_dx = double(node.dx);
+	double d_dy = double(node.dy);
+	int nears = 0;
+
+	if (s_num1 <= -FAR_ENOUGH)
+	{
+		if (s_num2 <= -FAR_ENOUGH)
+		{
+			sidev[0] = sidev[1] = 1;
+			return 1;
+		}
+		if (s_num2 >= FAR_ENOUGH)
+		{
+			sidev[0] = 1;
+			sidev[1] = -1;
+			return -1;
+		}
+		nears = 1;
+	}
+	else if (s_num1 >= FAR_ENOUGH)
+	{
+		if (s_num2 >= FAR_ENOUGH)
+		{
+			sidev[0] = sidev[1] = -1;
+			return 0;
+		}
+		if (s_num2 <= -FAR_ENOUGH)
+		{
+			sidev[0] = -1;
+			sidev[1] = 1;
+			return -1;
+		}
+		nears = 1;
+	}
+	else
+	{
+		nears = 2 | int(fabs(s_num2) < FAR_ENOUGH);
+	}
+
+	if (nears)
+	{
+		double l = 1.f / (d_dx*d_dx + d_dy*d_dy);
+		if (nears & 2)
+		{
+			double dist = s_num1 * s_num1 * l;
+			if (dist < SIDE_EPSILON*SIDE_EPSILON)
+			{
+				sidev[0] = 0;
+			}
+			else
+			{
+				sidev[0] = s_num1 > 0.0 ? -1 : 1;
+			}
+		}
+		else
+		{
+			sidev[0] = s_num1 > 0.0 ? -1 : 1;
+		}
+		if (nears & 1)
+		{
+			double dist = s_num2 * s_num2 * l;
+			if (dist < SIDE_EPSILON*SIDE_EPSILON)
+			{
+				sidev[1] = 0;
+			}
+			else
+			{
+				sidev[1] = s_num2 > 0.0 ? -1 : 1;
+			}
+		}
+		else
+		{
+			sidev[1] = s_num2 > 0.0 ? -1 : 1;
+		}
+	}
+	else
+	{
+		sidev[0] = s_num1 > 0.0 ? -1 : 1;
+		sidev[1] = s_num2 > 0.0 ? -1 : 1;
+	}
+
+	if ((sidev[0] | sidev[1]) == 0)
+	{ // seg is coplanar with the splitter, so use its orientation to determine
+	  // which child it ends up in. If it faces the same direction as the splitter,
+	  // it goes in front. Otherwise, it goes in back.
+
+		if (node.dx != 0)
+		{
+			if ((node.dx > 0 && v2->x > v1->x) || (node.dx < 0 && v2->x < v1->x))
+			{
+				return 0;
+			}
+			else
+			{
+				return 1;
+			}
+		}
+		else
+		{
+			if ((node.dy > 0 && v2->y > v1->y) || (node.dy < 0 && v2->y < v1->y))
+			{
+				return 0;
+			}
+			else
+			{
+				return 1;
+			}
+		}
+	}
+	else if (sidev[0] <= 0 && sidev[1] <= 0)
+	{
+		return 0;
+	}
+	else if (sidev[0] >= 0 && sidev[1] >= 0)
+	{
+		return 1;
+	}
+	return -1;
+}
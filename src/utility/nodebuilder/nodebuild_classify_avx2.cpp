@@ -0,0 +1,63 @@
+#include "doomtype.h"
+#include "nodebuild.h"
+
+#if defined(_M_X64) || defined(__amd64__)
+
+#include <immintrin.h>
+
+// Only the kernel itself is compiled for AVX2 so that nothing else in this file,
+// including inline functions from the headers, can end up using it on CPUs without it.
+#ifdef __GNUC__
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+// Computes the same products in the same order as ClassifyLine, so the distances,
+// and with them the classification, are identical to the scalar version's.
+
+AVX2_TARGET void FNodeBuilder::ClassifyLinesAVX2 (node_t &node, const uint32_t *segs, int count, int *sides, int (*sidevs)[2])
+{
+	const __m256d d_x1 = _mm256_set1_pd(double(node.x));
+	const __m256d d_y1 = _mm256_set1_pd(double(node.y));
+	const __m256d d_dx = _mm256_set1_pd(double(node.dx));
+	const __m256d d_dy = _mm256_set1_pd(double(node.dy));
+	alignas(32) double s_num1[4];
+	alignas(32) double s_num2[4];
+	const FPrivVert *v1[4];
+	const FPrivVert *v2[4];
+	int i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			const FPrivSeg *seg = &Segs[segs[i + j]];
+			v1[j] = &Vertices[seg->v1];
+			v2[j] = &Vertices[seg->v2];
+		}
+		__m256d d_xv1 = _mm256_cvtepi32_pd(_mm_setr_epi32(v1[0]->x, v1[1]->x, v1[2]->x, v1[3]->x));
+		__m256d d_yv1 = _mm256_cvtepi32_pd(_mm_setr_epi32(v1[0]->y, v1[1]->y, v1[2]->y, v1[3]->y));
+		__m256d d_xv2 = _mm256_cvtepi32_pd(_mm_setr_epi32(v2[0]->x, v2[1]->x, v2[2]->x, v2[3]->x));
+		__m256d d_yv2 = _mm256_cvtepi32_pd(_mm_setr_epi32(v2[0]->y, v2[1]->y, v2[2]->y, v2[3]->y));
+
+		_mm256_store_pd(s_num1, _mm256_sub_pd(
+			_mm256_mul_pd(_mm256_sub_pd(d_y1, d_yv1), d_dx),
+			_mm256_mul_pd(_mm256_sub_pd(d_x1, d_xv1), d_dy)));
+		_mm256_store_pd(s_num2, _mm256_sub_pd(
+			_mm256_mul_pd(_mm256_sub_pd(d_y1, d_yv2), d_dx),
+			_mm256_mul_pd(_mm256_sub_pd(d_x1, d_xv2), d_dy)));
+
+		for (int j = 0; j < 4; ++j)
+		{
+			sides[i + j] = ClassifySides (node, v1[j], v2[j], s_num1[j], s_num2[j], sidevs[i + j]);
+		}
+	}
+	for (; i < count; ++i)
+	{
+		const FPrivSeg *seg = &Segs[segs[i]];
+		sides[i] = ClassifyLine (node, &Vertices[seg->v1], &Vertices[seg->v2], sidevs[i]);
+	}
+}
+
+#endif
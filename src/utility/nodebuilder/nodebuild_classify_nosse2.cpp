@@ -1,7 +1,6 @@
 #include "doomtype.h"
 #include "nodebuild.h"
-
-#define FAR_ENOUGH 17179869184.f		// 4<<32
+#include "x86.h"
 
 int FNodeBuilder::ClassifyLine(node_t &node, const FPrivVert *v1, const FPrivVert *v2, int sidev[2])
 {
@@ -17,120 +16,21 @@ int FNodeBuilder::ClassifyLine(node_t &node, const FPrivVert *v1, const FPrivVer
 	double s_num1 = (d_y1 - d_yv1) * d_dx - (d_x1 - d_xv1) * d_dy;
 	double s_num2 = (d_y1 - d_yv2) * d_dx - (d_x1 - d_xv2) * d_dy;
 
-	int nears = 0;
-
-	if (s_num1 <= -FAR_ENOUGH)
-	{
-		if (s_num2 <= -FAR_ENOUGH)
-		{
-			sidev[0] = sidev[1] = 1;
-			return 1;
-		}
-		if (s_num2 >= FAR_ENOUGH)
-		{
-			sidev[0] = 1;
-			sidev[1] = -1;
-			return -1;
-		}
-		nears = 1;
-	}
-	else if (s_num1 >= FAR_ENOUGH)
-	{
-		if (s_num2 >= FAR_ENOUGH)
-		{
-			sidev[0] = sidev[1] = -1;
-			return 0;
-		}
-		if (s_num2 <= -FAR_ENOUGH)
-		{
-			sidev[0] = -1;
-			sidev[1] = 1;
-			return -1;
-		}
-		nears = 1;
-	}
-	else
-	{
-		nears = 2 | int(fabs(s_num2) < FAR_ENOUGH);
-	}
-
-	if (nears)
-	{
-		double l = 1.f / (d_dx*d_dx + d_dy*d_dy);
-		if (nears & 2)
-		{
-			double dist = s_num1 * s_num1 * l;
-			if (dist < SIDE_EPSILON*SIDE_EPSILON)
-			{
-				sidev[0] = 0;
-			}
-			else
-			{
-				sidev[0] = s_num1 > 0.0 ? -1 : 1;
-			}
-		}
-		else
-		{
-			sidev[0] = s_num1 > 0.0 ? -1 : 1;
-		}
-		if (nears & 1)
-		{
-			double dist = s_num2 * s_num2 * l;
-			if (dist < SIDE_EPSILON*SIDE_EPSILON)
-			{
-				sidev[1] = 0;
-			}
-			else
-			{
-				sidev[1] = s_num2 > 0.0 ? -1 : 1;
-			}
-		}
-		else
-		{
-			sidev[1] = s_num2 > 0.0 ? -1 : 1;
-		}
-	}
-	else
-	{
-		sidev[0] = s_num1 > 0.0 ? -1 : 1;
-		sidev[1] = s_num2 > 0.0 ? -1 : 1;
-	}
-
-	if ((sidev[0] | sidev[1]) == 0)
-	{ // seg is coplanar with the splitter, so use its orientation to determine
-	  // which child it ends up in. If it faces the same direction as the splitter,
-	  // it goes in front. Otherwise, it goes in back.
+	return ClassifySides (node, v1, v2, s_num1, s_num2, sidev);
+}
 
-		if (node.dx != 0)
-		{
-			if ((node.dx > 0 && v2->x > v1->x) || (node.dx < 0 && v2->x < v1->x))
-			{
-				return 0;
-			}
-			else
-			{
-				return 1;
-			}
-		}
-		else
-		{
-			if ((node.dy > 0 && v2->y > v1->y) || (node.dy < 0 && v2->y < v1->y))
-			{
-				return 0;
-			}
-			else
-			{
-				return 1;
-			}
-		}
-	}
-	else if (sidev[0] <= 0 && sidev[1] <= 0)
+void FNodeBuilder::ClassifyLines (node_t &node, const uint32_t *segs, int count, int *sides, int (*sidevs)[2])
+{
+#if defined(_M_X64) || defined(__amd64__)
+	if (CPU.bAVX2)
 	{
-		return 0;
+		ClassifyLinesAVX2 (node, segs, count, sides, sidevs);
+		return;
 	}
-	else if (sidev[0] >= 0 && sidev[1] >= 0)
+#endif
+	for (int i = 0; i < count; ++i)
 	{
-		return 1;
+		const FPrivSeg *seg = &Segs[segs[i]];
+		sides[i] = ClassifyLine (node, &Vertices[seg->v1], &Vertices[seg->v2], sidevs[i]);
 	}
-	return -1;
 }